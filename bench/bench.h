@@ -0,0 +1,23 @@
+/*
+ * tiny helpers shared by the benchmarks in this directory, these aren't
+ * part of the framework and only need a C compiler (and kazmath)
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+static inline double benchNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// stops the optimiser throwing away a result nobody reads
+static volatile float benchSink;
+
+static inline void benchReport(const char *name, double seconds, int iterations)
+{
+    printf("%-40s %10.3f ms %12.1f ns/iter\n", name, seconds * 1e3,
+           seconds * 1e9 / iterations);
+}
@@ -0,0 +1,217 @@
+/*
+ * kmBVH over 100,000 boxes scattered through a 1000 unit cube, ray casts,
+ * overlap and nearest queries against testing every box, before and after
+ * the boxes move and the BVH is refitted.  Exits with 1 if the BVH ever
+ * gives a different answer
+ *
+ * BOXES and QUERIES can be changed with -D
+ */
+
+#include <stdlib.h>
+#include <float.h>
+#include <kazmath.h>
+#include "bench.h"
+
+#ifndef BOXES
+#define BOXES 100000
+#endif
+#ifndef QUERIES
+#define QUERIES 1000
+#endif
+
+kmAABB boxes[BOXES];
+kmVec3 velocities[BOXES];
+kmRay3 rays[QUERIES];
+kmAABB regions[QUERIES];
+kmVec3 points[QUERIES];
+kmScalar bruteResults[QUERIES], bvhResults[QUERIES];
+int found[BOXES];
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+static void randomVec3(kmVec3 *v, float min, float max)
+{
+    kmVec3Fill(v, randomRange(min, max), randomRange(min, max), randomRange(min, max));
+}
+
+// the same slab test as the BVH so the distances match exactly
+static int rayBox(const kmAABB *box, const kmVec3 *start, const kmVec3 *inv, kmScalar tMax, kmScalar *pT)
+{
+    kmScalar t1 = (box->min.x - start->x) * inv->x, t2 = (box->max.x - start->x) * inv->x;
+    kmScalar tNear = t1 < t2 ? t1 : t2, tFar = t1 < t2 ? t2 : t1;
+
+    t1 = (box->min.y - start->y) * inv->y;
+    t2 = (box->max.y - start->y) * inv->y;
+    if ((t1 < t2 ? t1 : t2) > tNear) tNear = t1 < t2 ? t1 : t2;
+    if ((t1 < t2 ? t2 : t1) < tFar) tFar = t1 < t2 ? t2 : t1;
+
+    t1 = (box->min.z - start->z) * inv->z;
+    t2 = (box->max.z - start->z) * inv->z;
+    if ((t1 < t2 ? t1 : t2) > tNear) tNear = t1 < t2 ? t1 : t2;
+    if ((t1 < t2 ? t2 : t1) < tFar) tFar = t1 < t2 ? t2 : t1;
+
+    if (tNear < 0) tNear = 0;
+    if (tFar > tMax) tFar = tMax;
+    *pT = tNear;
+    return tNear <= tFar;
+}
+
+static void bruteRays()
+{
+    for (int q = 0; q < QUERIES; q++) {
+        kmVec3 inv;
+        kmScalar best = FLT_MAX, t;
+        kmVec3Fill(&inv, 1 / rays[q].dir.x, 1 / rays[q].dir.y, 1 / rays[q].dir.z);
+        for (int i = 0; i < BOXES; i++)
+            if (rayBox(&boxes[i], &rays[q].start, &inv, best, &t) && t < best) best = t;
+        bruteResults[q] = best;
+    }
+}
+
+static void bvhRays(kmBVH *bvh)
+{
+    for (int q = 0; q < QUERIES; q++) {
+        kmScalar t = FLT_MAX;
+        kmBVHRayCast(bvh, &rays[q], NULL, NULL, &t);
+        bvhResults[q] = t;
+    }
+}
+
+static int overlaps(const kmAABB *a, const kmAABB *b)
+{
+    return a->min.x <= b->max.x && a->max.x >= b->min.x &&
+           a->min.y <= b->max.y && a->max.y >= b->min.y &&
+           a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+static void bruteOverlaps()
+{
+    for (int q = 0; q < QUERIES; q++) {
+        int n = 0;
+        for (int i = 0; i < BOXES; i++) n += overlaps(&boxes[i], &regions[q]);
+        bruteResults[q] = n;
+    }
+}
+
+static void bvhOverlaps(kmBVH *bvh)
+{
+    for (int q = 0; q < QUERIES; q++)
+        bvhResults[q] = kmBVHOverlap(bvh, &regions[q], found, BOXES);
+}
+
+static kmScalar distanceSq(const kmAABB *box, const kmVec3 *p)
+{
+    kmScalar dx = p->x < box->min.x ? box->min.x - p->x : p->x > box->max.x ? p->x - box->max.x : 0;
+    kmScalar dy = p->y < box->min.y ? box->min.y - p->y : p->y > box->max.y ? p->y - box->max.y : 0;
+    kmScalar dz = p->z < box->min.z ? box->min.z - p->z : p->z > box->max.z ? p->z - box->max.z : 0;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+static void bruteNearest()
+{
+    for (int q = 0; q < QUERIES; q++) {
+        kmScalar best = FLT_MAX;
+        for (int i = 0; i < BOXES; i++) {
+            kmScalar d = distanceSq(&boxes[i], &points[q]);
+            if (d < best) best = d;
+        }
+        bruteResults[q] = best;
+    }
+}
+
+static void bvhNearest(kmBVH *bvh)
+{
+    for (int q = 0; q < QUERIES; q++)
+        kmBVHNearest(bvh, &points[q], &bvhResults[q]);
+}
+
+static int compare(const char *name)
+{
+    int wrong = 0;
+    for (int q = 0; q < QUERIES; q++)
+        if (bruteResults[q] != bvhResults[q]) wrong++;
+    if (wrong) printf("%s: %i of %i queries differ\n", name, wrong, QUERIES);
+    return wrong;
+}
+
+static int queries(kmBVH *bvh)
+{
+    int wrong = 0;
+    double start;
+
+#define TIME(name, code) \
+    start = benchNow(); \
+    code; \
+    benchReport(name, benchNow() - start, QUERIES);
+
+    TIME("  ray cast, every box", bruteRays())
+    TIME("  kmBVHRayCast", bvhRays(bvh))
+    wrong += compare("ray cast");
+    TIME("  overlap, every box", bruteOverlaps())
+    TIME("  kmBVHOverlap", bvhOverlaps(bvh))
+    wrong += compare("overlap");
+    TIME("  nearest, every box", bruteNearest())
+    TIME("  kmBVHNearest", bvhNearest(bvh))
+    wrong += compare("nearest");
+    return wrong;
+}
+
+int main()
+{
+    kmBVH bvh;
+    int wrong = 0;
+    double start;
+
+    srand(1);
+    for (int i = 0; i < BOXES; i++) {
+        kmVec3 centre;
+        randomVec3(&centre, 0, 1000);
+        kmAABBInitialize(&boxes[i], &centre, randomRange(.5, 5), randomRange(.5, 5), randomRange(.5, 5));
+        randomVec3(&velocities[i], -1, 1);
+    }
+    for (int q = 0; q < QUERIES; q++) {
+        kmVec3 start, dir;
+        randomVec3(&start, 0, 1000);
+        randomVec3(&dir, -1, 1);
+        kmVec3Normalize(&dir, &dir);
+        kmRay3FromPointAndDirection(&rays[q], &start, &dir);
+        randomVec3(&start, 0, 1000);
+        kmAABBInitialize(&regions[q], &start, 20, 20, 20);
+        randomVec3(&points[q], -100, 1100);
+    }
+
+    start = benchNow();
+    kmBVHBuild(&bvh, boxes, BOXES);
+    benchReport("kmBVHBuild", benchNow() - start, BOXES);
+    printf("%u nodes\n\n", bvh.numNodes);
+    wrong += queries(&bvh);
+
+    // everything moves for a second at 60fps, refitting each frame
+    double refit = 0;
+    for (int frame = 0; frame < 60; frame++) {
+        for (int i = 0; i < BOXES; i++) {
+            kmVec3Add(&boxes[i].min, &boxes[i].min, &velocities[i]);
+            kmVec3Add(&boxes[i].max, &boxes[i].max, &velocities[i]);
+        }
+        start = benchNow();
+        kmBVHRefit(&bvh, boxes);
+        refit += benchNow() - start;
+    }
+    printf("\n");
+    benchReport("kmBVHRefit", refit, 60 * BOXES);
+    printf("after moving up to 60 units and refitting\n");
+    wrong += queries(&bvh);
+    kmBVHFree(&bvh);
+
+    start = benchNow();
+    kmBVHBuild(&bvh, boxes, BOXES);
+    printf("\n");
+    benchReport("kmBVHBuild again", benchNow() - start, BOXES);
+    wrong += queries(&bvh);
+    kmBVHFree(&bvh);
+
+    return wrong != 0;
+}
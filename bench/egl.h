@@ -0,0 +1,42 @@
+/*
+ * a headless GLES2 context for benchmarks that need GL but no window,
+ * on mesa EGL_PLATFORM=surfaceless works without any display
+ */
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <stdlib.h>
+
+static inline int benchGlContext(int w, int h)
+{
+    EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_DEPTH_SIZE, 16,
+        EGL_NONE
+    };
+    EGLint surfaceAttribs[] = { EGL_WIDTH, w, EGL_HEIGHT, h, EGL_NONE };
+    EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    EGLConfig config;
+    EGLint major, minor, n;
+
+    setenv("EGL_PLATFORM", "surfaceless", 0);
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (!eglInitialize(display, &major, &minor)) {
+        printf("can't initialise EGL\n");
+        return 0;
+    }
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &n) || n < 1) {
+        printf("no pbuffer GLES2 config\n");
+        return 0;
+    }
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    eglBindAPI(EGL_OPENGL_ES_API);
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        printf("can't make the GLES2 context current\n");
+        return 0;
+    }
+    printf("GL renderer %s\n\n", glGetString(GL_RENDERER));
+    return 1;
+}
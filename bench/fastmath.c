@@ -0,0 +1,170 @@
+/*
+ * kazmath built with KAZMATH_FAST_MATH against libm, the largest error of
+ * kmSinCos and kmRsqrt and the time per call of them and of the rotation
+ * and normalize functions that use them, compared with the same functions
+ * written with sinf, cosf and sqrtf (as kazmath is without the option).
+ * Exits with 1 if any error is more than fastmath.h says
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <kazmath.h>
+#include "bench.h"
+
+#define VALUES 4096
+#define REPEATS 2000
+#define CHECKS 1000000
+
+float angles[VALUES], lengths[VALUES];
+kmVec3 vectors[VALUES];
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+// the references aren't inlined so they cost a call like kazmath's functions
+#define REFERENCE __attribute__((noinline)) static
+
+REFERENCE void libmSinCos(kmScalar radians, kmScalar *pSin, kmScalar *pCos)
+{
+    *pSin = sinf(radians);
+    *pCos = cosf(radians);
+}
+
+REFERENCE kmScalar libmRsqrt(kmScalar x)
+{
+    return 1.0f / sqrtf(x);
+}
+
+REFERENCE kmMat4 *libmRotationZ(kmMat4 *pOut, kmScalar radians)
+{
+    kmMat4Identity(pOut);
+    pOut->mat[0] = cosf(radians);
+    pOut->mat[1] = sinf(radians);
+    pOut->mat[4] = -sinf(radians);
+    pOut->mat[5] = cosf(radians);
+    return pOut;
+}
+
+static kmMat4 *libmRotationX(kmMat4 *pOut, kmScalar radians)
+{
+    kmMat4Identity(pOut);
+    pOut->mat[5] = cosf(radians);
+    pOut->mat[6] = sinf(radians);
+    pOut->mat[9] = -sinf(radians);
+    pOut->mat[10] = cosf(radians);
+    return pOut;
+}
+
+static kmMat4 *libmRotationY(kmMat4 *pOut, kmScalar radians)
+{
+    kmMat4Identity(pOut);
+    pOut->mat[0] = cosf(radians);
+    pOut->mat[2] = -sinf(radians);
+    pOut->mat[8] = sinf(radians);
+    pOut->mat[10] = cosf(radians);
+    return pOut;
+}
+
+// how kmMat4RotationYawPitchRoll used to be done
+REFERENCE kmMat4 *libmYawPitchRoll(kmMat4 *pOut, kmScalar pitch, kmScalar yaw, kmScalar roll)
+{
+    kmMat4 y, p, r;
+    libmRotationY(&y, yaw);
+    libmRotationX(&p, pitch);
+    libmRotationZ(&r, roll);
+    kmMat4Multiply(pOut, &p, &r);
+    return kmMat4Multiply(pOut, &y, pOut);
+}
+
+REFERENCE kmVec3 *libmNormalize(kmVec3 *pOut, const kmVec3 *pIn)
+{
+    if (!pIn->x && !pIn->y && !pIn->z) return kmVec3Assign(pOut, pIn);
+    kmScalar l = 1.0f / sqrtf(pIn->x * pIn->x + pIn->y * pIn->y + pIn->z * pIn->z);
+    return kmVec3Fill(pOut, pIn->x * l, pIn->y * l, pIn->z * l);
+}
+
+static int errors()
+{
+    double sinCos = 0, rsqrt = 0, rotation = 0;
+
+    for (int i = 0; i < CHECKS; i++) {
+        kmScalar a = randomRange(-1000, 1000), s, c;
+        kmSinCos(a, &s, &c);
+        double e = fmax(fabs(s - sin(a)), fabs(c - cos(a)));
+        if (e > sinCos) sinCos = e;
+
+        // every binade from 1e-6 to 1e6
+        kmScalar x = expf(randomRange(-14, 14)) * randomRange(1, 2);
+        e = fabs(kmRsqrt(x) * sqrt(x) - 1);
+        if (e > rsqrt) rsqrt = e;
+    }
+
+    for (int i = 0; i < CHECKS / 100; i++) {
+        kmMat4 fast, libm;
+        kmScalar p = randomRange(-7, 7), y = randomRange(-7, 7), r = randomRange(-7, 7);
+        kmMat4RotationYawPitchRoll(&fast, p, y, r);
+        libmYawPitchRoll(&libm, p, y, r);
+        for (int j = 0; j < 16; j++) {
+            double e = fabs(fast.mat[j] - libm.mat[j]);
+            if (e > rotation) rotation = e;
+        }
+    }
+
+    // past the polynomial's range (the quadrant overflows an int by 3.4e9)
+    double huge = 0;
+    const kmScalar big[] = { 1e5f + 1, -1e7f, 4e9f, -1e20f };
+    for (int i = 0; i < 4; i++) {
+        kmScalar s, c;
+        kmSinCos(big[i], &s, &c);
+        huge = fmax(huge, fmax(fabs(s - sin(big[i])), fabs(c - cos(big[i]))));
+    }
+
+    printf("largest errors over %i random values\n", CHECKS);
+    printf("  kmSinCos, -1000 to 1000 radians        %.3g\n", sinCos);
+    printf("  kmSinCos, 1e5 to 1e20 radians          %.3g\n", huge);
+    printf("  kmRsqrt (relative), 1e-6 to 1e6        %.3g\n", rsqrt);
+    printf("  kmMat4RotationYawPitchRoll             %.3g\n\n", rotation);
+    return sinCos > 2e-7 || huge > 2e-7 || rsqrt > 5e-6 || rotation > 1e-6;
+}
+
+int main()
+{
+    double start;
+    float sum = 0;
+    kmMat4 m;
+    kmVec3 v;
+    long calls = (long)VALUES * REPEATS;
+
+    srand(1);
+    for (int i = 0; i < VALUES; i++) {
+        angles[i] = randomRange(-10, 10);
+        lengths[i] = randomRange(0.01, 100);
+        kmVec3Fill(&vectors[i], randomRange(-10, 10), randomRange(-10, 10), randomRange(-10, 10));
+    }
+    int failed = errors();
+
+#define TIME(name, code) \
+    start = benchNow(); \
+    for (int r = 0; r < REPEATS; r++) \
+        for (int i = 0; i < VALUES; i++) { code; } \
+    benchReport(name, benchNow() - start, calls); \
+    benchSink = sum;
+
+    TIME("sinf and cosf", kmScalar s; kmScalar c; libmSinCos(angles[i], &s, &c); sum += s + c)
+    TIME("kmSinCos", kmScalar s; kmScalar c; kmSinCos(angles[i], &s, &c); sum += s + c)
+    TIME("1 / sqrtf", sum += libmRsqrt(lengths[i]))
+    TIME("kmRsqrt", sum += kmRsqrt(lengths[i]))
+    printf("\n");
+    TIME("kmMat4RotationZ, libm", libmRotationZ(&m, angles[i]); sum += m.mat[1])
+    TIME("kmMat4RotationZ", kmMat4RotationZ(&m, angles[i]); sum += m.mat[1])
+    TIME("kmMat4RotationYawPitchRoll, libm",
+         libmYawPitchRoll(&m, angles[i], angles[(i + 1) % VALUES], angles[(i + 2) % VALUES]); sum += m.mat[1])
+    TIME("kmMat4RotationYawPitchRoll",
+         kmMat4RotationYawPitchRoll(&m, angles[i], angles[(i + 1) % VALUES], angles[(i + 2) % VALUES]); sum += m.mat[1])
+    TIME("kmVec3Normalize, libm", libmNormalize(&v, &vectors[i]); sum += v.x)
+    TIME("kmVec3Normalize", kmVec3Normalize(&v, &vectors[i]); sum += v.x)
+
+    return failed;
+}
@@ -0,0 +1,325 @@
+/*
+ * kazmath built with KAZMATH_FLOAT_INTERNALS, kmMat4Inverse and
+ * kmMat4RotationQuaternion with float temporaries against copies of them
+ * with the double temporaries kazmath has without the option.  Both are
+ * compared with the same thing done entirely in double for the error and
+ * timed.  Exits with 1 if the float versions are much less precise
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <kazmath.h>
+#include "bench.h"
+
+#define MATRICES 4096
+#define REPEATS 500
+
+kmMat4 matrices[MATRICES], inverses[MATRICES];
+kmQuaternion quaternions[MATRICES];
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+// the references aren't inlined so they cost a call like kazmath's functions
+#define REFERENCE __attribute__((noinline)) static
+
+// kmMat4Inverse without the option
+REFERENCE kmMat4 *doubleInverse(kmMat4 *pOut, const kmMat4 *pM)
+{
+    kmMat4 tmp;
+    double det;
+    int i;
+
+    tmp.mat[0] = pM->mat[5]  * pM->mat[10] * pM->mat[15] -
+             pM->mat[5]  * pM->mat[11] * pM->mat[14] -
+             pM->mat[9]  * pM->mat[6]  * pM->mat[15] +
+             pM->mat[9]  * pM->mat[7]  * pM->mat[14] +
+             pM->mat[13] * pM->mat[6]  * pM->mat[11] -
+             pM->mat[13] * pM->mat[7]  * pM->mat[10];
+
+    tmp.mat[4] = -pM->mat[4]  * pM->mat[10] * pM->mat[15] +
+              pM->mat[4]  * pM->mat[11] * pM->mat[14] +
+              pM->mat[8]  * pM->mat[6]  * pM->mat[15] -
+              pM->mat[8]  * pM->mat[7]  * pM->mat[14] -
+              pM->mat[12] * pM->mat[6]  * pM->mat[11] +
+              pM->mat[12] * pM->mat[7]  * pM->mat[10];
+
+    tmp.mat[8] = pM->mat[4]  * pM->mat[9] * pM->mat[15] -
+             pM->mat[4]  * pM->mat[11] * pM->mat[13] -
+             pM->mat[8]  * pM->mat[5] * pM->mat[15] +
+             pM->mat[8]  * pM->mat[7] * pM->mat[13] +
+             pM->mat[12] * pM->mat[5] * pM->mat[11] -
+             pM->mat[12] * pM->mat[7] * pM->mat[9];
+
+    tmp.mat[12] = -pM->mat[4]  * pM->mat[9] * pM->mat[14] +
+               pM->mat[4]  * pM->mat[10] * pM->mat[13] +
+               pM->mat[8]  * pM->mat[5] * pM->mat[14] -
+               pM->mat[8]  * pM->mat[6] * pM->mat[13] -
+               pM->mat[12] * pM->mat[5] * pM->mat[10] +
+               pM->mat[12] * pM->mat[6] * pM->mat[9];
+
+    tmp.mat[1] = -pM->mat[1]  * pM->mat[10] * pM->mat[15] +
+              pM->mat[1]  * pM->mat[11] * pM->mat[14] +
+              pM->mat[9]  * pM->mat[2] * pM->mat[15] -
+              pM->mat[9]  * pM->mat[3] * pM->mat[14] -
+              pM->mat[13] * pM->mat[2] * pM->mat[11] +
+              pM->mat[13] * pM->mat[3] * pM->mat[10];
+
+    tmp.mat[5] = pM->mat[0]  * pM->mat[10] * pM->mat[15] -
+             pM->mat[0]  * pM->mat[11] * pM->mat[14] -
+             pM->mat[8]  * pM->mat[2] * pM->mat[15] +
+             pM->mat[8]  * pM->mat[3] * pM->mat[14] +
+             pM->mat[12] * pM->mat[2] * pM->mat[11] -
+             pM->mat[12] * pM->mat[3] * pM->mat[10];
+
+    tmp.mat[9] = -pM->mat[0]  * pM->mat[9] * pM->mat[15] +
+              pM->mat[0]  * pM->mat[11] * pM->mat[13] +
+              pM->mat[8]  * pM->mat[1] * pM->mat[15] -
+              pM->mat[8]  * pM->mat[3] * pM->mat[13] -
+              pM->mat[12] * pM->mat[1] * pM->mat[11] +
+              pM->mat[12] * pM->mat[3] * pM->mat[9];
+
+    tmp.mat[13] = pM->mat[0]  * pM->mat[9] * pM->mat[14] -
+              pM->mat[0]  * pM->mat[10] * pM->mat[13] -
+              pM->mat[8]  * pM->mat[1] * pM->mat[14] +
+              pM->mat[8]  * pM->mat[2] * pM->mat[13] +
+              pM->mat[12] * pM->mat[1] * pM->mat[10] -
+              pM->mat[12] * pM->mat[2] * pM->mat[9];
+
+    tmp.mat[2] = pM->mat[1]  * pM->mat[6] * pM->mat[15] -
+             pM->mat[1]  * pM->mat[7] * pM->mat[14] -
+             pM->mat[5]  * pM->mat[2] * pM->mat[15] +
+             pM->mat[5]  * pM->mat[3] * pM->mat[14] +
+             pM->mat[13] * pM->mat[2] * pM->mat[7] -
+             pM->mat[13] * pM->mat[3] * pM->mat[6];
+
+    tmp.mat[6] = -pM->mat[0]  * pM->mat[6] * pM->mat[15] +
+              pM->mat[0]  * pM->mat[7] * pM->mat[14] +
+              pM->mat[4]  * pM->mat[2] * pM->mat[15] -
+              pM->mat[4]  * pM->mat[3] * pM->mat[14] -
+              pM->mat[12] * pM->mat[2] * pM->mat[7] +
+              pM->mat[12] * pM->mat[3] * pM->mat[6];
+
+    tmp.mat[10] = pM->mat[0]  * pM->mat[5] * pM->mat[15] -
+              pM->mat[0]  * pM->mat[7] * pM->mat[13] -
+              pM->mat[4]  * pM->mat[1] * pM->mat[15] +
+              pM->mat[4]  * pM->mat[3] * pM->mat[13] +
+              pM->mat[12] * pM->mat[1] * pM->mat[7] -
+              pM->mat[12] * pM->mat[3] * pM->mat[5];
+
+    tmp.mat[14] = -pM->mat[0]  * pM->mat[5] * pM->mat[14] +
+               pM->mat[0]  * pM->mat[6] * pM->mat[13] +
+               pM->mat[4]  * pM->mat[1] * pM->mat[14] -
+               pM->mat[4]  * pM->mat[2] * pM->mat[13] -
+               pM->mat[12] * pM->mat[1] * pM->mat[6] +
+               pM->mat[12] * pM->mat[2] * pM->mat[5];
+
+    tmp.mat[3] = -pM->mat[1] * pM->mat[6] * pM->mat[11] +
+              pM->mat[1] * pM->mat[7] * pM->mat[10] +
+              pM->mat[5] * pM->mat[2] * pM->mat[11] -
+              pM->mat[5] * pM->mat[3] * pM->mat[10] -
+              pM->mat[9] * pM->mat[2] * pM->mat[7] +
+              pM->mat[9] * pM->mat[3] * pM->mat[6];
+
+    tmp.mat[7] = pM->mat[0] * pM->mat[6] * pM->mat[11] -
+             pM->mat[0] * pM->mat[7] * pM->mat[10] -
+             pM->mat[4] * pM->mat[2] * pM->mat[11] +
+             pM->mat[4] * pM->mat[3] * pM->mat[10] +
+             pM->mat[8] * pM->mat[2] * pM->mat[7] -
+             pM->mat[8] * pM->mat[3] * pM->mat[6];
+
+    tmp.mat[11] = -pM->mat[0] * pM->mat[5] * pM->mat[11] +
+               pM->mat[0] * pM->mat[7] * pM->mat[9] +
+               pM->mat[4] * pM->mat[1] * pM->mat[11] -
+               pM->mat[4] * pM->mat[3] * pM->mat[9] -
+               pM->mat[8] * pM->mat[1] * pM->mat[7] +
+               pM->mat[8] * pM->mat[3] * pM->mat[5];
+
+    tmp.mat[15] = pM->mat[0] * pM->mat[5] * pM->mat[10] -
+              pM->mat[0] * pM->mat[6] * pM->mat[9] -
+              pM->mat[4] * pM->mat[1] * pM->mat[10] +
+              pM->mat[4] * pM->mat[2] * pM->mat[9] +
+              pM->mat[8] * pM->mat[1] * pM->mat[6] -
+              pM->mat[8] * pM->mat[2] * pM->mat[5];
+
+    det = pM->mat[0] * tmp.mat[0] + pM->mat[1] * tmp.mat[4] + pM->mat[2] * tmp.mat[8] + pM->mat[3] * tmp.mat[12];
+
+    if (det == 0) {
+        return NULL;
+    }
+
+    det = 1.0 / det;
+
+    for (i = 0; i < 16; i++) {
+        pOut->mat[i] = tmp.mat[i] * det;
+    }
+
+    return pOut;
+}
+
+// kmMat4RotationQuaternion without the option
+REFERENCE kmMat4 *doubleRotationQuaternion(kmMat4 *pOut, const kmQuaternion *pQ)
+{
+    double xx = pQ->x * pQ->x;
+    double xy = pQ->x * pQ->y;
+    double xz = pQ->x * pQ->z;
+    double xw = pQ->x * pQ->w;
+
+    double yy = pQ->y * pQ->y;
+    double yz = pQ->y * pQ->z;
+    double yw = pQ->y * pQ->w;
+
+    double zz = pQ->z * pQ->z;
+    double zw = pQ->z * pQ->w;
+
+    pOut->mat[0] = 1 - 2 * (yy + zz);
+    pOut->mat[1] = 2 * (xy + zw);
+    pOut->mat[2] = 2 * (xz - yw);
+    pOut->mat[3] = 0;
+
+    pOut->mat[4] = 2 * (xy - zw);
+    pOut->mat[5] = 1 - 2 * (xx + zz);
+    pOut->mat[6] = 2 * (yz + xw);
+    pOut->mat[7] = 0.0;
+
+    pOut->mat[8] = 2 * (xz + yw);
+    pOut->mat[9] = 2 * (yz - xw);
+    pOut->mat[10] = 1 - 2 * (xx + yy);
+    pOut->mat[11] = 0.0;
+
+    pOut->mat[12] = 0.0;
+    pOut->mat[13] = 0.0;
+    pOut->mat[14] = 0.0;
+    pOut->mat[15] = 1.0;
+
+    return pOut;
+}
+
+// Gauss-Jordan elimination with partial pivoting, all in double
+static void exactInverse(double out[16], const kmMat4 *pM)
+{
+    double a[4][8];
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 8; c++)
+            a[r][c] = c < 4 ? pM->mat[c * 4 + r] : (c - 4 == r);
+    for (int c = 0; c < 4; c++) {
+        int pivot = c;
+        for (int r = c + 1; r < 4; r++)
+            if (fabs(a[r][c]) > fabs(a[pivot][c])) pivot = r;
+        for (int k = 0; k < 8; k++) {
+            double t = a[c][k]; a[c][k] = a[pivot][k]; a[pivot][k] = t;
+        }
+        double scale = 1 / a[c][c];
+        for (int k = 0; k < 8; k++) a[c][k] *= scale;
+        for (int r = 0; r < 4; r++) {
+            if (r == c) continue;
+            double f = a[r][c];
+            for (int k = 0; k < 8; k++) a[r][k] -= f * a[c][k];
+        }
+    }
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++)
+            out[c * 4 + r] = a[r][c + 4];
+}
+
+static void exactRotation(double out[16], const kmQuaternion *q)
+{
+    double x = q->x, y = q->y, z = q->z, w = q->w;
+    double m[16] = { 1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0,
+                     2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0,
+                     2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0,
+                     0, 0, 0, 1 };
+    for (int i = 0; i < 16; i++) out[i] = m[i];
+}
+
+// the largest difference relative to the largest element of the exact result
+static double difference(const kmMat4 *m, const double exact[16])
+{
+    double worst = 0, size = 0;
+    for (int i = 0; i < 16; i++) {
+        worst = fmax(worst, fabs(m->mat[i] - exact[i]));
+        size = fmax(size, fabs(exact[i]));
+    }
+    return worst / size;
+}
+
+typedef kmMat4 *(*Inverse)(kmMat4 *pOut, const kmMat4 *pM);
+typedef kmMat4 *(*Rotation)(kmMat4 *pOut, const kmQuaternion *pQ);
+
+static void inverseErrors(const char *name, Inverse f, double *mean, double *worst)
+{
+    double total = 0;
+    *worst = 0;
+    for (int i = 0; i < MATRICES; i++) {
+        kmMat4 m;
+        double exact[16];
+        f(&m, &matrices[i]);
+        exactInverse(exact, &matrices[i]);
+        double e = difference(&m, exact);
+        total += e;
+        *worst = fmax(*worst, e);
+    }
+    *mean = total / MATRICES;
+    printf("  %-38s mean %.3g, largest %.3g\n", name, *mean, *worst);
+}
+
+static double rotationError(const char *name, Rotation f)
+{
+    double worst = 0;
+    for (int i = 0; i < MATRICES; i++) {
+        kmMat4 m;
+        double exact[16];
+        f(&m, &quaternions[i]);
+        exactRotation(exact, &quaternions[i]);
+        worst = fmax(worst, difference(&m, exact));
+    }
+    printf("  %-38s largest %.3g\n", name, worst);
+    return worst;
+}
+
+int main()
+{
+    double t0, oldMean, oldWorst, newMean, newWorst, oldRotation, newRotation;
+    long calls = (long)MATRICES * REPEATS;
+
+    srand(1);
+    for (int i = 0; i < MATRICES; i++) {
+        kmQuaternion *q = &quaternions[i];
+        q->x = randomRange(-1, 1);
+        q->y = randomRange(-1, 1);
+        q->z = randomRange(-1, 1);
+        q->w = randomRange(-1, 1);
+        kmQuaternionNormalize(q, q);
+        // half model matrices, half anything well enough conditioned
+        if (i % 2) {
+            kmTRS trs;
+            kmVec3 t = { randomRange(-100, 100), randomRange(-100, 100), randomRange(-100, 100) };
+            kmVec3 s = { randomRange(.1, 10), randomRange(.1, 10), randomRange(.1, 10) };
+            kmTRSToMat4(&matrices[i], kmTRSFill(&trs, &t, q, &s));
+        } else {
+            for (int j = 0; j < 16; j++)
+                matrices[i].mat[j] = randomRange(-1, 1) + (j % 5 == 0 ? 2 : 0);
+        }
+    }
+
+#define TIME(name, code) \
+    t0 = benchNow(); \
+    for (int r = 0; r < REPEATS; r++) \
+        for (int i = 0; i < MATRICES; i++) { code; } \
+    benchReport(name, benchNow() - t0, calls);
+
+    TIME("kmMat4Inverse double temporaries", doubleInverse(&inverses[i], &matrices[i]))
+    TIME("kmMat4Inverse float", kmMat4Inverse(&inverses[i], &matrices[i]))
+    TIME("kmMat4RotationQuaternion double", doubleRotationQuaternion(&inverses[i], &quaternions[i]))
+    TIME("kmMat4RotationQuaternion float", kmMat4RotationQuaternion(&inverses[i], &quaternions[i]))
+
+    printf("\ndifference from doing it all in double\n");
+    inverseErrors("kmMat4Inverse double temporaries", doubleInverse, &oldMean, &oldWorst);
+    inverseErrors("kmMat4Inverse float", kmMat4Inverse, &newMean, &newWorst);
+    oldRotation = rotationError("kmMat4RotationQuaternion double", doubleRotationQuaternion);
+    newRotation = rotationError("kmMat4RotationQuaternion float", kmMat4RotationQuaternion);
+
+    return newMean > 2 * oldMean || newWorst > 2 * oldWorst || newRotation > 4 * oldRotation + 1e-7;
+}
@@ -0,0 +1,110 @@
+/*
+ * frustum culling of bounding spheres and boxes scattered around a camera,
+ * kmFrustumContainsSphere/AABB called for each object against the batch
+ * versions, exits with 1 if the batch results are ever different
+ *
+ * OBJECTS and REPEATS can be changed with -D
+ */
+
+#include <stdlib.h>
+#include <kazmath.h>
+#include "bench.h"
+
+#ifndef OBJECTS
+#define OBJECTS 100003
+#endif
+#ifndef REPEATS
+#define REPEATS 50
+#endif
+
+kmVec3 centres[OBJECTS];
+kmScalar radii[OBJECTS];
+kmAABB boxes[OBJECTS];
+kmScalar cx[OBJECTS], cy[OBJECTS], cz[OBJECTS];
+kmScalar minX[OBJECTS], minY[OBJECTS], minZ[OBJECTS];
+kmScalar maxX[OBJECTS], maxY[OBJECTS], maxZ[OBJECTS];
+kmUchar single[OBJECTS], batch[OBJECTS];
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+static int compare(const char *name)
+{
+    int counts[3] = { 0, 0, 0 }, wrong = 0;
+    for (int i = 0; i < OBJECTS; i++) {
+        counts[single[i]]++;
+        if (single[i] != batch[i]) wrong++;
+    }
+    printf("%-10s %6i outside %6i partial %6i inside, %i batch results differ\n",
+           name, counts[KM_CONTAINS_NONE], counts[KM_CONTAINS_PARTIAL],
+           counts[KM_CONTAINS_ALL], wrong);
+    return wrong;
+}
+
+int main()
+{
+    kmMat4 view, projection, vp;
+    kmVec3 eye = { 0, 10, 0 }, centre = { 50, 0, 50 }, up = { 0, 1, 0 };
+    kmFrustum frustum;
+    kmVec3Stream centreStream, minStream, maxStream;
+    unsigned int visible = 0;
+    int wrong = 0;
+    double start;
+
+    kmMat4LookAt(&view, &eye, &centre, &up);
+    kmMat4PerspectiveProjection(&projection, 45, 16 / 9.0f, 1, 300);
+    kmMat4Multiply(&vp, &projection, &view);
+    kmFrustumFromMat4(&frustum, &vp);
+
+    kmVec3StreamFill(&centreStream, cx, cy, cz);
+    kmVec3StreamFill(&minStream, minX, minY, minZ);
+    kmVec3StreamFill(&maxStream, maxX, maxY, maxZ);
+
+    srand(1);
+    for (int i = 0; i < OBJECTS; i++) {
+        kmVec3Fill(&centres[i], randomRange(-300, 300), randomRange(-20, 20), randomRange(-300, 300));
+        radii[i] = randomRange(.5, 10);
+        kmVec3StreamSet(&centreStream, i, &centres[i]);
+
+        kmAABBInitialize(&boxes[i], &centres[i], radii[i], randomRange(.5, 10), radii[i]);
+        kmVec3StreamSet(&minStream, i, &boxes[i].min);
+        kmVec3StreamSet(&maxStream, i, &boxes[i].max);
+    }
+
+    for (int i = 0; i < OBJECTS; i++)
+        single[i] = kmFrustumContainsSphere(&frustum, &centres[i], radii[i]);
+    kmFrustumContainsSpheres(batch, &frustum, &centreStream, radii, OBJECTS);
+    wrong += compare("spheres");
+    for (int i = 0; i < OBJECTS; i++)
+        single[i] = kmFrustumContainsAABB(&frustum, &boxes[i]);
+    kmFrustumContainsAABBs(batch, &frustum, &minStream, &maxStream, OBJECTS);
+    wrong += compare("boxes");
+    printf("\n");
+
+    start = benchNow();
+    for (int r = 0; r < REPEATS; r++)
+        for (int i = 0; i < OBJECTS; i++)
+            single[i] = kmFrustumContainsSphere(&frustum, &centres[i], radii[i]);
+    benchReport("kmFrustumContainsSphere", benchNow() - start, REPEATS * OBJECTS);
+
+    start = benchNow();
+    for (int r = 0; r < REPEATS; r++)
+        visible += kmFrustumContainsSpheres(batch, &frustum, &centreStream, radii, OBJECTS);
+    benchReport("kmFrustumContainsSpheres", benchNow() - start, REPEATS * OBJECTS);
+
+    start = benchNow();
+    for (int r = 0; r < REPEATS; r++)
+        for (int i = 0; i < OBJECTS; i++)
+            single[i] = kmFrustumContainsAABB(&frustum, &boxes[i]);
+    benchReport("kmFrustumContainsAABB", benchNow() - start, REPEATS * OBJECTS);
+
+    start = benchNow();
+    for (int r = 0; r < REPEATS; r++)
+        visible += kmFrustumContainsAABBs(batch, &frustum, &minStream, &maxStream, OBJECTS);
+    benchReport("kmFrustumContainsAABBs", benchNow() - start, REPEATS * OBJECTS);
+    benchSink = visible + single[OBJECTS / 2];
+
+    return wrong != 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * kmMat4Inverse against the affine, rigid and auto dispatching inverses on
+ * the kinds of matrices the framework inverts, reporting the time per
+ * inverse and the largest error in M * inverse(M) - identity, exits with 1
+ * if any error is over 1e-3
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <kazmath.h>
+#include "bench.h"
+
+#define MATRICES 10000
+#define REPEATS 100
+
+typedef kmMat4* (*inverseFn)(kmMat4*, const kmMat4*);
+
+kmMat4 in[MATRICES], out[MATRICES];
+double worst;   // over every run, more than 1e-3 fails the bench
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+// a rotation and translation like a view or a model matrix
+static void rigid(kmMat4 *m)
+{
+    kmMat4 rot;
+    kmMat4Translation(m, randomRange(-100, 100), randomRange(-100, 100), randomRange(-100, 100));
+    kmMat4RotationYawPitchRoll(&rot, randomRange(-3, 3), randomRange(-3, 3), randomRange(-3, 3));
+    kmMat4Multiply(m, m, &rot);
+}
+
+// rigid with a non uniform scale
+static void affine(kmMat4 *m)
+{
+    kmMat4 scale;
+    rigid(m);
+    kmMat4Scaling(&scale, randomRange(.1, 10), randomRange(.1, 10), randomRange(.1, 10));
+    kmMat4Multiply(m, m, &scale);
+}
+
+static void general(kmMat4 *m)
+{
+    kmMat4 proj;
+    rigid(m);
+    kmMat4PerspectiveProjection(&proj, randomRange(30, 90), randomRange(1, 2), 1, 1000);
+    kmMat4Multiply(m, &proj, m);
+}
+
+static double worstError()
+{
+    double run = 0;
+    kmMat4 p;
+    for (int i = 0; i < MATRICES; i++) {
+        kmMat4Multiply(&p, &in[i], &out[i]);
+        for (int j = 0; j < 16; j++) {
+            double e = fabs(p.mat[j] - (j % 5 == 0 ? 1 : 0));
+            if (e > run) run = e;
+        }
+    }
+    if (run > worst) worst = run;
+    return run;
+}
+
+static void run(const char *name, inverseFn fn)
+{
+    char label[64];
+    double start = benchNow();
+    for (int r = 0; r < REPEATS; r++)
+        for (int i = 0; i < MATRICES; i++) fn(&out[i], &in[i]);
+    double t = benchNow() - start;
+    snprintf(label, sizeof(label), "  %s", name);
+    benchReport(label, t, REPEATS * MATRICES);
+    printf("  %40s max error %g\n", "", worstError());
+}
+
+int main()
+{
+    const char *names[] = { "general", "affine", "rigid" };
+    void (*make[])(kmMat4 *) = { general, affine, rigid };
+
+    srand(1);
+    for (int c = 2; c >= 0; c--) {
+        int classified = 0;
+        for (int i = 0; i < MATRICES; i++) {
+            make[c](&in[i]);
+            if (kmMat4Classify(&in[i]) == c) classified++;
+        }
+        printf("%s matrices (%i of %i classified as %s)\n", names[c], classified,
+               MATRICES, names[c]);
+
+        run("kmMat4Inverse", kmMat4Inverse);
+        if (c >= KM_MAT4_AFFINE) run("kmMat4InverseAffine", kmMat4InverseAffine);
+        if (c == KM_MAT4_RIGID) run("kmMat4InverseRigid", kmMat4InverseRigid);
+        run("kmMat4InverseAuto", kmMat4InverseAuto);
+        printf("\n");
+    }
+    return worst > 1e-3;
+}
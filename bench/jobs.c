@@ -0,0 +1,124 @@
+/*
+ * the job system on 1 to N threads (N is the number of cores, at least 4),
+ * a batch of kmMat4Inverse split with parallelFor, lots of tiny jobs to
+ * show what starting one costs, and three stages of jobs each started
+ * after the one before
+ *
+ * every batch is checked against one thread and every stage against what
+ * it should have worked out, exits with 1 if any is wrong
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <kazmath.h>
+#include "jobs.h"
+#include "bench.h"
+
+#define MATRICES 200000
+#define BATCHES 10
+#define TINY 100000
+#define STAGE 64
+#define STAGED 1000
+
+static kmMat4 in[MATRICES], out[MATRICES], first[MATRICES];
+
+static float upTo(float most)
+{
+    return most * rand() / RAND_MAX;
+}
+
+static void invert(void *data, int from, int end)
+{
+    for (int i = from; i < end; i++) kmMat4Inverse(&out[i], &in[i]);
+}
+
+static atomic_int tinyDone;
+
+static void tiny(void *data)
+{
+    atomic_fetch_add_explicit(&tinyDone, 1, memory_order_relaxed);
+}
+
+// a is filled in, b is worked out from a, then the total of b
+static int a[STAGE], b[STAGE];
+static long total;
+
+static void stageA(void *data)
+{
+    int i = (int *)data - a;
+    a[i] = i + 1;
+}
+
+static void stageB(void *data)
+{
+    int i = (int *)data - b;
+    b[i] = a[i] * 3;
+}
+
+static void stageC(void *data)
+{
+    total = 0;
+    for (int i = 0; i < STAGE; i++) total += b[i];
+}
+
+int main()
+{
+    srand(1);
+    for (int i = 0; i < MATRICES; i++) {
+        kmMat4RotationYawPitchRoll(&in[i], upTo(6), upTo(6), upTo(6));
+        in[i].mat[12] = upTo(20) - 10;
+        in[i].mat[13] = upTo(20) - 10;
+    }
+
+    int cores = sysconf(_SC_NPROCESSORS_ONLN), wrong = 0;
+    printf("%d cores\n", cores);
+    for (int threads = 1; threads <= (cores > 4 ? cores : 4); threads++) {
+        struct jobSystem_t *js = createJobSystem(threads);
+        printf("%d threads\n", jobThreads(js));
+
+        double start = benchNow();
+        for (int n = 0; n < BATCHES; n++) parallelFor(js, MATRICES, invert, NULL);
+        double seconds = benchNow() - start;
+        if (threads == 1) memcpy(first, out, sizeof(out));
+        int same = !memcmp(first, out, sizeof(out));
+        printf("  %-32s %8.2f ms per batch, %6.1f million a second%s\n",
+               "parallelFor kmMat4Inverse", seconds * 1e3 / BATCHES,
+               (double)MATRICES * BATCHES / seconds / 1e6, same ? "" : " WRONG");
+        wrong |= !same;
+
+        struct jobCounter_t counter = { 0 };
+        atomic_store(&tinyDone, 0);
+        start = benchNow();
+        for (int n = 0; n < TINY; n++) runJob(js, tiny, NULL, &counter);
+        waitJobs(js, &counter);
+        seconds = benchNow() - start;
+        same = atomic_load(&tinyDone) == TINY;
+        printf("  %-32s %8.1f ns a job%s\n", "runJob", seconds * 1e9 / TINY, same ? "" : " WRONG");
+        wrong |= !same;
+
+        start = benchNow();
+        same = 1;
+        for (int n = 0; n < STAGED; n++) {
+            struct jobCounter_t doneA = { 0 }, doneB = { 0 }, doneC = { 0 };
+            memset(a, 0, sizeof(a));
+            memset(b, 0, sizeof(b));
+            total = -1;
+            for (int i = 0; i < STAGE; i++) runJob(js, stageA, &a[i], &doneA);
+            for (int i = 0; i < STAGE; i++) runJobAfter(js, stageB, &b[i], &doneB, &doneA);
+            runJobAfter(js, stageC, NULL, &doneC, &doneB);
+            waitJobs(js, &doneC);
+            waitJobs(js, &doneA);
+            waitJobs(js, &doneB);
+            same &= total == 3L * STAGE * (STAGE + 1) / 2;
+        }
+        seconds = benchNow() - start;
+        printf("  %-32s %8.1f us each%s\n", "3 stages of jobs", seconds * 1e6 / STAGED,
+               same ? "" : " WRONG");
+        wrong |= !same;
+
+        freeJobSystem(js);
+    }
+    return wrong;
+}
@@ -0,0 +1,277 @@
+/*
+ * times every implemented mat4, vec3, quaternion, plane and aabb function
+ * in kazmath over randomised inputs, for comparing one build or change
+ * with another
+ *
+ * each sample is one pass over INPUTS different inputs, after WARMUP
+ * untimed samples SAMPLES are timed and the median, 99th percentile and
+ * fastest sample are printed in ns per call as tab separated columns, one
+ * function per line (lines starting with # are comments), eg
+ *
+ *   ./bench-kazmath > before.tsv
+ *   ./bench-kazmath Mat4Multiply Quaternion      only names containing either
+ *
+ * SAMPLES, WARMUP and INPUTS can be changed with -D
+ *
+ * kmAABBScale, kmAABBIntersectsTriangle, kmPlaneScale, kmQuaternionExp and
+ * kmQuaternionLn aren't implemented (they assert) so aren't timed
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <kazmath.h>
+#include <vec4.h>
+#include "bench.h"
+
+#ifndef SAMPLES
+#define SAMPLES 201
+#endif
+#ifndef WARMUP
+#define WARMUP 20
+#endif
+#ifndef INPUTS
+#define INPUTS 1024
+#endif
+
+// inputs, m1 and m2 are any invertible matrix, the others what they say
+kmMat4 m1[INPUTS], m2[INPUTS], rigid[INPUTS], affine[INPUTS], mixed[INPUTS], mo[INPUTS];
+kmMat3 m3[INPUTS], rot3[INPUTS], m3o[INPUTS];
+kmVec3 v1[INPUTS], v2[INPUTS], v3[INPUTS], unit[INPUTS], unit2[INPUTS], ang[INPUTS], vo[INPUTS];
+kmVec4 v4[INPUTS];
+kmQuaternion q1[INPUTS], q2[INPUTS], qo[INPUTS];
+kmPlane pl[INPUTS], plo[INPUTS];
+kmAABB box[INPUTS], boxo[INPUTS];
+kmScalar s[INPUTS], positive[INPUTS], so[INPUTS];
+float sink;
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+static void randomVec3(kmVec3 *v, float min, float max)
+{
+    kmVec3Fill(v, randomRange(min, max), randomRange(min, max), randomRange(min, max));
+}
+
+static void randomRigid(kmMat4 *m)
+{
+    kmMat4 rot;
+    kmMat4Translation(m, randomRange(-100, 100), randomRange(-100, 100), randomRange(-100, 100));
+    kmMat4RotationYawPitchRoll(&rot, randomRange(-3, 3), randomRange(-3, 3), randomRange(-3, 3));
+    kmMat4Multiply(m, m, &rot);
+}
+
+static void randomAffine(kmMat4 *m)
+{
+    kmMat4 scale;
+    randomRigid(m);
+    kmMat4Scaling(&scale, randomRange(.1, 10), randomRange(.1, 10), randomRange(.1, 10));
+    kmMat4Multiply(m, m, &scale);
+}
+
+static void randomInputs()
+{
+    for (int i = 0; i < INPUTS; i++) {
+        for (int j = 0; j < 16; j++) {
+            m1[i].mat[j] = randomRange(-10, 10);
+            m2[i].mat[j] = randomRange(-10, 10);
+        }
+        for (int j = 0; j < 9; j++) m3[i].mat[j] = randomRange(-10, 10);
+        randomRigid(&rigid[i]);
+        randomAffine(&affine[i]);
+        // an unpredictable mix for the functions that check what they've got
+        if (i % 3 == 0) kmMat4Assign(&mixed[i], &rigid[i]);
+        else if (i % 3 == 1) kmMat4Assign(&mixed[i], &affine[i]);
+        else kmMat4PerspectiveProjection(&mixed[i], 60, 1.5, 1, 1000);
+        kmMat4ExtractRotation(&rot3[i], &rigid[i]);
+
+        randomVec3(&v1[i], -10, 10);
+        randomVec3(&v2[i], -10, 10);
+        randomVec3(&v3[i], -10, 10);
+        kmVec3Normalize(&unit[i], &v1[i]);
+        kmVec3Normalize(&unit2[i], &v2[i]);
+        randomVec3(&ang[i], -3, 3);
+        kmVec4Fill(&v4[i], v1[i].x, v1[i].y, v1[i].z, 1);
+
+        kmQuaternionRotationAxisAngle(&q1[i], &unit[i], randomRange(-3, 3));
+        kmQuaternionRotationAxisAngle(&q2[i], &unit2[i], randomRange(-3, 3));
+        kmPlaneFromPointAndNormal(&pl[i], &v2[i], &unit[i]);
+        kmAABBInitialize(&box[i], &v1[i], randomRange(.5, 5), randomRange(.5, 5), randomRange(.5, 5));
+
+        s[i] = randomRange(-3, 3);
+        positive[i] = randomRange(.5, 50);
+    }
+}
+
+#define NEXT(i) (((i) + 1) % INPUTS)
+
+/*
+ * EACH(name, code) runs code for i = 0 to INPUTS - 1, ONCE(name, code)
+ * runs code once as INPUTS calls
+ */
+#define CASES \
+    EACH(kmMat4Fill, kmMat4Fill(&mo[i], m1[i].mat)) \
+    EACH(kmMat4Identity, kmMat4Identity(&mo[i])) \
+    EACH(kmMat4Inverse, kmMat4Inverse(&mo[i], &m1[i])) \
+    EACH(kmMat4InverseAffine, kmMat4InverseAffine(&mo[i], &affine[i])) \
+    EACH(kmMat4InverseRigid, kmMat4InverseRigid(&mo[i], &rigid[i])) \
+    EACH(kmMat4InverseAuto, kmMat4InverseAuto(&mo[i], &mixed[i])) \
+    EACH(kmMat4Classify, sink += kmMat4Classify(&mixed[i])) \
+    EACH(kmMat4IsIdentity, sink += kmMat4IsIdentity(&m1[i])) \
+    EACH(kmMat4Transpose, kmMat4Transpose(&mo[i], &m1[i])) \
+    EACH(kmMat4Multiply, kmMat4Multiply(&mo[i], &m1[i], &m2[i])) \
+    ONCE(kmMat4MultiplyBatch, kmMat4MultiplyBatch(mo, &m1[0], m2, INPUTS)) \
+    EACH(kmMat4Assign, kmMat4Assign(&mo[i], &m1[i])) \
+    EACH(kmMat4AssignMat3, kmMat4AssignMat3(&mo[i], &m3[i])) \
+    EACH(kmMat4AreEqual, sink += kmMat4AreEqual(&m1[i], &m2[i])) \
+    EACH(kmMat4RotationX, kmMat4RotationX(&mo[i], s[i])) \
+    EACH(kmMat4RotationY, kmMat4RotationY(&mo[i], s[i])) \
+    EACH(kmMat4RotationZ, kmMat4RotationZ(&mo[i], s[i])) \
+    EACH(kmMat4RotationYawPitchRoll, kmMat4RotationYawPitchRoll(&mo[i], ang[i].x, ang[i].y, ang[i].z)) \
+    EACH(kmMat4RotationQuaternion, kmMat4RotationQuaternion(&mo[i], &q1[i])) \
+    EACH(kmMat4RotationTranslation, kmMat4RotationTranslation(&mo[i], &rot3[i], &v1[i])) \
+    EACH(kmMat4Scaling, kmMat4Scaling(&mo[i], v1[i].x, v1[i].y, v1[i].z)) \
+    EACH(kmMat4Translation, kmMat4Translation(&mo[i], v1[i].x, v1[i].y, v1[i].z)) \
+    EACH(kmMat4GetUpVec3, kmMat4GetUpVec3(&vo[i], &rigid[i])) \
+    EACH(kmMat4GetRightVec3, kmMat4GetRightVec3(&vo[i], &rigid[i])) \
+    EACH(kmMat4GetForwardVec3RH, kmMat4GetForwardVec3RH(&vo[i], &rigid[i])) \
+    EACH(kmMat4GetForwardVec3LH, kmMat4GetForwardVec3LH(&vo[i], &rigid[i])) \
+    EACH(kmMat4PerspectiveProjection, kmMat4PerspectiveProjection(&mo[i], 30 + positive[i], 1.5, 1, 1000)) \
+    EACH(kmMat4OrthographicProjection, \
+         kmMat4OrthographicProjection(&mo[i], -positive[i], positive[i], -positive[i], positive[i], 1, 100)) \
+    EACH(kmMat4LookAt, kmMat4LookAt(&mo[i], &v1[i], &v2[i], &KM_VEC3_POS_Y)) \
+    EACH(kmMat4RotationAxisAngle, kmMat4RotationAxisAngle(&mo[i], &unit[i], s[i])) \
+    EACH(kmMat4ExtractRotation, kmMat4ExtractRotation(&m3o[i], &m1[i])) \
+    EACH(kmMat4ExtractPlane, kmMat4ExtractPlane(&plo[i], &m1[i], i % 6)) \
+    EACH(kmMat4RotationToAxisAngle, kmMat4RotationToAxisAngle(&vo[i], &so[i], &rigid[i])) \
+    \
+    EACH(kmVec3Fill, kmVec3Fill(&vo[i], s[i], positive[i], s[i])) \
+    EACH(kmVec3Length, sink += kmVec3Length(&v1[i])) \
+    EACH(kmVec3LengthSq, sink += kmVec3LengthSq(&v1[i])) \
+    EACH(kmVec3Normalize, kmVec3Normalize(&vo[i], &v1[i])) \
+    EACH(kmVec3Cross, kmVec3Cross(&vo[i], &v1[i], &v2[i])) \
+    EACH(kmVec3Dot, sink += kmVec3Dot(&v1[i], &v2[i])) \
+    EACH(kmVec3Add, kmVec3Add(&vo[i], &v1[i], &v2[i])) \
+    EACH(kmVec3Subtract, kmVec3Subtract(&vo[i], &v1[i], &v2[i])) \
+    EACH(kmVec3MultiplyMat3, kmVec3MultiplyMat3(&vo[i], &v1[i], &m3[i])) \
+    EACH(kmVec3MultiplyMat4, kmVec3MultiplyMat4(&vo[i], &v1[i], &m1[i])) \
+    EACH(kmVec3Transform, kmVec3Transform(&vo[i], &v1[i], &m1[i])) \
+    EACH(kmVec3TransformNormal, kmVec3TransformNormal(&vo[i], &v1[i], &m1[i])) \
+    EACH(kmVec3TransformCoord, kmVec3TransformCoord(&vo[i], &v1[i], &m1[i])) \
+    EACH(kmVec3Scale, kmVec3Scale(&vo[i], &v1[i], s[i])) \
+    EACH(kmVec3AreEqual, sink += kmVec3AreEqual(&v1[i], &v2[i])) \
+    EACH(kmVec3InverseTransform, kmVec3InverseTransform(&vo[i], &v1[i], &rigid[i])) \
+    EACH(kmVec3InverseTransformNormal, kmVec3InverseTransformNormal(&vo[i], &v1[i], &rigid[i])) \
+    EACH(kmVec3Assign, kmVec3Assign(&vo[i], &v1[i])) \
+    EACH(kmVec3Zero, kmVec3Zero(&vo[i])) \
+    EACH(kmVec3GetHorizontalAngle, kmVec3GetHorizontalAngle(&vo[i], &v1[i])) \
+    EACH(kmVec3RotationToDirection, kmVec3RotationToDirection(&vo[i], &ang[i], &KM_VEC3_POS_Z)) \
+    EACH(kmVec3ProjectOnToPlane, kmVec3ProjectOnToPlane(&vo[i], &v1[i], &pl[i])) \
+    \
+    EACH(kmQuaternionAreEqual, sink += kmQuaternionAreEqual(&q1[i], &q2[i])) \
+    EACH(kmQuaternionFill, kmQuaternionFill(&qo[i], s[i], positive[i], s[i], positive[i])) \
+    EACH(kmQuaternionDot, sink += kmQuaternionDot(&q1[i], &q2[i])) \
+    EACH(kmQuaternionIdentity, kmQuaternionIdentity(&qo[i])) \
+    EACH(kmQuaternionInverse, kmQuaternionInverse(&qo[i], &q1[i])) \
+    EACH(kmQuaternionIsIdentity, sink += kmQuaternionIsIdentity(&q1[i])) \
+    EACH(kmQuaternionLength, sink += kmQuaternionLength(&q1[i])) \
+    EACH(kmQuaternionLengthSq, sink += kmQuaternionLengthSq(&q1[i])) \
+    EACH(kmQuaternionMultiply, kmQuaternionMultiply(&qo[i], &q1[i], &q2[i])) \
+    EACH(kmQuaternionNormalize, kmQuaternionNormalize(&qo[i], &q1[i])) \
+    EACH(kmQuaternionRotationAxisAngle, kmQuaternionRotationAxisAngle(&qo[i], &unit[i], s[i])) \
+    EACH(kmQuaternionRotationMatrix, kmQuaternionRotationMatrix(&qo[i], &rot3[i])) \
+    EACH(kmQuaternionRotationPitchYawRoll, kmQuaternionRotationPitchYawRoll(&qo[i], ang[i].x, ang[i].y, ang[i].z)) \
+    EACH(kmQuaternionSlerp, kmQuaternionSlerp(&qo[i], &q1[i], &q2[i], 0.3f)) \
+    EACH(kmQuaternionToAxisAngle, kmQuaternionToAxisAngle(&q1[i], &vo[i], &so[i])) \
+    EACH(kmQuaternionScale, kmQuaternionScale(&qo[i], &q1[i], s[i])) \
+    EACH(kmQuaternionAssign, kmQuaternionAssign(&qo[i], &q1[i])) \
+    EACH(kmQuaternionAdd, kmQuaternionAdd(&qo[i], &q1[i], &q2[i])) \
+    EACH(kmQuaternionSubtract, kmQuaternionSubtract(&qo[i], &q1[i], &q2[i])) \
+    EACH(kmQuaternionRotationBetweenVec3, kmQuaternionRotationBetweenVec3(&qo[i], &unit[i], &unit2[i], NULL)) \
+    EACH(kmQuaternionMultiplyVec3, kmQuaternionMultiplyVec3(&vo[i], &q1[i], &v1[i])) \
+    EACH(kmQuaternionGetUpVec3, kmQuaternionGetUpVec3(&vo[i], &q1[i])) \
+    EACH(kmQuaternionGetRightVec3, kmQuaternionGetRightVec3(&vo[i], &q1[i])) \
+    EACH(kmQuaternionGetForwardVec3RH, kmQuaternionGetForwardVec3RH(&vo[i], &q1[i])) \
+    EACH(kmQuaternionGetForwardVec3LH, kmQuaternionGetForwardVec3LH(&vo[i], &q1[i])) \
+    EACH(kmQuaternionGetPitch, sink += kmQuaternionGetPitch(&q1[i])) \
+    EACH(kmQuaternionGetYaw, sink += kmQuaternionGetYaw(&q1[i])) \
+    EACH(kmQuaternionGetRoll, sink += kmQuaternionGetRoll(&q1[i])) \
+    \
+    EACH(kmPlaneFill, kmPlaneFill(&plo[i], s[i], positive[i], s[i], positive[i])) \
+    EACH(kmPlaneDot, sink += kmPlaneDot(&pl[i], &v4[i])) \
+    EACH(kmPlaneDotCoord, sink += kmPlaneDotCoord(&pl[i], &v1[i])) \
+    EACH(kmPlaneDotNormal, sink += kmPlaneDotNormal(&pl[i], &v1[i])) \
+    EACH(kmPlaneFromNormalAndDistance, kmPlaneFromNormalAndDistance(&plo[i], &unit[i], s[i])) \
+    EACH(kmPlaneFromPointAndNormal, kmPlaneFromPointAndNormal(&plo[i], &v1[i], &unit[i])) \
+    EACH(kmPlaneFromPoints, kmPlaneFromPoints(&plo[i], &v1[i], &v2[i], &v3[i])) \
+    EACH(kmPlaneIntersectLine, kmPlaneIntersectLine(&vo[i], &pl[i], &v1[i], &v2[i])) \
+    EACH(kmPlaneNormalize, kmPlaneNormalize(&plo[i], &pl[i])) \
+    EACH(kmPlaneExtractFromMat4, kmPlaneExtractFromMat4(&plo[i], &m1[i], i % 3 + 1)) \
+    EACH(kmPlaneGetIntersection, kmPlaneGetIntersection(&vo[i], &pl[i], &pl[NEXT(i)], &pl[NEXT(i + 1)])) \
+    EACH(kmPlaneClassifyPoint, sink += kmPlaneClassifyPoint(&pl[i], &v1[i])) \
+    \
+    EACH(kmAABBInitialize, kmAABBInitialize(&boxo[i], &v1[i], positive[i], positive[i], positive[i])) \
+    EACH(kmAABBContainsPoint, sink += kmAABBContainsPoint(&box[i], &v2[i])) \
+    EACH(kmAABBAssign, kmAABBAssign(&boxo[i], &box[i])) \
+    EACH(kmAABBContainsAABB, sink += kmAABBContainsAABB(&box[i], &box[NEXT(i)])) \
+    EACH(kmAABBDiameterX, sink += kmAABBDiameterX(&box[i])) \
+    EACH(kmAABBDiameterY, sink += kmAABBDiameterY(&box[i])) \
+    EACH(kmAABBDiameterZ, sink += kmAABBDiameterZ(&box[i])) \
+    EACH(kmAABBCentre, kmAABBCentre(&box[i], &vo[i]))
+
+#define EACH(name, ...) static void bench_##name() { for (int i = 0; i < INPUTS; i++) { __VA_ARGS__; } }
+#define ONCE(name, ...) static void bench_##name() { __VA_ARGS__; }
+CASES
+#undef EACH
+#undef ONCE
+
+struct benchCase {
+    const char *name;
+    void (*run)();
+};
+
+#define EACH(name, ...) { #name, bench_##name },
+#define ONCE(name, ...) { #name, bench_##name },
+static const struct benchCase cases[] = { CASES };
+
+static int compare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int wanted(const char *name, int argc, char **argv)
+{
+    if (argc < 2) return 1;
+    for (int i = 1; i < argc; i++)
+        if (strstr(name, argv[i])) return 1;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static double ns[SAMPLES];
+
+    srand(1);
+    randomInputs();
+
+    printf("# %d samples of %d calls after %d warmup samples, ns per call\n", SAMPLES, INPUTS, WARMUP);
+    printf("# function\tmedian\tp99\tmin\n");
+    for (unsigned int c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        if (!wanted(cases[c].name, argc, argv)) continue;
+
+        for (int w = 0; w < WARMUP; w++) cases[c].run();
+        for (int k = 0; k < SAMPLES; k++) {
+            double start = benchNow();
+            cases[c].run();
+            ns[k] = (benchNow() - start) * 1e9 / INPUTS;
+        }
+        qsort(ns, SAMPLES, sizeof(double), compare);
+        printf("%s\t%.2f\t%.2f\t%.2f\n", cases[c].name, ns[SAMPLES / 2],
+               ns[(SAMPLES * 99 + 99) / 100 - 1], ns[0]);
+        fflush(stdout);
+    }
+    benchSink = sink;
+    return 0;
+}
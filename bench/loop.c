@@ -0,0 +1,130 @@
+/*
+ * the fixed timestep loop first run against a fake clock (frames take as
+ * long as we say and sleeping returns at once) to check the pacing, then
+ * for real at 50Hz with 5ms of work a frame against what the examples used
+ * to do, the work then usleep(20000)
+ *
+ * exits with 1 if any of the fake clock checks fail
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include "loop.h"
+#include "bench.h"
+
+#define STEP (1 / 50.0)
+#define FRAMES 1000
+#define REAL_FRAMES 100
+
+struct fakeClock_t {
+    struct loopClock_t clock;
+    double time;
+    double oversleep;       // sleeps wake up to this much late
+};
+
+static double fakeNow(struct loopClock_t *clock)
+{
+    return ((struct fakeClock_t *)clock)->time;
+}
+
+static void fakeSleepUntil(struct loopClock_t *clock, double when)
+{
+    struct fakeClock_t *fake = (struct fakeClock_t *)clock;
+    if (when > fake->time) fake->time = when + fake->oversleep * rand() / RAND_MAX;
+}
+
+static struct fakeClock_t fake = { { fakeNow, fakeSleepUntil } };
+
+static int wrong = 0;
+
+static void check(const char *name, int ok)
+{
+    printf("  %-60s %s\n", name, ok ? "ok" : "WRONG");
+    wrong |= !ok;
+}
+
+static void report(const char *name, struct gameLoop_t *loop)
+{
+    struct loopStats_t stats;
+    getLoopStats(loop, &stats);
+    printf("  %-30s %6.2fms a frame (%4.1fHz) jitter %6.3fms, %5.2f to %5.2fms, %d missed\n",
+           name, stats.mean * 1e3, 1 / stats.mean, stats.jitter * 1e3,
+           stats.shortest * 1e3, stats.longest * 1e3, stats.missed);
+}
+
+// frames take work seconds, every spikeEvery frames spike seconds instead
+static void runFake(struct gameLoop_t *loop, double work, int spikeEvery, double spike)
+{
+    fake.time = 100;
+    initGameLoop(loop, STEP, STEP);
+    loop->clock = &fake.clock;
+    for (int f = 0; f < FRAMES; f++) {
+        startFrame(loop);
+        fake.time += spikeEvery && f % spikeEvery == spikeEvery - 1 ? spike : work;
+        endFrame(loop);
+    }
+}
+
+static void busy(double seconds)
+{
+    double until = benchNow() + seconds;
+    while (benchNow() < until);
+}
+
+int main()
+{
+    struct gameLoop_t loop;
+    struct loopStats_t stats;
+    srand(1);
+
+    printf("fake clock, 50Hz\n");
+    runFake(&loop, 0.005, 0, 0);
+    getLoopStats(&loop, &stats);
+    report("5ms of work", &loop);
+    check("every frame 20ms", fabs(stats.shortest - STEP) < 1e-9 && fabs(stats.longest - STEP) < 1e-9);
+    check("an update a frame", fabs(loop.updates + loop.alpha - FRAMES) < 1e-6);
+
+    runFake(&loop, 0.005, 10, 0.03);
+    getLoopStats(&loop, &stats);
+    report("a 30ms frame every 10", &loop);
+    check("the late frames are made up by the next", fabs(stats.mean - STEP) < 1e-6);
+    check("late frames counted", stats.missed == FRAMES / 10);
+    check("simulation keeps up", fabs(loop.updates + loop.alpha - FRAMES) < 1e-6);
+
+    fake.oversleep = 0.002;
+    runFake(&loop, 0.005, 0, 0);
+    fake.oversleep = 0;
+    getLoopStats(&loop, &stats);
+    report("sleeps up to 2ms late", &loop);
+    check("no drift", fabs(stats.mean - STEP) < 2e-6);
+
+    runFake(&loop, 0.005, 100, 1);
+    getLoopStats(&loop, &stats);
+    report("a 1s stall every 100", &loop);
+    // the last stall is the last frame so 9 frames catch up
+    check("no more than maxUpdates after a stall",
+          fabs(loop.updates + loop.alpha - (FRAMES + 9 * (loop.maxUpdates - 1))) < 1e-6);
+    check("alpha between 0 and 1", loop.alpha >= 0 && loop.alpha < 1);
+
+    printf("\nreal clock, 50Hz with 5ms of work a frame\n");
+    initGameLoop(&loop, STEP, STEP);
+    for (int f = 0; f < REAL_FRAMES; f++) {
+        startFrame(&loop);
+        busy(0.005);
+        endFrame(&loop);
+    }
+    report("startFrame and endFrame", &loop);
+
+    // what the examples did, timed the same way
+    initGameLoop(&loop, STEP, 0);
+    for (int f = 0; f < REAL_FRAMES; f++) {
+        startFrame(&loop);
+        busy(0.005);
+        usleep(20000);
+    }
+    report("usleep(20000)", &loop);
+
+    return wrong;
+}
@@ -0,0 +1,153 @@
+/*
+ * kmMat4Multiply and kmMat4MultiplyBatch against the original scalar
+ * multiply, first a randomized check that the results match (exits with 1
+ * if anything is more than 1 ulp out) then timings
+ *
+ * MATRICES and REPEATS can be changed with -D, 1000 matrices fit in cache
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <kazmath.h>
+#include "bench.h"
+
+#define CHECKS 1000000
+#ifndef MATRICES
+#define MATRICES 10000
+#endif
+#ifndef REPEATS
+#define REPEATS 200
+#endif
+
+// the scalar multiply kazmath shipped with
+__attribute__((noinline))
+static void refMultiply(kmMat4 *pOut, const kmMat4 *pM1, const kmMat4 *pM2)
+{
+    kmScalar mat[16];
+    const kmScalar *m1 = pM1->mat, *m2 = pM2->mat;
+
+    mat[0] = m1[0] * m2[0] + m1[4] * m2[1] + m1[8] * m2[2] + m1[12] * m2[3];
+    mat[1] = m1[1] * m2[0] + m1[5] * m2[1] + m1[9] * m2[2] + m1[13] * m2[3];
+    mat[2] = m1[2] * m2[0] + m1[6] * m2[1] + m1[10] * m2[2] + m1[14] * m2[3];
+    mat[3] = m1[3] * m2[0] + m1[7] * m2[1] + m1[11] * m2[2] + m1[15] * m2[3];
+
+    mat[4] = m1[0] * m2[4] + m1[4] * m2[5] + m1[8] * m2[6] + m1[12] * m2[7];
+    mat[5] = m1[1] * m2[4] + m1[5] * m2[5] + m1[9] * m2[6] + m1[13] * m2[7];
+    mat[6] = m1[2] * m2[4] + m1[6] * m2[5] + m1[10] * m2[6] + m1[14] * m2[7];
+    mat[7] = m1[3] * m2[4] + m1[7] * m2[5] + m1[11] * m2[6] + m1[15] * m2[7];
+
+    mat[8] = m1[0] * m2[8] + m1[4] * m2[9] + m1[8] * m2[10] + m1[12] * m2[11];
+    mat[9] = m1[1] * m2[8] + m1[5] * m2[9] + m1[9] * m2[10] + m1[13] * m2[11];
+    mat[10] = m1[2] * m2[8] + m1[6] * m2[9] + m1[10] * m2[10] + m1[14] * m2[11];
+    mat[11] = m1[3] * m2[8] + m1[7] * m2[9] + m1[11] * m2[10] + m1[15] * m2[11];
+
+    mat[12] = m1[0] * m2[12] + m1[4] * m2[13] + m1[8] * m2[14] + m1[12] * m2[15];
+    mat[13] = m1[1] * m2[12] + m1[5] * m2[13] + m1[9] * m2[14] + m1[13] * m2[15];
+    mat[14] = m1[2] * m2[12] + m1[6] * m2[13] + m1[10] * m2[14] + m1[14] * m2[15];
+    mat[15] = m1[3] * m2[12] + m1[7] * m2[13] + m1[11] * m2[14] + m1[15] * m2[15];
+
+    memcpy(pOut->mat, mat, sizeof(mat));
+}
+
+static float randomFloat()
+{
+    // a spread of magnitudes and signs, with the odd exact zero
+    if (rand() % 50 == 0) return 0;
+    float f = (float)rand() / RAND_MAX * 2 - 1;
+    return f * (1 << (rand() % 12));
+}
+
+static void randomMatrix(kmMat4 *m)
+{
+    for (int i = 0; i < 16; i++) m->mat[i] = randomFloat();
+}
+
+static int32_t ordered(float f)
+{
+    int32_t i;
+    memcpy(&i, &f, sizeof(i));
+    return i < 0 ? INT32_MIN - i : i;
+}
+
+// largest difference in ulps between two matrices
+static int ulps(const kmMat4 *a, const kmMat4 *b)
+{
+    int worst = 0;
+    for (int i = 0; i < 16; i++) {
+        int64_t d = (int64_t)ordered(a->mat[i]) - ordered(b->mat[i]);
+        if (d < 0) d = -d;
+        if (d > worst) worst = d > 1000000 ? 1000000 : (int)d;
+    }
+    return worst;
+}
+
+kmMat4 as[MATRICES], bs[MATRICES], out[MATRICES];
+
+int main()
+{
+    long exact = 0;
+    int worst = 0;
+    kmMat4 a, b, ref, got;
+
+    srand(1);
+    for (int i = 0; i < CHECKS; i++) {
+        randomMatrix(&a);
+        randomMatrix(&b);
+        refMultiply(&ref, &a, &b);
+
+        // plain, then with the output the same as each input
+        kmMat4Multiply(&got, &a, &b);
+        int u = ulps(&ref, &got);
+        got = a;
+        kmMat4Multiply(&got, &got, &b);
+        if (ulps(&ref, &got) > u) u = ulps(&ref, &got);
+        got = b;
+        kmMat4Multiply(&got, &a, &got);
+        if (ulps(&ref, &got) > u) u = ulps(&ref, &got);
+
+        if (u == 0) exact++;
+        if (u > worst) worst = u;
+    }
+
+    for (int i = 0; i < MATRICES; i++) randomMatrix(&bs[i]);
+    randomMatrix(&a);
+    kmMat4MultiplyBatch(out, &a, bs, MATRICES);
+    for (int i = 0; i < MATRICES; i++) {
+        refMultiply(&ref, &a, &bs[i]);
+        int u = ulps(&ref, &out[i]);
+        if (u == 0) exact++;
+        if (u > worst) worst = u;
+    }
+
+    printf("%li of %i random products bit for bit identical, worst %i ulp\n\n",
+           exact, CHECKS + MATRICES, worst);
+
+    for (int i = 0; i < MATRICES; i++) randomMatrix(&as[i]);
+
+    double start = benchNow();
+    for (int r = 0; r < REPEATS; r++)
+        for (int i = 0; i < MATRICES; i++) refMultiply(&out[i], &as[i], &bs[i]);
+    benchReport("scalar multiply", benchNow() - start, REPEATS * MATRICES);
+    benchSink = out[MATRICES / 2].mat[5];
+
+    start = benchNow();
+    for (int r = 0; r < REPEATS; r++)
+        for (int i = 0; i < MATRICES; i++) kmMat4Multiply(&out[i], &as[i], &bs[i]);
+    benchReport("kmMat4Multiply", benchNow() - start, REPEATS * MATRICES);
+    benchSink = out[MATRICES / 2].mat[5];
+
+    start = benchNow();
+    for (int r = 0; r < REPEATS; r++)
+        for (int i = 0; i < MATRICES; i++) refMultiply(&out[i], &a, &bs[i]);
+    benchReport("scalar, one matrix times many", benchNow() - start, REPEATS * MATRICES);
+    benchSink = out[MATRICES / 2].mat[5];
+
+    start = benchNow();
+    for (int r = 0; r < REPEATS; r++)
+        kmMat4MultiplyBatch(out, &a, bs, MATRICES);
+    benchReport("kmMat4MultiplyBatch", benchNow() - start, REPEATS * MATRICES);
+    benchSink = out[MATRICES / 2].mat[5];
+
+    return worst > 1;
+}
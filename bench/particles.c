@@ -0,0 +1,191 @@
+/*
+ * particles updated per second by the particle system (structure of
+ * arrays, kmVec3Stream SIMD update, dead particles swapped out) against
+ * an array of structs updated one at a time with the kmVec3 functions,
+ * then a steady fountain where particles are emitted and die every frame
+ *
+ * then a million particles updated with 1 to N threads (N is the number
+ * of cores, at least 4)
+ *
+ * the emitted velocities are checked to average out at the emitter's, the
+ * two updates against each other and the threaded updates against one
+ * thread, exits with 1 if any are wrong, run from the top directory so the
+ * shaders can be found
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include "support.h"
+#include "particles.h"
+#include "egl.h"
+#include "bench.h"
+
+#define PARTICLES 100000
+#define FRAMES 500
+#define THREADED 1000000
+#define THREADED_FRAMES 60
+
+struct particle_t {
+    kmVec3 pos, vel;
+    float age, life;
+};
+
+struct particle_t old[PARTICLES];
+
+static void updateOld(int count, kmVec3 *gravity, float drag, float dt)
+{
+    kmVec3 g;
+    kmVec3Scale(&g, gravity, dt);
+    for (int i = 0; i < count; i++) {
+        kmVec3Scale(&old[i].vel, &old[i].vel, 1 - drag * dt);
+        kmVec3Add(&old[i].vel, &old[i].vel, &g);
+        kmVec3 step;
+        kmVec3Scale(&step, &old[i].vel, dt);
+        kmVec3Add(&old[i].pos, &old[i].pos, &step);
+        old[i].age += dt;
+    }
+}
+
+static void report(const char *name, double seconds, long particles)
+{
+    benchReport(name, seconds, FRAMES);
+    printf("  %.1f million particles a second\n", particles / seconds / 1e6);
+}
+
+// a million particles that die at different times, the same every call
+static void fillThreaded(struct particles_t *p, struct particleEmitter_t *e)
+{
+    srand(2);
+    p->count = 0;
+    e->owed = 0;
+    e->rate = THREADED;
+    emitParticles(p, e, 1);
+    for (int i = 0; i < p->count; i++) p->life[i] = rand_range(0.2, 10);
+}
+
+// sums are the same whatever order the particles end up in
+static double threadedSum(struct particles_t *p, int *staged)
+{
+    double sum = 0;
+    *staged = 1;
+    for (int i = 0; i < p->count; i++) {
+        sum += p->pos.x[i] + p->pos.y[i] * 3 + p->pos.z[i] * 7 + p->age[i];
+        if (p->cloud->pos[i * 3 + 1] != p->pos.y[i]) *staged = 0;
+    }
+    return sum;
+}
+
+int main()
+{
+    float dt = 1 / 60.0f;
+    if (!benchGlContext(64, 64)) return 1;
+    initPointClouds("resources/shaders/particle.vert", "resources/shaders/particle.frag", 1);
+
+    struct particles_t *p = createParticles(PARTICLES);
+    struct particleEmitter_t e = {
+        .pos = { 0, 0, 0 }, .vel = { 0, 5, 0 }, .spread = 1,
+        .rate = PARTICLES / dt, .life = 1000, .size = 4, .color = { 255, 200, 100, 255 }
+    };
+    kmVec3Fill(&p->gravity, 0, -9.8f, 0);
+    p->drag = 0.1f;
+
+    // everything alive, both updated the same way
+    srand(1);
+    emitParticles(p, &e, dt);
+    // spread goes both ways so on average they leave at vel
+    kmVec3 mean = { 0, 0, 0 };
+    for (int i = 0; i < PARTICLES; i++) {
+        mean.x += p->vel.x[i] / PARTICLES;
+        mean.y += p->vel.y[i] / PARTICLES;
+        mean.z += p->vel.z[i] / PARTICLES;
+    }
+    kmVec3 off;
+    int biased = kmVec3Length(kmVec3Subtract(&off, &mean, &e.vel)) > 0.01f;
+    printf("mean emitted velocity %.3f %.3f %.3f%s\n", mean.x, mean.y, mean.z,
+           biased ? " WRONG" : "");
+    for (int i = 0; i < PARTICLES; i++) {
+        kmVec3StreamGet(&old[i].pos, &p->pos, i);
+        kmVec3StreamGet(&old[i].vel, &p->vel, i);
+        old[i].age = 0;
+        old[i].life = e.life;
+    }
+    for (int f = 0; f < 10; f++) {
+        updateOld(PARTICLES, &p->gravity, p->drag, dt);
+        updateParticles(p, dt);
+    }
+    double worst = 0;
+    for (int i = 0; i < PARTICLES; i++) {
+        kmVec3 v;
+        kmVec3StreamGet(&v, &p->pos, i);
+        worst = fmax(worst, kmVec3Length(kmVec3Subtract(&v, &v, &old[i].pos)));
+    }
+    printf("largest difference after 10 updates %.3g\n\n", worst);
+
+    double start = benchNow();
+    for (int f = 0; f < FRAMES; f++) updateOld(PARTICLES, &p->gravity, p->drag, dt);
+    report("array of structs, kmVec3 functions", benchNow() - start, (long)PARTICLES * FRAMES);
+
+    start = benchNow();
+    for (int f = 0; f < FRAMES; f++) updateParticles(p, dt);
+    report("updateParticles", benchNow() - start, (long)PARTICLES * FRAMES);
+
+    // a fountain where a particle lives a second, about a 60th die each frame
+    p->count = 0;
+    e.life = 1;
+    e.rate = PARTICLES - 1;
+    for (int f = 0; f < 120; f++) {
+        emitParticles(p, &e, dt);
+        updateParticles(p, dt);
+    }
+    long updated = 0;
+    start = benchNow();
+    for (int f = 0; f < FRAMES; f++) {
+        emitParticles(p, &e, dt);
+        updated += p->count;
+        updateParticles(p, dt);
+    }
+    report("fountain, emitting and updating", benchNow() - start, updated);
+
+    start = benchNow();
+    // mostly the software renderer's time here, but it includes the upload
+    for (int f = 0; f < FRAMES / 50; f++) {
+        drawParticles(p, &(kmMat4){ .mat = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } });
+        glFinish();
+    }
+    benchReport("drawParticles", benchNow() - start, FRAMES / 50);
+
+    freeParticles(p);
+
+    p = createParticles(THREADED);
+    kmVec3Fill(&p->gravity, 0, -9.8f, 0);
+    p->drag = 0.1f;
+    int cores = sysconf(_SC_NPROCESSORS_ONLN), wrong = 0, count = 0;
+    double sum = 0;
+    printf("\n%d particles, %d cores\n", THREADED, cores);
+    for (int threads = 1; threads <= (cores > 4 ? cores : 4); threads++) {
+        setParticleThreads(p, threads);
+        fillThreaded(p, &e);
+        long updated = 0;
+        start = benchNow();
+        for (int f = 0; f < THREADED_FRAMES; f++) {
+            updated += p->count;
+            updateParticles(p, dt);
+        }
+        double seconds = benchNow() - start;
+        int staged;
+        double s = threadedSum(p, &staged);
+        if (threads == 1) {
+            count = p->count;
+            sum = s;
+        } else if (p->count != count || fabs(s - sum) > 1e-6 * fabs(sum) || !staged) {
+            wrong = 1;
+        }
+        printf("  %2d threads %8.2f ms per update, %6.1f million particles a second%s\n",
+               threads, seconds * 1e3 / THREADED_FRAMES, updated / seconds / 1e6,
+               wrong ? " WRONG" : "");
+    }
+    freeParticles(p);
+
+    return worst > 1e-5 || wrong || biased;
+}
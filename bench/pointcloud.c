@@ -0,0 +1,125 @@
+/*
+ * a million point explosion drawn as invaders used to (every position
+ * worked out on the CPU and uploaded each frame) against a ballistic
+ * point cloud (velocities uploaded once, the vertex shader moves the
+ * points), run from the top directory so the shaders can be found
+ *
+ * both are drawn at the same time and read back, exits with 1 if the
+ * pictures differ by more than a few pixels
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "support.h"
+#include "egl.h"
+#include "bench.h"
+
+#define POINTS 1000000
+#define FRAMES 10
+#define SIZE 256
+
+static unsigned char oldPixels[SIZE * SIZE * 4], newPixels[SIZE * SIZE * 4];
+
+static void fillExplosion(struct pointCloud_t *pntC)
+{
+    srand(1);
+    for (int i = 0; i < pntC->totalPoints; i++) {
+        kmVec3 v;
+        kmVec3Fill(&v, rand_range(-1, 2), rand_range(-1, 2), rand_range(-1, 2));
+        pntC->vel[i * 3] = v.x;
+        pntC->vel[i * 3 + 1] = v.y;
+        pntC->vel[i * 3 + 2] = v.z;
+        pntC->pos[i * 3] = pntC->pos[i * 3 + 1] = pntC->pos[i * 3 + 2] = 0;
+    }
+}
+
+// what invaders did before drawing each explosion
+static void moveOnCpu(struct pointCloud_t *pntC)
+{
+    for (int i = 0; i < pntC->totalPoints * 3; i++)
+        pntC->pos[i] = pntC->vel[i] * pntC->tick;
+}
+
+static void draw(struct pointCloud_t *pntC, kmMat4 *mvp, float t, int cpu)
+{
+    pntC->tick = t;
+    if (cpu) moveOnCpu(pntC);
+    drawPointCloud(pntC, mvp);
+}
+
+static void run(const char *name, struct pointCloud_t *pntC, kmMat4 *mvp, int cpu)
+{
+    double start = benchNow();
+    for (int f = 0; f < FRAMES; f++) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        draw(pntC, mvp, f * 0.05f, cpu);
+        glFinish();
+    }
+    benchReport(name, benchNow() - start, FRAMES);
+}
+
+static void picture(unsigned char *pixels, struct pointCloud_t *pntC, kmMat4 *mvp, int cpu)
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    draw(pntC, mvp, 0.6f, cpu);
+    glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+int main()
+{
+    if (!benchGlContext(SIZE, SIZE)) return 1;
+
+    // white points on a black background
+    GLuint tex;
+    unsigned char white[4] = { 255, 255, 255, 255 };
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glClearColor(0, 0, 0, 1);
+    glViewport(0, 0, SIZE, SIZE);
+
+    initPointClouds("resources/shaders/particle.vert", "resources/shaders/particle.frag", 1);
+    struct pointCloud_t *cpu = createPointCloud(POINTS);
+    struct pointCloud_t *gpu = createBallisticPointCloud(POINTS);
+    fillExplosion(cpu);
+    fillExplosion(gpu);
+    uploadPointCloud(gpu);
+
+    kmMat4 projection, view, mvp;
+    kmVec3 eye = { 0, 0, 3 }, centre = { 0, 0, 0 }, up = { 0, 1, 0 };
+    kmMat4PerspectiveProjection(&projection, 45, 1, 0.1, 10);
+    kmMat4LookAt(&view, &eye, &centre, &up);
+    kmMat4Multiply(&mvp, &projection, &view);
+
+    // the part of a frame the ballistic cloud doesn't have
+    printf("%d points, per frame\n", POINTS);
+    double start = benchNow();
+    for (int f = 0; f < FRAMES; f++) {
+        cpu->tick = f * 0.05f;
+        moveOnCpu(cpu);
+    }
+    benchReport("  moving them on the CPU", benchNow() - start, FRAMES);
+    start = benchNow();
+    for (int f = 0; f < FRAMES; f++) {
+        glBindBuffer(GL_ARRAY_BUFFER, cpu->vertBuf);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * 3 * POINTS, cpu->pos);
+        glFinish();
+    }
+    benchReport("  uploading them", benchNow() - start, FRAMES);
+
+    printf("\nwhole frames, with the drawing\n");
+    run("  moved on the CPU and uploaded", cpu, &mvp, 1);
+    run("  ballistic", gpu, &mvp, 0);
+
+    picture(oldPixels, cpu, &mvp, 1);
+    picture(newPixels, gpu, &mvp, 0);
+    int different = 0;
+    for (int i = 0; i < SIZE * SIZE * 4; i += 4)
+        different += memcmp(oldPixels + i, newPixels + i, 4) != 0;
+    printf("\n%d of %d pixels differ\n", different, SIZE * SIZE);
+
+    freePointCloud(cpu);
+    freePointCloud(gpu);
+    return different > SIZE * SIZE / 1000;
+}
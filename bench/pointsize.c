@@ -0,0 +1,132 @@
+/*
+ * fill rate of a cloud of points all the same size in pixels against a
+ * quarter as many sized in world units (shrinking with distance, clamped
+ * to a range of pixel sizes), with how much of the screen each covers and
+ * how many fragments it takes, run from the top directory so the shaders
+ * can be found
+ *
+ * first single points are drawn and measured, exits with 1 if a point
+ * isn't the size it should be
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "support.h"
+#include "egl.h"
+#include "bench.h"
+
+#define SIZE 256
+#define POINTS 4000
+#define FRAMES 50
+
+static unsigned char pixels[SIZE * SIZE * 4];
+
+// how many pixels across the middle row are lit
+static int drawnWidth(struct pointCloud_t *pntC, kmMat4 *mvp)
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    drawPointCloud(pntC, mvp);
+    glReadPixels(0, SIZE / 2, SIZE, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    int lit = 0;
+    for (int i = 0; i < SIZE; i++) lit += pixels[i * 4] != 0;
+    return lit;
+}
+
+static int check(const char *name, int width, float expected)
+{
+    int ok = fabs(width - expected) <= 1;
+    printf("  %-40s %3d pixels, expected %.1f%s\n", name, width, expected, ok ? "" : " WRONG");
+    return ok;
+}
+
+static double coverage()
+{
+    glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    int lit = 0;
+    for (int i = 0; i < SIZE * SIZE; i++) lit += pixels[i * 4] != 0;
+    return (double)lit / (SIZE * SIZE);
+}
+
+static void run(const char *name, struct pointCloud_t *pntC, kmMat4 *mvp, double fragments)
+{
+    double start = benchNow();
+    for (int f = 0; f < FRAMES; f++) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        drawPointCloud(pntC, mvp);
+        glFinish();
+    }
+    benchReport(name, benchNow() - start, FRAMES);
+    printf("  %d points, %.0f%% of the screen covered, %.1f million fragments\n",
+           pntC->totalPoints, coverage() * 100, fragments / 1e6);
+}
+
+int main()
+{
+    if (!benchGlContext(SIZE, SIZE)) return 1;
+
+    GLuint tex;
+    unsigned char white[4] = { 255, 255, 255, 255 };
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glClearColor(0, 0, 0, 1);
+    glViewport(0, 0, SIZE, SIZE);
+    initPointClouds("resources/shaders/particle.vert", "resources/shaders/particle.frag", 8);
+
+    kmMat4 projection;
+    kmMat4PerspectiveProjection(&projection, 60, 1, 0.1, 100);
+    float attenuation = pointCloudAttenuation(&projection, SIZE);
+
+    // single points 5 units away
+    int ok = 1;
+    struct pointCloud_t *one = createPointCloud(1);
+    one->pos[0] = 0;
+    one->pos[1] = 0;
+    one->pos[2] = -5;
+    printf("single points\n");
+    ok &= check("resizePointCloudSprites size", drawnWidth(one, &projection), 8);
+    one->sprite.size = 20;
+    ok &= check("sprite.size 20", drawnWidth(one, &projection), 20);
+    one->sprite.size = 2;
+    one->sprite.attenuation = attenuation;
+    ok &= check("2 units across", drawnWidth(one, &projection), 2 * attenuation / 5);
+    one->sprite.maxSize = 30;
+    ok &= check("2 units across, no more than 30", drawnWidth(one, &projection), 30);
+    one->pos[2] = -90;
+    one->sprite.minSize = 6;
+    ok &= check("90 units away, no less than 6", drawnWidth(one, &projection), 6);
+    freePointCloud(one);
+
+    // spread through the view from 2 to 50 units away
+    struct pointCloud_t *same = createPointCloud(POINTS);
+    struct pointCloud_t *sized = createPointCloud(POINTS / 4);
+    double sameFragments = 0, sizedFragments = 0;
+    sized->sprite.size = 0.7;
+    sized->sprite.attenuation = attenuation;
+    sized->sprite.minSize = 1;
+    sized->sprite.maxSize = 64;
+    srand(1);
+    for (int i = 0; i < POINTS; i++) {
+        float d = rand_range(2, 48), half = d * tanf(kmDegreesToRadians(30));
+        same->pos[i * 3] = rand_range(-half, half * 2);
+        same->pos[i * 3 + 1] = rand_range(-half, half * 2);
+        same->pos[i * 3 + 2] = -d;
+        sameFragments += 8 * 8;
+        if (i < POINTS / 4) {
+            float px = fminf(fmaxf(sized->sprite.size * attenuation / d, 1), 64);
+            sized->pos[i * 3] = same->pos[i * 3];
+            sized->pos[i * 3 + 1] = same->pos[i * 3 + 1];
+            sized->pos[i * 3 + 2] = same->pos[i * 3 + 2];
+            sizedFragments += px * px;
+        }
+    }
+
+    printf("\nper frame\n");
+    run("8 pixels each", same, &projection, sameFragments);
+    run("0.7 units across, 1 to 64 pixels", sized, &projection, sizedFragments);
+
+    freePointCloud(same);
+    freePointCloud(sized);
+    return !ok;
+}
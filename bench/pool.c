@@ -0,0 +1,171 @@
+/*
+ * explosions started and finished every frame, each one its own ballistic
+ * cloud (created, uploaded, drawn with its own matrix and freed) against
+ * clouds taken from a pool and all drawn together, run from the top
+ * directory so the shaders can be found
+ *
+ * both are drawn with the same explosions and read back, exits with 1 if
+ * the pictures differ by more than a few pixels or a pooled cloud freed
+ * twice is handed out twice
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "support.h"
+#include "egl.h"
+#include "bench.h"
+
+#define EXPLOSIONS 256
+#define POINTS 40
+#define LIFE 25         // frames each explosion lasts
+#define FRAMES 200
+#define SIZE 256
+
+static unsigned char oldPixels[SIZE * SIZE * 4], newPixels[SIZE * SIZE * 4];
+
+// each explosion is somewhere different, the same for both ways
+static kmVec3 where[EXPLOSIONS];
+static kmVec3 vel[POINTS];
+
+static void fill(struct pointCloud_t *pntC, kmVec3 *at, float start)
+{
+    for (int i = 0; i < POINTS; i++) {
+        pntC->pos[i * 3] = at->x;
+        pntC->pos[i * 3 + 1] = at->y;
+        pntC->pos[i * 3 + 2] = at->z;
+        pntC->vel[i * 3] = vel[i].x;
+        pntC->vel[i * 3 + 1] = vel[i].y;
+        pntC->vel[i * 3 + 2] = vel[i].z;
+        pntC->spawn[i] = start;
+    }
+    uploadPointCloud(pntC);
+}
+
+// explosion n starts at frame n * LIFE / EXPLOSIONS then again every LIFE frames
+static int starting(int n, int frame)
+{
+    return frame % LIFE == n * LIFE / EXPLOSIONS;
+}
+
+static struct pointCloud_t *separate[EXPLOSIONS];
+static int separateStart[EXPLOSIONS];
+
+static void separateFrame(kmMat4 *vp, int frame)
+{
+    for (int n = 0; n < EXPLOSIONS; n++) {
+        if (!starting(n, frame)) continue;
+        if (separate[n]) freePointCloud(separate[n]);
+        separate[n] = createBallisticPointCloud(POINTS);
+        separateStart[n] = frame;
+        kmVec3 zero = { 0, 0, 0 };
+        fill(separate[n], &zero, 0);
+    }
+    glClear(GL_COLOR_BUFFER_BIT);
+    for (int n = 0; n < EXPLOSIONS; n++) {
+        if (!separate[n]) continue;
+        kmMat4 model, mvp;
+        kmMat4Translation(&model, where[n].x, where[n].y, where[n].z);
+        kmMat4Multiply(&mvp, vp, &model);
+        separate[n]->tick = (frame - separateStart[n]) * 0.05f;
+        drawPointCloud(separate[n], &mvp);
+    }
+}
+
+static struct pointCloud_t *pooled[EXPLOSIONS];
+
+static void pooledFrame(struct pointCloudPool_t *pool, kmMat4 *vp, int frame)
+{
+    pool->tick = frame * 0.05f;
+    for (int n = 0; n < EXPLOSIONS; n++) {
+        if (!starting(n, frame)) continue;
+        if (pooled[n]) freePointCloud(pooled[n]);
+        pooled[n] = allocPointCloud(pool);
+        fill(pooled[n], &where[n], pool->tick);
+    }
+    glClear(GL_COLOR_BUFFER_BIT);
+    drawPointCloudPool(pool, vp);
+}
+
+int main()
+{
+    if (!benchGlContext(SIZE, SIZE)) return 1;
+
+    GLuint tex;
+    unsigned char white[4] = { 255, 255, 255, 255 };
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glClearColor(0, 0, 0, 1);
+    glViewport(0, 0, SIZE, SIZE);
+    initPointClouds("resources/shaders/particle.vert", "resources/shaders/particle.frag", 2);
+
+    srand(1);
+    for (int n = 0; n < EXPLOSIONS; n++)
+        kmVec3Fill(&where[n], rand_range(-4, 8), rand_range(-3, 6), rand_range(-4, 4));
+    for (int i = 0; i < POINTS; i++) {
+        kmVec3Fill(&vel[i], rand_range(-1, 2), rand_range(-1, 2), rand_range(-1, 2));
+        kmVec3Normalize(&vel[i], &vel[i]);
+    }
+
+    kmMat4 projection, view, vp;
+    kmVec3 eye = { 0, 0, 8 }, centre = { 0, 0, 0 }, up = { 0, 1, 0 };
+    kmMat4PerspectiveProjection(&projection, 45, 1, 0.1, 20);
+    kmMat4LookAt(&view, &eye, &centre, &up);
+    kmMat4Multiply(&vp, &projection, &view);
+
+    struct pointCloudPool_t *pool = createPointCloudPool(EXPLOSIONS, POINTS);
+
+    printf("%d explosions of %d points, %d started a frame\n",
+           EXPLOSIONS, POINTS, EXPLOSIONS / LIFE);
+    double start = benchNow();
+    for (int f = 0; f < FRAMES; f++) {
+        separateFrame(&vp, f);
+        glFinish();
+    }
+    benchReport("  a cloud each", benchNow() - start, FRAMES);
+    glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, oldPixels);
+
+    start = benchNow();
+    for (int f = 0; f < FRAMES; f++) {
+        pooledFrame(pool, &vp, f);
+        glFinish();
+    }
+    benchReport("  pooled", benchNow() - start, FRAMES);
+    glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, newPixels);
+
+    // just taking and giving back clouds, one is given back for the pool to have room
+    freePointCloud(pooled[0]);
+    pooled[0] = NULL;
+    start = benchNow();
+    for (int f = 0; f < FRAMES * 100; f++) {
+        struct pointCloud_t *pntC = createBallisticPointCloud(POINTS);
+        freePointCloud(pntC);
+    }
+    benchReport("  createBallisticPointCloud and freePointCloud", benchNow() - start, FRAMES * 100);
+    start = benchNow();
+    for (int f = 0; f < FRAMES * 100; f++) {
+        struct pointCloud_t *pntC = allocPointCloud(pool);
+        freePointCloud(pntC);
+    }
+    benchReport("  allocPointCloud and freePointCloud", benchNow() - start, FRAMES * 100);
+
+    // freeing a cloud twice mustn't hand it out twice
+    struct pointCloud_t *twice = allocPointCloud(pool);
+    freePointCloud(twice);
+    freePointCloud(twice);
+    struct pointCloud_t *first = allocPointCloud(pool), *second = allocPointCloud(pool);
+    int shared = first && first == second;
+    printf("\na cloud freed twice is handed out %s\n", shared ? "twice WRONG" : "once");
+    if (first) freePointCloud(first);
+    if (second) freePointCloud(second);
+
+    int different = 0;
+    for (int i = 0; i < SIZE * SIZE * 4; i += 4)
+        different += memcmp(oldPixels + i, newPixels + i, 4) != 0;
+    printf("\n%d of %d pixels differ\n", different, SIZE * SIZE);
+
+    for (int n = 0; n < EXPLOSIONS; n++) freePointCloud(separate[n]);
+    freePointCloudPool(pool);
+    return different > SIZE * SIZE / 1000 || shared;
+}
@@ -0,0 +1,83 @@
+/*
+ * startup cost of shader programs, run from the top directory so the
+ * resources can be found
+ *
+ * the way objs used to be made (compiling and linking their own program)
+ * is compared with the shared program registry, then N meshes are loaded
+ * with loadObj to check the shaders are only compiled once
+ *
+ * the mesa shader cache is turned off so every compile is a real one
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "support.h"
+#include "obj.h"
+#include "egl.h"
+#include "bench.h"
+
+#define OBJS 50
+
+#define VERT "resources/shaders/textured.vert"
+#define FRAG "resources/shaders/textured.frag"
+
+static const char *uniforms[] = {
+    "mvp_uniform", "mv_uniform", "u_texture", "u_lightDir", "u_viewDir"
+};
+static const char *attribs[] = { "vertex_attrib", "uv_attrib", "norm_attrib" };
+
+// what createObj used to do for every obj
+static GLuint oldProgram()
+{
+    GLuint vs = create_shader(VERT, GL_VERTEX_SHADER);
+    GLuint fs = create_shader(FRAG, GL_FRAGMENT_SHADER);
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, vs);
+    glAttachShader(prog, fs);
+    glLinkProgram(prog);
+    for (int i = 0; i < 3; i++) benchSink = glGetAttribLocation(prog, attribs[i]);
+    for (int i = 0; i < 5; i++) benchSink = glGetUniformLocation(prog, uniforms[i]);
+    return prog;
+}
+
+int main()
+{
+    setenv("MESA_SHADER_CACHE_DISABLE", "true", 1);
+    if (!benchGlContext(64, 64)) return 1;
+
+    GLuint old[OBJS];
+    double start = benchNow();
+    for (int i = 0; i < OBJS; i++) old[i] = oldProgram();
+    glFinish();
+    benchReport("program per obj", benchNow() - start, OBJS);
+    for (int i = 0; i < OBJS; i++) glDeleteProgram(old[i]);
+
+    struct program_t *progs[OBJS];
+    start = benchNow();
+    for (int i = 0; i < OBJS; i++) {
+        progs[i] = getProgram(VERT, FRAG, NULL);
+        for (int j = 0; j < 3; j++) benchSink = programLocation(progs[i], shaderAttrib, attribs[j]);
+        for (int j = 0; j < 5; j++) benchSink = programLocation(progs[i], shaderUniform, uniforms[j]);
+    }
+    glFinish();
+    benchReport("shared program", benchNow() - start, OBJS);
+    for (int i = 0; i < OBJS; i++) releaseProgram(progs[i]);
+
+    // every release was matched so the program has gone, loadObj compiles it again
+    struct obj_t objs[OBJS];
+    int compiled, loaded;
+    start = benchNow();
+    for (int i = 0; i < OBJS; i++)
+        loadObj(&objs[i], "resources/models/alien.gbo", VERT, FRAG);
+    glFinish();
+    benchReport("loadObj", benchNow() - start, OBJS);
+
+    getProgramStats(&compiled, &loaded);
+    printf("\n%i objs loaded, %i programs compiled in total, %i still loaded\n",
+           OBJS, compiled, loaded);
+
+    for (int i = 0; i < OBJS; i++) freeObj(&objs[i]);
+    getProgramStats(&compiled, &loaded);
+    printf("after freeing the objs %i programs are loaded\n", loaded);
+    return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * ray against triangle tests per second on the sphere and ground meshes,
+ * kmRay3IntersectTriangle called for each triangle against walking the
+ * GBO arrays with kmRay3IntersectTriangles, run from the top directory so
+ * the models can be found
+ *
+ * kmRay3IntersectAABB is checked against the 12 triangles of each box and
+ * kmRay3IntersectSphere against the distance from the centre to the ray,
+ * exits with 1 if anything disagrees
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <kazmath.h>
+#include "gbo.h"
+#include "bench.h"
+
+#ifndef RAYS
+#define RAYS 10000
+#endif
+#define CHECKS 100000
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+static void randomVec3(kmVec3 *v, float min, float max)
+{
+    kmVec3Fill(v, randomRange(min, max), randomRange(min, max), randomRange(min, max));
+}
+
+// from outside the bounding sphere towards somewhere inside it
+static void randomRay(kmRay3 *ray, const float *bounds)
+{
+    kmVec3 centre = { bounds[0], bounds[1], bounds[2] }, target, dir;
+    randomVec3(&dir, -1, 1);
+    kmVec3Normalize(&dir, &dir);
+    kmVec3Scale(&dir, &dir, bounds[3] * 3);
+    kmVec3Add(&ray->start, &centre, &dir);
+    randomVec3(&target, -bounds[3], bounds[3]);
+    kmVec3Add(&target, &target, &centre);
+    kmVec3Subtract(&ray->dir, &target, &ray->start);
+    kmVec3Normalize(&ray->dir, &ray->dir);
+}
+
+static kmVec3 *vertex(const struct gboMesh *m, unsigned int i)
+{
+    return (kmVec3 *)(m->verts + 3 * (m->indices ? m->indices[i] : i));
+}
+
+static int mesh(const char *filename)
+{
+    static kmRay3 rays[RAYS];
+    static kmScalar single[RAYS], batch[RAYS];
+    struct gboFile gbo;
+    int hits = 0, wrong = 0;
+    double start, t;
+
+    if (!gboRead(&gbo, filename)) {
+        printf("can't read %s\n", filename);
+        return 1;
+    }
+    struct gboMesh *m = &gbo.lod[0];
+    unsigned int count = m->numIndices ? m->numIndices : m->numVerts;
+    long tests = (long)RAYS * (count / 3);
+
+    for (int r = 0; r < RAYS; r++) randomRay(&rays[r], gbo.bounds);
+
+    start = benchNow();
+    for (int r = 0; r < RAYS; r++) {
+        single[r] = FLT_MAX;
+        for (unsigned int i = 0; i < count; i += 3) {
+            kmScalar d;
+            if (kmRay3IntersectTriangle(&rays[r], vertex(m, i), vertex(m, i + 1), vertex(m, i + 2),
+                                        NULL, NULL, &d) && d < single[r])
+                single[r] = d;
+        }
+    }
+    t = benchNow() - start;
+
+    printf("%s, %u triangles\n", filename, count / 3);
+    benchReport("  kmRay3IntersectTriangle", t, tests);
+    printf("  %40s %.1f million triangles/s\n", "", tests / t / 1e6);
+
+    start = benchNow();
+    for (int r = 0; r < RAYS; r++) {
+        batch[r] = FLT_MAX;
+        kmRay3IntersectTriangles(&rays[r], m->verts, m->indices, count, &batch[r]);
+    }
+    t = benchNow() - start;
+
+    benchReport("  kmRay3IntersectTriangles", t, tests);
+    printf("  %40s %.1f million triangles/s\n", "", tests / t / 1e6);
+
+    for (int r = 0; r < RAYS; r++) {
+        if (batch[r] != FLT_MAX) hits++;
+        if (fabsf(single[r] - batch[r]) > 1e-4f * single[r]) wrong++;
+    }
+    printf("  %i of %i rays hit, %i disagree\n\n", hits, RAYS, wrong);
+
+    gboFree(&gbo);
+    return wrong;
+}
+
+// the nearest of the 12 triangles making up the box's faces
+static int boxTriangles(const kmRay3 *ray, const kmAABB *box, kmScalar *d)
+{
+    static const unsigned short faces[36] = {
+        0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6, 0, 4, 5, 0, 5, 1,
+        3, 2, 6, 3, 6, 7, 0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2
+    };
+    kmScalar corners[24];
+    for (int i = 0; i < 8; i++) {
+        corners[i * 3] = (i == 1 || i == 2 || i == 5 || i == 6) ? box->max.x : box->min.x;
+        corners[i * 3 + 1] = (i == 2 || i == 3 || i == 6 || i == 7) ? box->max.y : box->min.y;
+        corners[i * 3 + 2] = i >= 4 ? box->max.z : box->min.z;
+    }
+    *d = FLT_MAX;
+    return kmRay3IntersectTriangles(ray, corners, faces, 36, d) != -1;
+}
+
+static int checks()
+{
+    int wrong = 0, hits = 0;
+
+    for (int i = 0; i < CHECKS; i++) {
+        kmRay3 ray;
+        kmAABB box;
+        kmVec3 centre;
+        kmScalar d, boxD;
+        float bounds[4] = { 0, 0, 0, 10 };
+
+        randomRay(&ray, bounds);
+        randomVec3(&centre, -5, 5);
+        kmAABBInitialize(&box, &centre, randomRange(.5, 5), randomRange(.5, 5), randomRange(.5, 5));
+        int hit = kmRay3IntersectAABB(&ray, &box, NULL, &d);
+        int triHit = boxTriangles(&ray, &box, &boxD);
+        if (hit != triHit) wrong++;
+        else if (hit && fabsf(d - boxD) > 1e-4f * d) wrong++;
+
+        kmScalar radius = randomRange(.5, 5);
+        kmVec3 p, toCentre, closest;
+        hit = kmRay3IntersectSphere(&ray, &centre, radius, &p, &d);
+        hits += hit;
+        kmVec3Subtract(&toCentre, &centre, &ray.start);
+        kmVec3Scale(&closest, &ray.dir, kmVec3Dot(&toCentre, &ray.dir));
+        kmVec3Subtract(&closest, &toCentre, &closest);
+        kmScalar miss = kmVec3Length(&closest) - radius;
+        if (hit) {
+            kmVec3Subtract(&p, &p, &centre);
+            if (fabsf(kmVec3Length(&p) - radius) > 1e-4f * radius) wrong++;
+        } else if (miss < -1e-4f) {
+            wrong++;
+        }
+    }
+    printf("%i random rays against boxes and spheres (%i hit the sphere), %i wrong\n\n",
+           CHECKS, hits, wrong);
+    return wrong;
+}
+
+int main()
+{
+    int wrong = 0;
+    srand(1);
+    wrong += checks();
+    wrong += mesh("resources/models/sphere.gbo");
+    wrong += mesh("resources/models/ground.gbo");
+    return wrong != 0;
+}
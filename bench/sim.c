@@ -0,0 +1,198 @@
+/*
+ * a simulation on its own thread handing snapshots to the render loop
+ * through a triple buffer, against stepping it before each render as the
+ * physics examples did.  The simulation moves 4096 bodies then spends 4ms
+ * (standing in for physics), rendering checks the snapshot and spends 4ms
+ * (standing in for GL).  First the triple buffer alone, a thread
+ * publishing as fast as it can while this one reads
+ *
+ * every snapshot has its step number written through it, exits with 1 if
+ * one is ever seen half written or older than the one before
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "tinycthread.h"
+#include "sim.h"
+#include "bench.h"
+
+#define PUBLISHES 1000000
+#define BODIES 4096
+#define STEP (1 / 100.0)
+#define SIM_WORK 0.004
+#define RENDER_WORK 0.004
+#define SECONDS 2.0
+
+static float upTo(float most)
+{
+    return most * rand() / RAND_MAX;
+}
+
+static void busy(double seconds)
+{
+    double until = benchNow() + seconds;
+    while (benchNow() < until);
+}
+
+// what goes through the triple buffer on its own
+struct message_t {
+    long seq;
+    long copy[7];
+};
+
+static struct tripleBuffer_t messages;
+
+static int publisher(void *arg)
+{
+    for (long seq = 1; seq <= PUBLISHES; seq++) {
+        struct message_t *m = writingBuffer(&messages);
+        m->seq = seq;
+        for (int i = 0; i < 7; i++) m->copy[i] = seq;
+        publishBuffer(&messages);
+    }
+    return 0;
+}
+
+struct world_t {
+    long tick;
+    float pos[BODIES][3], vel[BODIES][3];
+};
+
+// what the renderer needs, w is the step each position is from
+struct scene_t {
+    long tick;
+    float body[BODIES][4];
+};
+
+static struct world_t world;
+static struct scene_t serialScene;
+
+static void stepWorld(void *data, void *snapshot, double step)
+{
+    struct world_t *w = data;
+    struct scene_t *scene = snapshot;
+    w->tick++;
+    for (int i = 0; i < BODIES; i++) {
+        for (int j = 0; j < 3; j++) {
+            w->pos[i][j] += w->vel[i][j] * step;
+            if (w->pos[i][j] < -10 || w->pos[i][j] > 10) w->vel[i][j] = -w->vel[i][j];
+        }
+    }
+    busy(SIM_WORK);
+
+    scene->tick = w->tick;
+    for (int i = 0; i < BODIES; i++) {
+        scene->body[i][0] = w->pos[i][0];
+        scene->body[i][1] = w->pos[i][1];
+        scene->body[i][2] = w->pos[i][2];
+        scene->body[i][3] = w->tick;
+    }
+}
+
+// returns 0 if any of the scene is from another step
+static int render(const struct scene_t *scene)
+{
+    int whole = 1;
+    float sum = 0;
+    for (int i = 0; i < BODIES; i++) {
+        whole &= scene->body[i][3] == (float)scene->tick;
+        sum += scene->body[i][0] + scene->body[i][1] + scene->body[i][2];
+    }
+    benchSink = sum;
+    busy(RENDER_WORK);
+    return whole;
+}
+
+static void resetWorld()
+{
+    srand(1);
+    world.tick = 0;
+    for (int i = 0; i < BODIES; i++) {
+        for (int j = 0; j < 3; j++) {
+            world.pos[i][j] = upTo(20) - 10;
+            world.vel[i][j] = upTo(4) - 2;
+        }
+    }
+}
+
+static int wrong = 0;
+
+static void check(const char *name, int ok)
+{
+    printf("  %-60s %s\n", name, ok ? "ok" : "WRONG");
+    wrong |= !ok;
+}
+
+int main()
+{
+    printf("triple buffer, %d publishes\n", PUBLISHES);
+    initTripleBuffer(&messages, sizeof(struct message_t));
+    thrd_t thread;
+    double start = benchNow();
+    thrd_create(&thread, publisher, NULL);
+    long last = 0, reads = 0, torn = 0, backwards = 0;
+    while (last < PUBLISHES) {
+        const struct message_t *m = latestBuffer(&messages);
+        if (!m) continue;
+        for (int i = 0; i < 7; i++) torn += m->copy[i] != m->seq;
+        backwards += m->seq < last;
+        last = m->seq;
+        reads++;
+    }
+    double seconds = benchNow() - start;
+    thrd_join(thread, NULL);
+    freeTripleBuffer(&messages);
+    printf("  %-30s %8.1f ns a publish, %ld reads\n", "publish and read", seconds * 1e9 / PUBLISHES,
+           reads);
+    check("every read whole", !torn);
+    check("never older than the read before", !backwards);
+
+    printf("\n%d bodies, %.0fms to step and %.0fms to render\n", BODIES, SIM_WORK * 1e3,
+           RENDER_WORK * 1e3);
+
+    // step then render on the one thread
+    resetWorld();
+    long frames = 0;
+    int whole = 1;
+    start = benchNow();
+    while (benchNow() - start < SECONDS) {
+        stepWorld(&world, &serialScene, STEP);
+        whole &= render(&serialScene);
+        frames++;
+    }
+    seconds = benchNow() - start;
+    printf("  %-30s %6.1f frames a second, %6.1f steps a second, snapshots 0ms old\n",
+           "step then render", frames / seconds, world.tick / seconds);
+    check("every frame whole", whole);
+
+    // the simulation on its own thread at 100 steps a second
+    resetWorld();
+    struct simThread_t *sim = startSimThread(STEP, sizeof(struct scene_t), stepWorld, &world);
+    frames = 0;
+    whole = 1;
+    last = backwards = 0;
+    double sumAge = 0, oldest = 0;
+    start = benchNow();
+    while (benchNow() - start < SECONDS) {
+        double age;
+        const struct scene_t *scene = latestSnapshot(sim, &age);
+        if (!scene) continue;
+        whole &= render(scene);
+        backwards += scene->tick < last;
+        last = scene->tick;
+        sumAge += age;
+        if (age > oldest) oldest = age;
+        frames++;
+    }
+    seconds = benchNow() - start;
+    long steps = simSteps(sim);
+    stopSimThread(sim);
+    printf("  %-30s %6.1f frames a second, %6.1f steps a second, snapshots %.1fms old (at most %.1fms)\n",
+           "simulation thread", frames / seconds, steps / seconds, sumAge * 1e3 / frames,
+           oldest * 1e3);
+    check("every frame whole", whole);
+    check("never older than the frame before", !backwards);
+    check("the simulation ran", steps > 0 && frames > 0);
+
+    return wrong;
+}
@@ -0,0 +1,151 @@
+/*
+ * sortPointCloud (a radix sort by depth) against qsort on clouds of 10
+ * thousand to a million points, then sorted drawing against unsorted,
+ * run from the top directory so the shaders can be found
+ *
+ * every sort is checked to be furthest first, and a blended cloud is drawn
+ * sorted twice with its points in different orders, the pictures should
+ * be the same.  Exits with 1 if either check fails
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "support.h"
+#include "egl.h"
+#include "bench.h"
+
+#define MOST 1000000
+#define SIZE 128
+
+static float depth[MOST];
+static unsigned int order[MOST];
+static unsigned char firstPixels[SIZE * SIZE * 4], pixels[SIZE * SIZE * 4];
+
+static int furthestFirst(const void *a, const void *b)
+{
+    float da = depth[*(const unsigned int *)a], db = depth[*(const unsigned int *)b];
+    return (da < db) - (da > db);
+}
+
+static void fill(struct pointCloud_t *pntC)
+{
+    srand(1);
+    for (int i = 0; i < pntC->totalPoints * 3; i++) pntC->pos[i] = rand_range(-1, 1);
+    if (pntC->size) {
+        for (int i = 0; i < pntC->totalPoints; i++) {
+            pntC->size[i] = 8;
+            for (int k = 0; k < 4; k++) pntC->color[i * 4 + k] = 64 + (rand() & 127);
+        }
+    }
+}
+
+// furthest first, and every point is there
+static int checkSorted(struct pointCloud_t *pntC, unsigned int *sorted)
+{
+    static unsigned char seen[MOST];
+    memset(seen, 0, pntC->totalPoints);
+    for (int i = 0; i < pntC->totalPoints; i++) {
+        if (sorted[i] >= (unsigned int)pntC->totalPoints || seen[sorted[i]]++) return 0;
+        if (i && depth[sorted[i]] > depth[sorted[i - 1]]) return 0;
+    }
+    return 1;
+}
+
+static void picture(unsigned char *out, struct pointCloud_t *pntC, kmMat4 *mvp)
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    drawPointCloud(pntC, mvp);
+    glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, out);
+}
+
+int main()
+{
+    if (!benchGlContext(SIZE, SIZE)) return 1;
+
+    GLuint tex;
+    unsigned char white[4] = { 255, 255, 255, 255 };
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glClearColor(0, 0, 0, 1);
+    glViewport(0, 0, SIZE, SIZE);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    initPointClouds("resources/shaders/particle.vert", "resources/shaders/particle.frag", 1);
+
+    kmMat4 projection, view, mvp;
+    kmVec3 eye = { 0.5, 1, 3 }, centre = { 0, 0, 0 }, up = { 0, 1, 0 };
+    kmMat4PerspectiveProjection(&projection, 45, 1, 0.1, 10);
+    kmMat4LookAt(&view, &eye, &centre, &up);
+    kmMat4Multiply(&mvp, &projection, &view);
+
+    int wrong = 0;
+    for (int points = 10000; points <= MOST; points *= 10) {
+        struct pointCloud_t *pntC = createPointCloud(points);
+        setPointCloudSorted(pntC, 1);
+        fill(pntC);
+        for (int i = 0; i < points; i++) {
+            float *p = pntC->pos + i * 3;
+            depth[i] = mvp.mat[2] * p[0] + mvp.mat[6] * p[1] + mvp.mat[10] * p[2] + mvp.mat[14];
+        }
+        int iters = MOST / points * 2;
+
+        printf("%d points\n", points);
+        unsigned int *sorted = NULL;
+        double start = benchNow();
+        for (int n = 0; n < iters; n++) sorted = sortPointCloud(pntC, &mvp);
+        benchReport("  sortPointCloud", benchNow() - start, iters);
+        if (!checkSorted(pntC, sorted)) {
+            printf("  not furthest first\n");
+            wrong = 1;
+        }
+
+        start = benchNow();
+        for (int n = 0; n < iters; n++) {
+            for (int i = 0; i < points; i++) order[i] = i;
+            qsort(order, points, sizeof(unsigned int), furthestFirst);
+        }
+        benchReport("  qsort", benchNow() - start, iters);
+
+        // mostly the software renderer, the sort is the difference
+        start = benchNow();
+        for (int n = 0; n < 4; n++) {
+            drawPointCloud(pntC, &mvp);
+            glFinish();
+        }
+        benchReport("  drawn sorted", benchNow() - start, 4);
+        setPointCloudSorted(pntC, 0);
+        start = benchNow();
+        for (int n = 0; n < 4; n++) {
+            drawPointCloud(pntC, &mvp);
+            glFinish();
+        }
+        benchReport("  drawn unsorted", benchNow() - start, 4);
+        freePointCloud(pntC);
+    }
+
+    // blending only gives the same picture whatever order they're given in if sorted
+    struct pointCloud_t *pntC = createPointCloudAttribs(10000);
+    setPointCloudSorted(pntC, 1);
+    fill(pntC);
+    picture(firstPixels, pntC, &mvp);
+    for (int i = 0; i < 10000; i++) {
+        int j = rand() % 10000;
+        float p[3], s = pntC->size[i];
+        unsigned char c[4];
+        memcpy(p, pntC->pos + i * 3, sizeof(p));
+        memcpy(pntC->pos + i * 3, pntC->pos + j * 3, sizeof(p));
+        memcpy(pntC->pos + j * 3, p, sizeof(p));
+        pntC->size[i] = pntC->size[j];
+        pntC->size[j] = s;
+        memcpy(c, pntC->color + i * 4, 4);
+        memcpy(pntC->color + i * 4, pntC->color + j * 4, 4);
+        memcpy(pntC->color + j * 4, c, 4);
+    }
+    picture(pixels, pntC, &mvp);
+    int different = memcmp(pixels, firstPixels, sizeof(pixels)) != 0;
+    printf("\nshuffled blended cloud drawn sorted, pictures %s\n", different ? "differ" : "match");
+    freePointCloud(pntC);
+
+    return wrong || different;
+}
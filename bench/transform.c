@@ -0,0 +1,130 @@
+/*
+ * 50k transform nodes (10k objects with 4 children each) with 5% of them
+ * moving each frame
+ *
+ * naive        rebuilds every model matrix, world, mv and mvp each frame the
+ *              way the examples do
+ * transforms   updateTransforms with the camera still and then moving
+ *
+ * the results are checked against the naive matrices
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <kazmath.h>
+#include "transform.h"
+#include "bench.h"
+
+#define OBJECTS 10000
+#define CHILDREN 4
+#define NODES (OBJECTS * (CHILDREN + 1))
+#define MOVING (NODES / 20)
+#define FRAMES 100
+
+struct pose {
+    kmVec3 pos;
+    float pitch, yaw, roll;
+};
+
+int parent[NODES];
+struct pose poses[NODES];
+kmMat4 model[NODES], world[NODES], mv[NODES], mvp[NODES];
+int movers[FRAMES][MOVING];
+
+static void randomPose(struct pose *p)
+{
+    p->pos.x = rand() % 200 - 100;
+    p->pos.y = rand() % 200 - 100;
+    p->pos.z = rand() % 200 - 100;
+    p->pitch = (rand() % 628) / 100.f;
+    p->yaw = (rand() % 628) / 100.f;
+    p->roll = (rand() % 628) / 100.f;
+}
+
+static void camera(kmMat4 *view, int frame)
+{
+    kmVec3 eye = { 0, 50, 300 }, centre = { 0, 0, 0 }, up = { 0, 1, 0 };
+    eye.x = frame;
+    kmMat4LookAt(view, &eye, &centre, &up);
+}
+
+static void naiveFrame(kmMat4 *view, kmMat4 *projection)
+{
+    kmMat4 vp, rot;
+    kmMat4Multiply(&vp, projection, view);
+    for (int i = 0; i < NODES; i++) {
+        struct pose *p = &poses[i];
+        kmMat4Translation(&model[i], p->pos.x, p->pos.y, p->pos.z);
+        kmMat4RotationYawPitchRoll(&rot, p->pitch, p->yaw, p->roll);
+        kmMat4Multiply(&model[i], &model[i], &rot);
+        if (parent[i] == -1) world[i] = model[i];
+        else kmMat4Multiply(&world[i], &world[parent[i]], &model[i]);
+        kmMat4Multiply(&mvp[i], &vp, &world[i]);
+        kmMat4Multiply(&mv[i], view, &world[i]);
+    }
+}
+
+static void run(const char *name, int movingCamera)
+{
+    struct transforms_t *t = createTransforms(NODES);
+    kmMat4 view, projection;
+    long recalculated = 0;
+    double time = 0, naiveTime = 0;
+    int mismatches = 0;
+
+    srand(1);
+    kmMat4PerspectiveProjection(&projection, 45, 4.0 / 3.0, 1, 1000);
+    camera(&view, 0);
+    for (int i = 0; i < NODES; i++) {
+        parent[i] = i < OBJECTS ? -1 : (i - OBJECTS) / CHILDREN;
+        randomPose(&poses[i]);
+        addTransform(t, parent[i]);
+        setTransform(t, i, poses[i].pos, poses[i].pitch, poses[i].yaw, poses[i].roll);
+    }
+    updateTransforms(t, &view, &projection);
+
+    for (int f = 0; f < FRAMES; f++) {
+        if (movingCamera) camera(&view, f + 1);
+        for (int m = 0; m < MOVING; m++) {
+            struct pose *p = &poses[movers[f][m]];
+            p->pos.x += 1;
+            p->yaw += .01f;
+        }
+
+        double start = benchNow();
+        for (int m = 0; m < MOVING; m++) {
+            int i = movers[f][m];
+            struct pose *p = &poses[i];
+            setTransform(t, i, p->pos, p->pitch, p->yaw, p->roll);
+        }
+        recalculated += updateTransforms(t, &view, &projection);
+        time += benchNow() - start;
+
+        start = benchNow();
+        naiveFrame(&view, &projection);
+        naiveTime += benchNow() - start;
+    }
+
+    mismatches = memcmp(t->mvp, mvp, sizeof(mvp)) != 0;
+    mismatches += memcmp(t->mv, mv, sizeof(mv)) != 0;
+
+    printf("%s: %li of %i world matrices per frame, %s naive\n", name,
+           recalculated / FRAMES, NODES, mismatches ? "DIFFERENT TO" : "identical to");
+    benchReport("  naive, per frame", naiveTime / FRAMES, NODES);
+    benchReport("  transforms, per frame", time / FRAMES, NODES);
+    printf("  %.1fx faster\n\n", naiveTime / time);
+
+    freeTransforms(t);
+}
+
+int main()
+{
+    srand(2);
+    for (int f = 0; f < FRAMES; f++)
+        for (int m = 0; m < MOVING; m++) movers[f][m] = rand() % NODES;
+
+    printf("%i nodes, %i moving per frame, %i frames\n\n", NODES, MOVING, FRAMES);
+    run("still camera", 0);
+    run("moving camera", 1);
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * building 10,000 model matrices from Euler angles (translation *
+ * kmMat4RotationYawPitchRoll * scaling, as the examples do) against
+ * kmTRSToMat4, and animating their rotations between two key frames with
+ * kmQuaternionSlerp one at a time, kmQuaternionStreamSlerp and
+ * kmQuaternionStreamNlerp.  Exits with 1 if the TRS matrices or the stream
+ * slerp differ from the originals by more than 1e-5
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <kazmath.h>
+#include "bench.h"
+
+#define OBJECTS 10000
+#define REPEATS 200
+
+kmVec3 positions[OBJECTS], scales[OBJECTS], angles[OBJECTS], endAngles[OBJECTS];
+kmTRS trs[OBJECTS];
+kmQuaternion start[OBJECTS], end[OBJECTS], slerped[OBJECTS];
+kmScalar sx[OBJECTS], sy[OBJECTS], sz[OBJECTS], sw[OBJECTS];
+kmScalar ex[OBJECTS], ey[OBJECTS], ez[OBJECTS], ew[OBJECTS];
+kmScalar ox[OBJECTS], oy[OBJECTS], oz[OBJECTS], ow[OBJECTS];
+kmMat4 models[OBJECTS];
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+static void randomVec3(kmVec3 *v, float min, float max)
+{
+    kmVec3Fill(v, randomRange(min, max), randomRange(min, max), randomRange(min, max));
+}
+
+static void euler(kmMat4 *m, const kmVec3 *pos, const kmVec3 *a, const kmVec3 *scale)
+{
+    kmMat4 rot, s;
+    kmMat4Translation(m, pos->x, pos->y, pos->z);
+    kmMat4RotationYawPitchRoll(&rot, a->x, a->y, a->z);
+    kmMat4Multiply(m, m, &rot);
+    kmMat4Scaling(&s, scale->x, scale->y, scale->z);
+    kmMat4Multiply(m, m, &s);
+}
+
+static double matrixError()
+{
+    double worst = 0;
+    for (int i = 0; i < OBJECTS; i++) {
+        kmMat4 m, scaled;
+        euler(&m, &positions[i], &angles[i], &scales[i]);
+        kmTRSToMat4(&scaled, &trs[i]);
+        for (int j = 0; j < 16; j++) {
+            // relative to the size of the column
+            double e = fabs(m.mat[j] - scaled.mat[j]) / (j < 12 ? (&scales[i].x)[j / 4] : 1);
+            if (e > worst) worst = e;
+        }
+    }
+    return worst;
+}
+
+// kmQuaternionSlerp doesn't take the shorter way round, the streams do
+static void slerpEach(kmScalar t)
+{
+    for (int i = 0; i < OBJECTS; i++) {
+        kmQuaternion q2 = end[i];
+        if (kmQuaternionDot(&start[i], &q2) < 0) kmQuaternionScale(&q2, &q2, -1);
+        kmQuaternionSlerp(&slerped[i], &start[i], &q2, t);
+    }
+}
+
+static double streamError(const kmQuaternionStream *out)
+{
+    double worst = 0;
+    for (int i = 0; i < OBJECTS; i++) {
+        kmQuaternion q;
+        kmQuaternionStreamGet(&q, out, i);
+        // q and -q are the same rotation
+        if (kmQuaternionDot(&q, &slerped[i]) < 0) kmQuaternionScale(&q, &q, -1);
+        double e = fmax(fmax(fabs(q.x - slerped[i].x), fabs(q.y - slerped[i].y)),
+                        fmax(fabs(q.z - slerped[i].z), fabs(q.w - slerped[i].w)));
+        if (e > worst) worst = e;
+    }
+    return worst;
+}
+
+int main()
+{
+    kmQuaternionStream q1, q2, out;
+    double t0, error, slerpError = 0, nlerpError = 0;
+    long calls = (long)OBJECTS * REPEATS;
+
+    srand(1);
+    kmQuaternionStreamFill(&q1, sx, sy, sz, sw);
+    kmQuaternionStreamFill(&q2, ex, ey, ez, ew);
+    kmQuaternionStreamFill(&out, ox, oy, oz, ow);
+    for (int i = 0; i < OBJECTS; i++) {
+        randomVec3(&positions[i], -100, 100);
+        randomVec3(&scales[i], .1, 10);
+        randomVec3(&angles[i], -3, 3);
+        randomVec3(&endAngles[i], -3, 3);
+        // some nearly the same as their start to use the linear case
+        if (i % 10 == 0) kmVec3Add(&endAngles[i], &angles[i], &(kmVec3){ .01, 0, 0 });
+        kmTRSRotationYawPitchRoll(&start[i], angles[i].x, angles[i].y, angles[i].z);
+        kmTRSRotationYawPitchRoll(&end[i], endAngles[i].x, endAngles[i].y, endAngles[i].z);
+        kmTRSFill(&trs[i], &positions[i], &start[i], &scales[i]);
+        kmQuaternionStreamSet(&q1, i, &start[i]);
+        kmQuaternionStreamSet(&q2, i, &end[i]);
+    }
+
+#define TIME(name, code) \
+    t0 = benchNow(); \
+    for (int r = 0; r < REPEATS; r++) { code; } \
+    benchReport(name, benchNow() - t0, calls);
+
+    printf("model matrix from\n");
+    TIME("  Euler angles",
+         for (int i = 0; i < OBJECTS; i++) euler(&models[i], &positions[i], &angles[i], &scales[i]))
+    TIME("  kmTRSToMat4",
+         for (int i = 0; i < OBJECTS; i++) kmTRSToMat4(&models[i], &trs[i]))
+    TIME("  Euler via kmTRSRotationYawPitchRoll",
+         for (int i = 0; i < OBJECTS; i++) {
+             kmTRSRotationYawPitchRoll(&trs[i].rotation, angles[i].x, angles[i].y, angles[i].z);
+             kmTRSToMat4(&models[i], &trs[i]);
+         })
+    error = matrixError();
+    printf("  largest difference %.3g\n\n", error);
+
+    printf("interpolating rotations\n");
+    TIME("  lerped Euler angles",
+         kmScalar t = (r + 1.0f) / REPEATS;
+         for (int i = 0; i < OBJECTS; i++) {
+             kmVec3 a;
+             kmVec3Subtract(&a, &endAngles[i], &angles[i]);
+             kmVec3Scale(&a, &a, t);
+             kmVec3Add(&a, &a, &angles[i]);
+             kmMat4RotationYawPitchRoll(&models[i], a.x, a.y, a.z);
+         })
+    TIME("  kmQuaternionSlerp", slerpEach((r + 1.0f) / REPEATS))
+    TIME("  kmQuaternionStreamSlerp", kmQuaternionStreamSlerp(&out, &q1, &q2, (r + 1.0f) / REPEATS, OBJECTS))
+    TIME("  kmQuaternionStreamNlerp", kmQuaternionStreamNlerp(&out, &q1, &q2, (r + 1.0f) / REPEATS, OBJECTS))
+
+    for (int k = 0; k <= 20; k++) {
+        kmScalar t = k / 20.0f;
+        slerpEach(t);
+        kmQuaternionStreamSlerp(&out, &q1, &q2, t, OBJECTS);
+        slerpError = fmax(slerpError, streamError(&out));
+        kmQuaternionStreamNlerp(&out, &q1, &q2, t, OBJECTS);
+        nlerpError = fmax(nlerpError, streamError(&out));
+    }
+    printf("  largest difference from kmQuaternionSlerp, stream slerp %.3g, nlerp %.3g\n",
+           slerpError, nlerpError);
+
+    return error > 1e-5 || slerpError > 1e-5;
+}
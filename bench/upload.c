@@ -0,0 +1,97 @@
+/*
+ * frames of a point cloud moved on the CPU and uploaded by drawPointCloud
+ * with each setPointCloudUpload strategy, the frames aren't waited for
+ * (only flushed as a swap would) so an upload into a buffer an earlier
+ * frame is still drawing from can stall, run from the top directory so
+ * the shaders can be found
+ *
+ * each strategy's last frame is read back and compared with glBufferSubData,
+ * exits with 1 if any pixel differs
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "support.h"
+#include "egl.h"
+#include "bench.h"
+
+#define POINTS 100000
+#define FRAMES 30
+#define SIZE 256
+
+static unsigned char firstPixels[SIZE * SIZE * 4], pixels[SIZE * SIZE * 4];
+
+static void fill(struct pointCloud_t *pntC)
+{
+    srand(1);
+    for (int i = 0; i < POINTS; i++) {
+        for (int k = 0; k < 3; k++) {
+            pntC->pos[i * 3 + k] = rand_range(-1, 1);
+            pntC->vel[i * 3 + k] = rand_range(-0.01, 0.01);
+        }
+        pntC->size[i] = 2;
+        for (int k = 0; k < 4; k++) pntC->color[i * 4 + k] = rand() & 255;
+    }
+}
+
+static void frame(struct pointCloud_t *pntC, kmMat4 *mvp)
+{
+    for (int i = 0; i < POINTS * 3; i++) pntC->pos[i] += pntC->vel[i];
+    glClear(GL_COLOR_BUFFER_BIT);
+    drawPointCloud(pntC, mvp);
+    glFlush();
+}
+
+int main()
+{
+    if (!benchGlContext(SIZE, SIZE)) return 1;
+
+    GLuint tex;
+    unsigned char white[4] = { 255, 255, 255, 255 };
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glClearColor(0, 0, 0, 1);
+    glViewport(0, 0, SIZE, SIZE);
+    initPointClouds("resources/shaders/particle.vert", "resources/shaders/particle.frag", 1);
+
+    kmMat4 mvp;
+    kmMat4Identity(&mvp);
+
+    struct {
+        const char *name;
+        int upload, buffers;
+    } strategies[] = {
+        { "glBufferSubData", pointCloudSubData, 1 },
+        { "orphaned with glBufferData(NULL)", pointCloudOrphan, 1 },
+        { "round robin, 2 buffers", pointCloudRoundRobin, 2 },
+        { "round robin, 3 buffers", pointCloudRoundRobin, 3 },
+        { "round robin, 4 buffers", pointCloudRoundRobin, 4 },
+    };
+    int different = 0;
+
+    printf("%d points with size and colour, per frame\n", POINTS);
+    for (int s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+        struct pointCloud_t *pntC = createPointCloudAttribs(POINTS);
+        setPointCloudUpload(pntC, strategies[s].upload, strategies[s].buffers);
+        fill(pntC);
+        for (int f = 0; f < 5; f++) frame(pntC, &mvp);
+        glFinish();
+
+        // the last frame is finished with before the time is taken
+        double start = benchNow();
+        for (int f = 0; f < FRAMES; f++) frame(pntC, &mvp);
+        glFinish();
+        benchReport(strategies[s].name, benchNow() - start, FRAMES);
+
+        glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, s ? pixels : firstPixels);
+        if (s && memcmp(pixels, firstPixels, sizeof(pixels))) {
+            printf("  pictures differ\n");
+            different = 1;
+        }
+        freePointCloud(pntC);
+    }
+
+    return different;
+}
@@ -0,0 +1,149 @@
+/*
+ * the kmVec3Stream kernels against looping over an array of kmVec3 with
+ * the per vector kazmath functions, the results are checked against the
+ * scalar ones first (exits with 1 if anything is more than 1 ulp out)
+ *
+ * VECTORS and REPEATS can be changed with -D, VECTORS is deliberately not
+ * a multiple of 4 so the scalar remainder is used too
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <kazmath.h>
+#include "bench.h"
+
+#ifndef VECTORS
+#define VECTORS 10003
+#endif
+#ifndef REPEATS
+#define REPEATS 1000
+#endif
+
+kmVec3 a[VECTORS], b[VECTORS], out[VECTORS];
+kmScalar ax[VECTORS], ay[VECTORS], az[VECTORS];
+kmScalar bx[VECTORS], by[VECTORS], bz[VECTORS];
+kmScalar ox[VECTORS], oy[VECTORS], oz[VECTORS];
+kmScalar scalars[VECTORS], streamScalars[VECTORS];
+int worst;
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+static int32_t ordered(float f)
+{
+    int32_t i;
+    memcpy(&i, &f, sizeof(i));
+    return i < 0 ? INT32_MIN - i : i;
+}
+
+static void compare(float x, float y)
+{
+    int64_t d = (int64_t)ordered(x) - ordered(y);
+    if (d < 0) d = -d;
+    if (d > worst) worst = d > 1000000 ? 1000000 : (int)d;
+}
+
+static void check(const char *name, int vectors)
+{
+    int before = worst;
+    worst = 0;
+    for (int i = 0; i < VECTORS; i++) {
+        if (vectors) {
+            compare(out[i].x, ox[i]);
+            compare(out[i].y, oy[i]);
+            compare(out[i].z, oz[i]);
+        } else {
+            compare(scalars[i], streamScalars[i]);
+        }
+    }
+    printf("%-40s worst %i ulp\n", name, worst);
+    if (before > worst) worst = before;
+}
+
+int main()
+{
+    kmVec3Stream sa, sb, so;
+    kmMat4 m, rot;
+    kmScalar dt = 1 / 60.0f;
+    double start;
+
+    kmVec3StreamFill(&sa, ax, ay, az);
+    kmVec3StreamFill(&sb, bx, by, bz);
+    kmVec3StreamFill(&so, ox, oy, oz);
+
+    srand(1);
+    for (int i = 0; i < VECTORS; i++) {
+        kmVec3Fill(&a[i], randomRange(-100, 100), randomRange(-100, 100), randomRange(-100, 100));
+        kmVec3Fill(&b[i], randomRange(-10, 10), randomRange(-10, 10), randomRange(-10, 10));
+        kmVec3StreamSet(&sa, i, &a[i]);
+        kmVec3StreamSet(&sb, i, &b[i]);
+    }
+    // make sure normalize sees some zero vectors
+    for (int i = 0; i < VECTORS; i += 97) {
+        kmVec3Zero(&a[i]);
+        kmVec3StreamSet(&sa, i, &a[i]);
+    }
+    kmMat4Translation(&m, 1, 2, 3);
+    kmMat4RotationYawPitchRoll(&rot, .3, .2, .1);
+    kmMat4Multiply(&m, &m, &rot);
+
+    for (int i = 0; i < VECTORS; i++) kmVec3Transform(&out[i], &a[i], &m);
+    kmVec3StreamTransform(&so, &sa, &m, VECTORS);
+    check("kmVec3StreamTransform", 1);
+    for (int i = 0; i < VECTORS; i++) kmVec3TransformNormal(&out[i], &a[i], &m);
+    kmVec3StreamTransformNormal(&so, &sa, &m, VECTORS);
+    check("kmVec3StreamTransformNormal", 1);
+    for (int i = 0; i < VECTORS; i++) kmVec3Normalize(&out[i], &a[i]);
+    kmVec3StreamNormalize(&so, &sa, VECTORS);
+    check("kmVec3StreamNormalize", 1);
+    for (int i = 0; i < VECTORS; i++) kmVec3Cross(&out[i], &a[i], &b[i]);
+    kmVec3StreamCross(&so, &sa, &sb, VECTORS);
+    check("kmVec3StreamCross", 1);
+    for (int i = 0; i < VECTORS; i++) {
+        kmVec3Scale(&out[i], &b[i], dt);
+        kmVec3Add(&out[i], &a[i], &out[i]);
+    }
+    kmVec3StreamAddScaled(&so, &sa, &sb, dt, VECTORS);
+    check("kmVec3StreamAddScaled", 1);
+    kmVec3 gravity = { 0, -9.8f * dt, 0 };
+    for (int i = 0; i < VECTORS; i++) {
+        kmVec3Scale(&out[i], &b[i], 0.99f);
+        kmVec3Add(&out[i], &out[i], &gravity);
+    }
+    kmVec3StreamScaleAdd(&so, &sb, 0.99f, &gravity, VECTORS);
+    check("kmVec3StreamScaleAdd", 1);
+    for (int i = 0; i < VECTORS; i++) scalars[i] = kmVec3Dot(&a[i], &b[i]);
+    kmVec3StreamDot(streamScalars, &sa, &sb, VECTORS);
+    check("kmVec3StreamDot", 0);
+    for (int i = 0; i < VECTORS; i++) scalars[i] = kmVec3Length(&a[i]);
+    kmVec3StreamLength(streamScalars, &sa, VECTORS);
+    check("kmVec3StreamLength", 0);
+    printf("\n");
+
+#define TIME(name, code) \
+    start = benchNow(); \
+    for (int r = 0; r < REPEATS; r++) { code; } \
+    benchReport(name, benchNow() - start, REPEATS * VECTORS); \
+    benchSink = ox[VECTORS / 2] + out[VECTORS / 2].x + scalars[VECTORS / 2];
+
+    TIME("kmVec3Transform loop", for (int i = 0; i < VECTORS; i++) kmVec3Transform(&out[i], &a[i], &m))
+    TIME("kmVec3StreamTransform", kmVec3StreamTransform(&so, &sa, &m, VECTORS))
+    TIME("kmVec3Normalize loop", for (int i = 0; i < VECTORS; i++) kmVec3Normalize(&out[i], &a[i]))
+    TIME("kmVec3StreamNormalize", kmVec3StreamNormalize(&so, &sa, VECTORS))
+    TIME("kmVec3Cross loop", for (int i = 0; i < VECTORS; i++) kmVec3Cross(&out[i], &a[i], &b[i]))
+    TIME("kmVec3StreamCross", kmVec3StreamCross(&so, &sa, &sb, VECTORS))
+    TIME("kmVec3Scale, kmVec3Add loop", for (int i = 0; i < VECTORS; i++) {
+        kmVec3Scale(&out[i], &b[i], dt);
+        kmVec3Add(&out[i], &a[i], &out[i]);
+    })
+    TIME("kmVec3StreamAddScaled", kmVec3StreamAddScaled(&so, &sa, &sb, dt, VECTORS))
+    TIME("kmVec3Dot loop", for (int i = 0; i < VECTORS; i++) scalars[i] = kmVec3Dot(&a[i], &b[i]))
+    TIME("kmVec3StreamDot", kmVec3StreamDot(streamScalars, &sa, &sb, VECTORS))
+    TIME("kmVec3Length loop", for (int i = 0; i < VECTORS; i++) scalars[i] = kmVec3Length(&a[i]))
+    TIME("kmVec3StreamLength", kmVec3StreamLength(streamScalars, &sa, VECTORS))
+
+    return worst > 1;
+}
@@ -1,5 +1,6 @@
 #include "support.h"		// support routines
 #include <chipmunk.h>
+#include "loop.h"		// fixed timestep main loop
 
 /*
  *
@@ -51,7 +52,7 @@ font_t *font1;
 GLFWwindow* window;
 int width=640,height=480; // window width and height
 
-struct timespec ts;  // frame timing
+struct gameLoop_t loop;  // frame timing, 50 updates a second
 
 
 int main()
@@ -139,47 +140,49 @@ int main()
     bool quit = false;
 
 
+    initGameLoop(&loop, 1 / 50.0, 1 / 50.0);
+
     while (!quit) {		// the main loop
 
-        clock_gettime(0,&ts);  // note the time BEFORE we start to render the current frame
 		glfwPollEvents();
 
         if (glfwGetKey(window,GLFW_KEY_ESC)==GLFW_PRESS || glfwWindowShouldClose(window))
             quit = true;	// exit if escape key pressed or window closed
 
 
-        for (int i=0; i<max_clouds; i++) {
+        // the physics steps 50 times a second however long frames take
+        for (int n = startFrame(&loop); n > 0; n--) {
+            for (int i=0; i<max_clouds; i++) {
+
+                clouds[i].x=clouds[i].x-clouds[i].v;
+                if (clouds[i].x+clouds[i].w<0) {
+                    float size=rand_range(1.,4.);
+                    clouds[i].w=cloudW*size;
+                    clouds[i].h=cloudH*size;
+                    clouds[i].v=(5.-size)*2.;
+                    clouds[i].x=clouds[i].w+centreX*2.;
+                    clouds[i].y=rand_range(0,centreY*2.);
+
+                }
+            }
+
+            cpSpaceStep(space, 1.0/30.0);
 
-            clouds[i].x=clouds[i].x-clouds[i].v;
-            if (clouds[i].x+clouds[i].w<0) {
-                float size=rand_range(1.,4.);
-                clouds[i].w=cloudW*size;
-                clouds[i].h=cloudH*size;
-                clouds[i].v=(5.-size)*2.;
-                clouds[i].x=clouds[i].w+centreX*2.;
-                clouds[i].y=rand_range(0,centreY*2.);
+            for (int i=0; i<max_balls; i++) {
 
+                cpVect pos = cpBodyGetPos(balls[i].ballBody);
+                if(pos.y>centreY*2){
+                    cpFloat x = rand_range(100,centreX*4); // ??
+                    cpBodySetPos(balls[i].ballBody, cpv(x, 0));
+                    cpBodyResetForces(balls[i].ballBody);
+                    cpBodySetVel(balls[i].ballBody, cpv(0,0));
+                }
             }
         }
-        
-        cpSpaceStep(space, 1.0/30.0);
-        
-        for (int i=0; i<max_balls; i++) {
-			
-			cpVect pos = cpBodyGetPos(balls[i].ballBody);
-			if(pos.y>centreY*2){
-				cpFloat x = rand_range(100,centreX*4); // ??
-				cpBodySetPos(balls[i].ballBody, cpv(x, 0));
-				cpBodyResetForces(balls[i].ballBody);
-				cpBodySetVel(balls[i].ballBody, cpv(0,0));
-			}
-		}
 
         render();	// the render loop
 
-        ts.tv_nsec+=20000000;  // 1000000000 / 50 = 50hz less time to render the frame
-        //thrd_sleep(&ts,NULL); // tinycthread
-		usleep(20000); // while I work out why tinycthread that was working isnt.... :/
+        endFrame(&loop);	// wait until the next frame is due
     }
 
 	// we should really deallocate chipmonk stuff here
@@ -1,7 +1,6 @@
-#include <unistd.h> // usleep
-
 #include "support.h"		// support routines
 #include "obj.h"		// loading and displaying wavefront OBJ derived shapes
+#include "loop.h"		// frame pacing
 
 // window resize function prototype 
 void window_size_callback(GLFWwindow* window, int w, int h);
@@ -45,10 +44,12 @@ struct alien_t {
     kmVec3 shot;
     bool alive;
     bool shotActive;
-    struct pointCloud_t* explosion;
+    struct pointCloud_t* explosion;	// from explosions while exploding
     bool exploding;
 };
 
+struct pointCloudPool_t* explosions;
+
 #define  MAX_ALIENS 12
 struct alien_t aliens[MAX_ALIENS];
 
@@ -117,23 +118,26 @@ float PIDcal(float setpoint, float actual_position, float *pre_error,
 }
 
 
-void resetExposion(struct pointCloud_t* pntC) {
+void resetExposion(struct pointCloud_t* pntC, kmVec3* at) {
 
-    pntC->tick=0;
     for (int i=0; i<pntC->totalPoints; i++) {
         kmVec3 v;
         kmVec3Fill(&v,rand_range(-1,2),rand_range(-1,2),rand_range(-1,2));
         kmVec3Normalize(&v,&v);
+        // the second half fly out at half speed
+        if (i>pntC->totalPoints/2) kmVec3Scale(&v,&v,0.5);
 
         pntC->vel[i*3]=v.x;
         pntC->vel[i*3+1]=v.y;
         pntC->vel[i*3+2]=v.z;
 
-        pntC->pos[i*3]=0;
-        pntC->pos[i*3+1]=0;
-        pntC->pos[i*3+2]=0;
+        pntC->pos[i*3]=at->x;
+        pntC->pos[i*3+1]=at->y;
+        pntC->pos[i*3+2]=at->z;
+        pntC->spawn[i]=pntC->tick;
 
     }
+    uploadPointCloud(pntC);
 
 }
 
@@ -141,7 +145,7 @@ void resetExposion(struct pointCloud_t* pntC) {
 GLFWwindow* window;
 int width=640,height=480; // window width and height
 
-struct timespec ts;  // frame timing
+struct gameLoop_t loop;  // frame timing
 
 int main()
 {
@@ -214,6 +218,9 @@ int main()
 
     glViewport(0, 0, width,height);
 
+    // lets drawObj pick a level of detail from the on screen size
+    reProjectObjs(&projection, height);
+
     // these two matrices are pre combined for use with each model render
     kmMat4Assign(&vp, &projection);
     kmMat4Multiply(&vp, &vp, &view);
@@ -247,16 +254,18 @@ int main()
 
 
 
-    for (int n = 0; n < MAX_ALIENS; n++) {
-        aliens[n].explosion=createPointCloud(40);
-        resetExposion(aliens[n].explosion); // sets initials positions
-    }
+    // all the explosions share a buffer and are drawn together
+    explosions=createPointCloudPool(MAX_ALIENS,40);
 
 	glClearColor(0, .5, 1, 1);
 
+    // everything moves a fixed amount each frame so only the pacing is used
+    initGameLoop(&loop, 1 / 50.0, 1 / 50.0);
+    struct loopStats_t loopStats = { 0 };
+
     while (!quit) {		// the main loop
 
-        clock_gettime(0,&ts);  // note the time BEFORE we start to render the current frame
+        startFrame(&loop);
 		glfwPollEvents();
 
 
@@ -266,6 +275,7 @@ int main()
         float rad;		// radians rotation based on frame counter
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        resetObjStats();
         frame++;
         rad = frame * (0.0175f * 2);
 
@@ -376,8 +386,10 @@ int main()
                             && playerShots[i].alive) {
                         aliens[n].alive = false;
                         playerShots[i].alive = false;
-                        aliens[n].exploding = true;
-                        resetExposion(aliens[n].explosion);
+                        aliens[n].explosion = allocPointCloud(explosions);
+                        aliens[n].exploding = aliens[n].explosion != NULL;
+                        if (aliens[n].exploding)
+                            resetExposion(aliens[n].explosion, &aliens[n].pos);
                     }
                 }
             } 
@@ -393,33 +405,15 @@ int main()
         }
 
 		// draw explosions after ALL aliens
+		glBindTexture(GL_TEXTURE_2D, expTex);
+		drawPointCloudPool(explosions, &vp);
+		explosions->tick=explosions->tick+0.05;
         for (int n = 0; n < MAX_ALIENS; n++) {
-			if (aliens[n].exploding==true) {
-				kmMat4Identity(&model);
-				kmMat4Translation(&model, aliens[n].pos.x,
-								  aliens[n].pos.y, aliens[n].pos.z);
-
-				kmMat4Assign(&mvp, &vp);
-				kmMat4Multiply(&mvp, &mvp, &model);
-				glBindTexture(GL_TEXTURE_2D, expTex);
-				drawPointCloud(aliens[n].explosion, &mvp);
-				aliens[n].explosion->tick=aliens[n].explosion->tick+0.05;
-				if (aliens[n].explosion->tick>1.25) {
-					aliens[n].exploding=false;                   	
-				} else {
-					// update the explosion
-					
-					for (int i=0; i<aliens[n].explosion->totalPoints; i++) {
-				
-						float t;
-						t=aliens[n].explosion->tick;
-						if (i>aliens[n].explosion->totalPoints/2) t=t/2.0;
-						aliens[n].explosion->pos[i*3]=aliens[n].explosion->vel[i*3] * t;
-						aliens[n].explosion->pos[i*3+1]=aliens[n].explosion->vel[i*3+1] * t;
-						aliens[n].explosion->pos[i*3+2]=aliens[n].explosion->vel[i*3+2] * t;
-				
-					}
-				}
+			if (aliens[n].exploding==true &&
+					explosions->tick-aliens[n].explosion->tick>1.25) {
+				freePointCloud(aliens[n].explosion);
+				aliens[n].explosion=NULL;
+				aliens[n].exploding=false;
 			}
 		}
 
@@ -438,16 +432,27 @@ int main()
                  pCenter.z);
         glPrintf(100, 340, font1,"frame %i %i ", frame, frame % 20);
 
+        int vertsDrawn, vertsFull;
+        getObjStats(&vertsDrawn, &vertsFull);
+        glPrintf(100, 356, font1,"verts %i (%i without lod) ", vertsDrawn, vertsFull);
+
+        // frame times over the last second
+        if (frame % 50 == 0) {
+            getLoopStats(&loop, &loopStats);
+            resetLoopStats(&loop);
+        }
+        glPrintf(100, 372, font1,"frame %2.2fms jitter %2.2fms missed %i ",
+                 loopStats.mean * 1000, loopStats.jitter * 1000, loopStats.missed);
+
 
 
         glfwSwapBuffers(window);
 
-        ts.tv_nsec+=20000000;  // 1000000000 / 50 = 50hz less time to render the frame
-        //thrd_sleep(&ts,NULL); // tinycthread
-        usleep(20000); // while I work out why tinycthread that was working isnt.... :/
+        endFrame(&loop);	// wait until the next frame is due
 
     }
 
+	freePointCloudPool(explosions);
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
@@ -468,6 +473,7 @@ void window_size_callback(GLFWwindow* window, int w, int h)
 
 	reProjectGlPrint(width,height); // updates the projection matrix used by glPrint
 	reProjectSprites(width,height); // updates the projection matrix used by the sprites
+	reProjectObjs(&projection,height); // updates the level of detail selection
 	resizePointCloudSprites((float)width/24.0);
 
 }
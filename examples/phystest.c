@@ -9,6 +9,7 @@ cobbled together quickly in a few hours...
 #include "obj.h"		// loading and displaying wavefront OBJ derived shapes
 
 #include <ode/ode.h>
+#include "loop.h"		// fixed timestep main loop
 
 #define numObj 128  // 64 boxes, 64 spheres
 // TODO make a physics object struct with pointer to visual
@@ -80,34 +81,67 @@ static void nearCallback(void *data, dGeomID o1, dGeomID o2)
 struct coll_t {
     int numVerts;
     float *verts;
+    int numIndices;
+    int *indices;
 };
 
+// reads the positions (and indices) of lod 0 from a version 'a' or 'b' GBO
 struct coll_t loadCollisionObj(const char *objFile)
 {
     FILE *pFile;
     struct coll_t r;
     r.numVerts = 0;
     r.verts = NULL;
+    r.numIndices = 0;
+    r.indices = NULL;
     pFile = fopen(objFile, "rb");
     if (pFile == NULL) {
         printf("Cant find open model - %s\n", objFile);
         return r;
     }
     unsigned int magic;
-    int NumVerts;
+    int NumVerts, NumIndices, numLods;
+    float bounds[4], error;
 
     fread(&magic, 1, sizeof(unsigned int), pFile);
-    if (magic != 0x614f4247) {
-        printf("Does not appear to be a version 'a' GBO file\n");
+    if (magic != 0x614f4247 && magic != 0x624f4247) {
+        printf("Does not appear to be a version 'a' or 'b' GBO file\n");
+        fclose(pFile);
         return r;
     }
+    if (magic == 0x624f4247) {
+        fread(&numLods, 1, sizeof(unsigned int), pFile);
+        fread(bounds, 4, sizeof(float), pFile);
+    }
     fread(&NumVerts, 1, sizeof(unsigned int), pFile);
+    NumIndices = NumVerts;
+    if (magic == 0x624f4247) {
+        fread(&NumIndices, 1, sizeof(unsigned int), pFile);
+        fread(&error, 1, sizeof(float), pFile);
+    }
 
     float *Verts = malloc(sizeof(float) * 3 * NumVerts);
     fread(Verts, 1, sizeof(float) * 3 * NumVerts, pFile);
 
+    int *Indices = malloc(sizeof(int) * NumIndices);
+    if (magic == 0x624f4247) {
+        // skip the normals and texture coordinates
+        fseek(pFile, sizeof(float) * 5 * NumVerts, SEEK_CUR);
+        unsigned short *shortInd = malloc(sizeof(unsigned short) * NumIndices);
+        fread(shortInd, 1, sizeof(unsigned short) * NumIndices, pFile);
+        for (int i = 0; i < NumIndices; i++)
+            Indices[i] = shortInd[i];
+        free(shortInd);
+    } else {
+        for (int i = 0; i < NumIndices; i++)
+            Indices[i] = i;	// decidedly sub optimal !
+    }
+    fclose(pFile);
+
     r.numVerts = NumVerts;
     r.verts = Verts;
+    r.numIndices = NumIndices;
+    r.indices = Indices;
     return r;
 }
 
@@ -138,7 +172,7 @@ float *pos, *rot;
 GLFWwindow* window;
 int width=640,height=480; // window width and height
 
-struct timespec ts;  // frame timing
+struct gameLoop_t loop;  // frame timing, 50 updates a second
 
 
 int main()
@@ -269,21 +303,19 @@ int main()
     }
 
     groundColl = loadCollisionObj("resources/models/ground.gbo");
-    int *groundInd = malloc(groundColl.numVerts * sizeof(int));
-    for (int i = 0; i < groundColl.numVerts; i++)
-        groundInd[i] = i;	// decidedly sub optimal !
     triData = dGeomTriMeshDataCreate();
 
     dGeomTriMeshDataBuildSingle(triData, &groundColl.verts[0],
                                 3 * sizeof(float), groundColl.numVerts,
-                                groundInd, groundColl.numVerts,
+                                groundColl.indices, groundColl.numIndices,
                                 3 * sizeof(int));
     groundGeom = dCreateTriMesh(space, triData, NULL, NULL, NULL);
 
 
+    initGameLoop(&loop, 1 / 50.0, 1 / 50.0);
+
     while (!quit) {		// the main loop
 
-        clock_gettime(0,&ts);  // note the time BEFORE we start to render the current frame
 		glfwPollEvents();
 
         if (glfwGetKey(window,GLFW_KEY_ESC)==GLFW_PRESS || glfwWindowShouldClose(window))
@@ -297,24 +329,27 @@ int main()
             }
         }
 
-        for (int i=0; i<numObj; i++) {
-
-            pos=(float*)dBodyGetPosition(obj[i]);
-            if (pos[1]<-5) {
-                if (i<numObj/2) {
-                    dBodySetPosition(obj[i],
-                                     6+dRandReal() * 2 - 1, 5+i, dRandReal() * 2 - 1);
-                } else {
-                    dBodySetPosition(obj[i],
-                                     -6+dRandReal() * 2 - 1, 5+i-(numObj/2), dRandReal() * 2 - 1);
+        // the world steps 50 times a second however long frames take
+        for (int n = startFrame(&loop); n > 0; n--) {
+            for (int i=0; i<numObj; i++) {
+
+                pos=(float*)dBodyGetPosition(obj[i]);
+                if (pos[1]<-5) {
+                    if (i<numObj/2) {
+                        dBodySetPosition(obj[i],
+                                         6+dRandReal() * 2 - 1, 5+i, dRandReal() * 2 - 1);
+                    } else {
+                        dBodySetPosition(obj[i],
+                                         -6+dRandReal() * 2 - 1, 5+i-(numObj/2), dRandReal() * 2 - 1);
+                    }
+                    dBodySetLinearVel(obj[i],0,0,0);
                 }
-                dBodySetLinearVel(obj[i],0,0,0);
             }
-        }
 
-        dSpaceCollide(space, 0, &nearCallback);
-        dWorldQuickStep(world, 1. / 50);
-        dJointGroupEmpty(contactgroup);
+            dSpaceCollide(space, 0, &nearCallback);
+            dWorldQuickStep(world, loop.step);
+            dJointGroupEmpty(contactgroup);
+        }
 
         pEye.x = sin(frame/100.)*18;
         pEye.z = cos(frame/100.)*18;
@@ -325,9 +360,7 @@ int main()
 
         render();		// the render loop
 
-        ts.tv_nsec+=20000000;  // 1000000000 / 50 = 50hz less time to render the frame
-        //thrd_sleep(&ts,NULL); // tinycthread
-		usleep(20000); // while I work out why tinycthread that was working isnt.... :/
+        endFrame(&loop);	// wait until the next frame is due
     }
 
     // TODO although OS will throw stuff away OK
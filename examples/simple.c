@@ -1,5 +1,3 @@
-#include <unistd.h> // usleep
-
 // turned into a lighting test as 6 planes (a cube) is not idea for 
 // checking frag lighting, there is also a sphere
 
@@ -8,6 +6,7 @@
 
 #include "support.h"		// support routines
 #include "obj.h"		// loading and displaying wavefront OBJ derived shapes
+#include "loop.h"		// fixed timestep main loop
 
 unsigned int cubeNumVerts = 36;
 
@@ -120,7 +119,7 @@ int width,height;
 
 font_t *font1,*font2;
 
-struct timespec ts;
+struct gameLoop_t loop;  // frame timing, 50 updates a second
 
 int main()
 {
@@ -192,19 +191,23 @@ int main()
 
 
 
+    initGameLoop(&loop, 1 / 50.0, 1 / 50.0);
+
     while (!quit) {		// the main "logic" loop - stuff to do each frame that isn't directly rendering
-		
-        clock_gettime(0,&ts);  // note the time BEFORE we start to render the current frame
 
 		glfwPollEvents();
 
         if (glfwGetKey(window,GLFW_KEY_ESCAPE)==GLFW_PRESS || glfwWindowShouldClose(window))
             quit = true;	// exit if escape key pressed or window closed
 
-        if (glfwGetKey(window,GLFW_KEY_A)==GLFW_PRESS) camAng=camAng+1;
-        if (glfwGetKey(window,GLFW_KEY_S)==GLFW_PRESS) camAng=camAng-1;
-        if (glfwGetKey(window,GLFW_KEY_W)==GLFW_PRESS) lightAng=lightAng+1;
-        if (glfwGetKey(window,GLFW_KEY_Q)==GLFW_PRESS) lightAng=lightAng-1;
+        // the same speed whatever the frame rate, 50 updates a second
+        for (int n = startFrame(&loop); n > 0; n--) {
+            frame++;
+            if (glfwGetKey(window,GLFW_KEY_A)==GLFW_PRESS) camAng=camAng+1;
+            if (glfwGetKey(window,GLFW_KEY_S)==GLFW_PRESS) camAng=camAng-1;
+            if (glfwGetKey(window,GLFW_KEY_W)==GLFW_PRESS) lightAng=lightAng+1;
+            if (glfwGetKey(window,GLFW_KEY_Q)==GLFW_PRESS) lightAng=lightAng-1;
+        }
 
 
         render();	// the render loop
@@ -213,10 +216,9 @@ int main()
         // cpu / gpu is physically cooler on embedded systems 
         // and also gives the OS chance to do other things without 
         // making the framerate look intermittent ....
-        
-        ts.tv_nsec+=20000000;  // 1000000000 / 50 = 50hz less time to render the frame
-        //thrd_sleep(&ts,NULL); // tinycthread
-		usleep(20000); // while I work out why tinycthread that was working isnt.... :/
+        // endFrame sleeps until the next frame is due, less however
+        // long this one took
+        endFrame(&loop);
     }
     
 	glfwDestroyWindow(window);
@@ -235,9 +237,8 @@ void render()
     // clear the colour (drawing) and depth sort back (offscreen) buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // count the frame and base a rotation on it.
-    frame++;
-    rad = frame * (0.0175f);
+    // base a rotation on the frame counter, alpha of the way to the next
+    rad = (frame + loop.alpha) * (0.0175f);
 
     // rotate the light direction depending on lightAng
     lightDir.x=cos(lightAng/10.);
@@ -330,4 +331,5 @@ void window_size_callback(GLFWwindow* window, int w, int h)
                                 (float)width / height, 0.1, 10);
 
 	reProjectGlPrint(width,height);
+	reProjectObjs(&projection,height);
 }
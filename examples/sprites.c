@@ -1,6 +1,5 @@
-#include <unistd.h> // usleep
-
 #include "support.h"		// support routines
+#include "loop.h"		// fixed timestep main loop
 
 
 /*
@@ -41,7 +40,7 @@ struct cloud_t clouds[max_clouds];
 GLFWwindow* window;
 int width=640,height=480; // window width and height
 
-struct timespec ts,ts2;  // frame timing
+struct gameLoop_t loop;  // frame timing, 50 updates a second
 
 
 int main()
@@ -109,35 +108,37 @@ int main()
 
 
 
+    initGameLoop(&loop, 1 / 50.0, 1 / 50.0);
+
     while (!quit) {		// the main loop
 
-        clock_gettime(TIME_UTC,&ts);  // note the time BEFORE we start to render the current frame
-		
 		glfwPollEvents();
 
         if (glfwGetKey(window,GLFW_KEY_ESCAPE)==GLFW_PRESS || glfwWindowShouldClose(window))
             quit = true;	// exit if escape key pressed or window closed
 
 
-        for (int i=0; i<max_clouds; i++) {
+        // however long the last frame took the clouds move 50 times a second
+        for (int n = startFrame(&loop); n > 0; n--) {
+            frame++;
+            for (int i=0; i<max_clouds; i++) {
 
-            clouds[i].x=clouds[i].x-clouds[i].v;
-            if (clouds[i].x+clouds[i].w<0) {
-                float size=rand_range(1.,4.);
-                clouds[i].w=cloudW*size;
-                clouds[i].h=cloudH*size;
-                clouds[i].v=(5.-size);
-                clouds[i].x=centreX*2.+cloudW*2;
-                clouds[i].y=rand_range(0,centreY*2.);
+                clouds[i].x=clouds[i].x-clouds[i].v;
+                if (clouds[i].x+clouds[i].w<0) {
+                    float size=rand_range(1.,4.);
+                    clouds[i].w=cloudW*size;
+                    clouds[i].h=cloudH*size;
+                    clouds[i].v=(5.-size);
+                    clouds[i].x=centreX*2.+cloudW*2;
+                    clouds[i].y=rand_range(0,centreY*2.);
 
+                }
             }
         }
 
         render();	// the render loop
 
-        ts.tv_nsec=+(1000000/50);  // 1000000000 / 50 = 50hz less time to render the frame
-        //thrd_sleep(&ts,NULL); // tinycthread
-		usleep(20000); // while I work out why tinycthread that was working isnt.... :/
+        endFrame(&loop);	// wait until the next frame is due
     }
 
 	glfwDestroyWindow(window);
@@ -154,15 +155,15 @@ void render()
     // clear the colour (drawing) and depth sort back (offscreen) buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // count the frame and base a rotation on it.
-    frame++;
-    rad = frame * (0.0175f);
+    // base a rotation on the frame counter, alpha of the way to the next
+    float t = frame + loop.alpha;
+    rad = t * (0.0175f);
 
     for (int i=0; i<max_clouds; i++) {
-        drawSprite( clouds[i].x,clouds[i].y,clouds[i].w,clouds[i].h,0,cloudTex);
+        drawSprite( clouds[i].x-clouds[i].v*loop.alpha,clouds[i].y,clouds[i].w,clouds[i].h,0,cloudTex);
     }
 
-    float r2=rad+.6f+(sin(frame*0.03)/6.);
+    float r2=rad+.6f+(sin(t*0.03)/6.);
     drawSprite((centreX-(planeW/2.))+cos(r2)*(centreX*.75),
                centreY+sin(r2)*(centreY*.75),
                planeW,planeH,r2+1.5708f,triTex);
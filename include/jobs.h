@@ -0,0 +1,39 @@
+#include <stdatomic.h>
+#include "tinycthread.h"
+
+/*
+ * a work stealing job system, each of its threads (the one that creates it
+ * is the first) keeps its own deque of jobs, pushing and taking from the
+ * bottom without locking while idle threads steal from the top of the
+ * others' deques.  Workers with nothing to do sleep until a job is pushed
+ *
+ * jobs can only be started from the system's own threads, that is from
+ * the thread that created it or from inside another job
+ */
+
+#define MAX_JOB_THREADS 16
+
+typedef void (*jobFunc_t)(void *data);
+
+/*
+ * a job run with a counter adds 1 to it until it's finished, waitJobs
+ * waits for it to get back to 0 and runJobAfter starts a job once it has,
+ * set it to { 0 } before using it.  The last job to finish still uses it
+ * briefly after the jobs waiting on it start, so it can only be reused
+ * or freed once waitJobs has returned for it
+ */
+struct jobCounter_t {
+    atomic_int count;
+    _Atomic(struct job_t *) waiting;    // jobs to push when count gets to 0
+    atomic_int finishing;       // threads still using it, it can't go yet
+};
+
+struct jobSystem_t* createJobSystem(int threads);
+void runJob(struct jobSystem_t* js, jobFunc_t func, void* data, struct jobCounter_t* counter);
+void runJobAfter(struct jobSystem_t* js, jobFunc_t func, void* data,
+                 struct jobCounter_t* counter, struct jobCounter_t* after);
+void waitJobs(struct jobSystem_t* js, struct jobCounter_t* counter);
+void parallelFor(struct jobSystem_t* js, int count, void (*func)(void* data, int first, int end),
+                 void* data);
+int jobThreads(struct jobSystem_t* js);
+void freeJobSystem(struct jobSystem_t* js);
@@ -0,0 +1,54 @@
+/*
+ * a fixed timestep main loop, the simulation is updated step seconds at a
+ * time however long frames take and each frame is started at an absolute
+ * deadline, so time spent rendering doesn't add to the frame and lateness
+ * doesn't build up
+ *
+ *  struct gameLoop_t loop;
+ *  initGameLoop(&loop, 1 / 50.0, 1 / 50.0);
+ *  while (!quit) {
+ *      for (int n = startFrame(&loop); n > 0; n--) update(loop.step);
+ *      render(loop.alpha);     // how far between the last update and the next
+ *      endFrame(&loop);        // sleeps until the next frame is due
+ *  }
+ */
+
+/*
+ * where the loop gets the time (in seconds) and how it sleeps, the default
+ * is the monotonic clock and clock_nanosleep, a fake one can be given to
+ * run a loop without waiting
+ */
+struct loopClock_t {
+    double (*now)(struct loopClock_t *clock);
+    void (*sleepUntil)(struct loopClock_t *clock, double when);
+};
+
+struct gameLoop_t {
+    double step;            // seconds of simulation each update
+    double period;          // seconds between frames, 0 to not sleep (eg vsync)
+    int maxUpdates;         // most updates in a frame, after a long stall the rest is dropped
+    float alpha;            // 0 to 1, how far the frame is from the last update to the next
+    struct loopClock_t *clock;
+
+    double start, deadline; // when this frame started and the next one should
+    double behind;          // simulation time still to do
+    long updates;
+
+    // frame times, see getLoopStats
+    int frames, missed;
+    double sum, sumSquares, shortest, longest;
+};
+
+struct loopStats_t {
+    int frames;             // measured, the first isn't
+    int missed;             // how many frames ran past the next one's deadline
+    double mean;            // seconds
+    double jitter;          // standard deviation of the frame time
+    double shortest, longest;
+};
+
+void initGameLoop(struct gameLoop_t *loop, double step, double period);
+int startFrame(struct gameLoop_t *loop);
+void endFrame(struct gameLoop_t *loop);
+void getLoopStats(struct gameLoop_t *loop, struct loopStats_t *stats);
+void resetLoopStats(struct gameLoop_t *loop);
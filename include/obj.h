@@ -1,13 +1,25 @@
-
 #include  <GLES2/gl2.h>
 
+#define OBJ_MAX_LODS 4
+
+// one level of detail, ibo is 0 for un-indexed (version 'a' gbo) meshes
+struct objLod_t {
+    GLuint vbo_vert, vbo_tex, vbo_norm, ibo;
+    int num_verts, num_indices;
+    float error;    // furthest the surface moved from lod 0, model units
+};
+
+struct program_t;
+
 struct obj_t {
-    GLuint vbo_vert, vbo_tex, vbo_norm;
     GLint vert_attrib, tex_attrib, norm_attrib;
     GLint mvp_uniform, mv_uniform, tex_uniform;
     GLint lightDir_uniform, viewDir_uniform;
-    int num_verts;
     GLuint program;
+    struct program_t *shader;   // shared with other objs using the same shaders
+    int num_lods;
+    struct objLod_t lod[OBJ_MAX_LODS];
+    float centre[3], radius;    // bounding sphere used to pick a lod
 };
 
 int createObj(struct obj_t *obj, int numVerts, float verts[], float txVert[],
@@ -18,3 +30,9 @@ void drawObj(struct obj_t *obj, kmMat4 * combined, kmMat4 * mv, kmVec3 lightDir,
 
 int loadObj(struct obj_t *obj,const char *objFile, char *vert, char *frag);
 int loadObjCopyShader(struct obj_t *obj,const char *objFile, struct obj_t *sdrobj);
+void freeObj(struct obj_t *obj);
+
+void reProjectObjs(kmMat4 *projection, int h);
+void setObjLodTolerance(float pixels);
+void resetObjStats();
+void getObjStats(int *drawn, int *full);
@@ -0,0 +1,44 @@
+#include <kazmath.h>
+
+/*
+ * a particle system drawn as a point cloud (see createPointCloudAttribs),
+ * each attribute is kept in its own array so updating them uses the SIMD
+ * kmVec3Stream functions.  The live particles are always the first count,
+ * when one dies the last one is moved into its place
+ *
+ * with setParticleThreads the update is split into a chunk per thread,
+ * each removing its own dead and writing its positions straight into the
+ * cloud's upload buffer, then the holes left are filled from the end
+ */
+struct particles_t {
+    int count, capacity;
+    kmVec3Stream pos, vel;
+    float *age, *life;          // seconds
+    float *size;                // pixels, shared with cloud
+    unsigned char *color;       // rgba, shared with cloud
+    kmVec3 gravity;
+    float drag;                 // fraction of the velocity lost per second
+    struct pointCloud_t *cloud; // its pos is kept up to date for uploading
+    struct particleThreads_t *threads;
+};
+
+/*
+ * emits rate particles a second at pos, each with vel plus up to spread
+ * in each direction
+ */
+struct particleEmitter_t {
+    kmVec3 pos, vel;
+    float spread;
+    float rate;
+    float life;
+    float size;
+    unsigned char color[4];
+    float owed;                 // part of a particle carried to the next call
+};
+
+struct particles_t* createParticles(int capacity);
+int emitParticles(struct particles_t* p, struct particleEmitter_t* e, float dt);
+void updateParticles(struct particles_t* p, float dt);
+void setParticleThreads(struct particles_t* p, int threads);
+void drawParticles(struct particles_t* p, kmMat4* mvp);
+void freeParticles(struct particles_t* p);
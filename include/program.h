@@ -0,0 +1,29 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include  <GLES2/gl2.h>
+
+/*
+ * shader programs are shared, asking for the same vertex shader, fragment
+ * shader and defines again returns the same (already linked) program
+ */
+struct programLocation_t {
+    int type;               // shaderAttrib or shaderUniform
+    GLint location;
+    char *name;
+};
+
+struct program_t {
+    GLuint id;
+    int refs;
+    char *vert, *frag, *defines;
+    int numLocations;       // every active attrib and uniform, found at link
+    struct programLocation_t *locations;
+};
+
+struct program_t* getProgram(const char *vert, const char *frag, const char *defines);
+GLint programLocation(struct program_t* prog, int type, const char *name);
+void releaseProgram(struct program_t* prog);
+void getProgramStats(int *compiled, int *loaded);
+
+#endif
@@ -0,0 +1,49 @@
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*
+ * a lock free triple buffer for handing state from one thread to another,
+ * the writer fills one buffer while the reader has another and the third
+ * holds the newest finished one, publishing swaps the writer's buffer with
+ * it and the reader swaps it for its own when there's something newer.
+ * Neither ever waits and the reader always gets a whole buffer, just not
+ * every one if it reads slower than the writer publishes
+ *
+ * a buffer goes back to the writer with whatever was last written in it
+ * (two publishes ago), so write all of it each time
+ */
+struct tripleBuffer_t {
+    void *buffer[3];
+    atomic_int middle;      // the third buffer's index, with FRESH set once published
+    int writing, reading;   // only used by the writer and the reader
+    int got;                // the reader has had one
+};
+
+void initTripleBuffer(struct tripleBuffer_t* tb, size_t size);
+void* writingBuffer(struct tripleBuffer_t* tb);
+void publishBuffer(struct tripleBuffer_t* tb);
+void* latestBuffer(struct tripleBuffer_t* tb);
+void freeTripleBuffer(struct tripleBuffer_t* tb);
+
+/*
+ * runs a simulation on its own thread with a fixed step (see loop.h),
+ * after each step func writes the state the renderer needs (transforms and
+ * so on) into a snapshot of size bytes which is then published through a
+ * triple buffer, so the GL thread draws the newest snapshot without waiting
+ * for the simulation or taking a lock.  func keeps the real state in data
+ * and shouldn't touch GL
+ *
+ *  struct simThread_t* sim = startSimThread(1 / 50.0, sizeof(struct scene_t), step, world);
+ *  while (!quit) {
+ *      double age;
+ *      const struct scene_t* scene = latestSnapshot(sim, &age);
+ *      if (scene) render(scene);
+ *  }
+ *  stopSimThread(sim);
+ */
+typedef void (*simFunc_t)(void* data, void* snapshot, double step);
+
+struct simThread_t* startSimThread(double step, size_t size, simFunc_t func, void* data);
+const void* latestSnapshot(struct simThread_t* sim, double* age);
+long simSteps(struct simThread_t* sim);
+void stopSimThread(struct simThread_t* sim);
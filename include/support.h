@@ -11,10 +11,13 @@
 
 #include <stdarg.h>		// va_lists for glprint
 
+#include "program.h"
+
 enum shaderLocationType { shaderAttrib, shaderUniform };
 GLuint getShaderLocation(int type, GLuint prog, const char *name);
 char *file_read(const char *filename);
 GLuint create_shader(const char *filename, GLenum type);
+GLuint create_shader_defines(const char *filename, GLenum type, const char *defines);
 void print_log(GLuint object);
 int loadPNG(const char *filename);
 void initSprite(int w, int h);
@@ -23,18 +26,82 @@ float rand_range(float min,float max);
 
 
 
+#define MAX_POINT_CLOUD_BUFFERS 4
+
+/*
+ * how big a cloud's points are drawn, all 0 is the size given to
+ * resizePointCloudSprites in pixels whatever the distance
+ */
+struct pointSprite_t {
+	float size;		// 0 for resizePointCloudSprites' size, per point clouds use theirs
+	float attenuation;	// 0 or pointCloudAttenuation, then sizes are world units
+	float minSize, maxSize;	// pixels, a maxSize of 0 has no limit
+};
+
 struct pointCloud_t {
-	int totalPoints;
+	int totalPoints;	// how many are drawn, no more than it was created with
 	float *pos;
 	float *vel;
 	int vertBuf;
 	float tick;
+	float *spawn;	// ballistic clouds only, NULL otherwise
+	kmVec3 gravity;
+	float drag;
+	float *size;	// createPointCloudAttribs only, NULL otherwise
+	unsigned char *color;	// rgba for each point
+	int sizeBuf, colorBuf;
+	int maxPoints;	// what it was created with
+	int upload;		// how drawPointCloud uploads, see setPointCloudUpload
+	int buffers, current;	// round robin, number of buffer sets and the one in use
+	int ring[MAX_POINT_CLOUD_BUFFERS][3];	// vertBuf, sizeBuf and colorBuf of each set
+	struct pointCloudSort_t *sort;	// setPointCloudSorted only, NULL otherwise
+	struct pointCloudPool_t *pool;	// allocPointCloud only, NULL otherwise
+	int first;		// where its points start in vertBuf
+	struct pointSprite_t sprite;
 };
 
+/*
+ * many small ballistic clouds of the same size sharing one set of arrays
+ * and one buffer, see createPointCloudPool
+ */
+struct pointCloudPool_t {
+	int clouds, points;	// how many clouds of how many points
+	float tick;		// the time all its clouds are drawn at
+	kmVec3 gravity;
+	float drag;
+	struct pointSprite_t sprite;
+	float *pos;		// every cloud's points, a cloud's pos, vel and spawn point into these
+	float *vel;
+	float *spawn;
+	int vertBuf;
+	struct pointCloud_t *cloud;
+	bool *active;
+	int *nextFree, firstFree;	// -1 when they're all in use
+};
+
+/*
+ * pointCloudSubData overwrites the buffers the last frame drew from (the
+ * driver may have to wait for that draw or copy them), pointCloudOrphan
+ * gives the buffers new storage first with glBufferData(NULL) and
+ * pointCloudRoundRobin cycles through several sets of buffers
+ */
+enum pointCloudUploadType { pointCloudSubData, pointCloudOrphan, pointCloudRoundRobin };
+
 void initPointClouds(const char* vertS, const char* fragS, float pntSize);
 struct pointCloud_t* createPointCloud(int size);
+struct pointCloud_t* createBallisticPointCloud(int size);
+struct pointCloud_t* createPointCloudAttribs(int size);
+void uploadPointCloud(struct pointCloud_t* pntC);
+void setPointCloudUpload(struct pointCloud_t* pntC, int upload, int buffers);
+void setPointCloudSorted(struct pointCloud_t* pntC, int sorted);
+unsigned int* sortPointCloud(struct pointCloud_t* pntC, kmMat4* m);
 void drawPointCloud(struct pointCloud_t* pntC,kmMat4* m);
+float pointCloudAttenuation(kmMat4* projection, int height);
 void freePointCloud(struct pointCloud_t* pntC);
+struct pointCloudPool_t* createPointCloudPool(int clouds, int points);
+struct pointCloud_t* allocPointCloud(struct pointCloudPool_t* pool);
+void drawPointCloudPool(struct pointCloudPool_t* pool, kmMat4* m);
+void freePointCloudPool(struct pointCloudPool_t* pool);
 
 
 struct __fnt {
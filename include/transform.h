@@ -0,0 +1,29 @@
+#include <kazmath.h>
+
+/*
+ * a hierarchy of transforms kept in flat arrays, a node's parent is always
+ * added before it so one pass from the start updates parents before their
+ * children
+ *
+ * world = parent world * local, mv = view * world, mvp = vp * world
+ * updateTransforms only recalculates nodes whose local matrix (or one of
+ * their parents) changed, unless the camera moved when every mv and mvp
+ * has to be done (but not the world matrices)
+ */
+struct transforms_t {
+    int count, capacity;
+    int *parent;            // -1 for a root
+    unsigned char *dirty;   // local matrix changed since the last update
+    kmMat4 *local, *world, *mv, *mvp;
+
+    kmMat4 view, projection, vp;   // camera the mv and mvp were made with
+    int *changed;                  // scratch list of nodes to update
+};
+
+struct transforms_t* createTransforms(int capacity);
+int addTransform(struct transforms_t* t, int parent);
+void setTransform(struct transforms_t* t, int node, kmVec3 pos,
+                  kmScalar pitch, kmScalar yaw, kmScalar roll);
+void setTransformLocal(struct transforms_t* t, int node, kmMat4* local);
+int updateTransforms(struct transforms_t* t, kmMat4* view, kmMat4* projection);
+void freeTransforms(struct transforms_t* t);
@@ -0,0 +1,454 @@
+/**
+ * @file bvh.c
+ *
+ * Nodes are split using the surface area heuristic, the centres of a
+ * node's boxes are put in KM_BVH_BINS bins along each axis and the split
+ * between bins that minimises (area * items) of the two halves is used, or
+ * no split if making a leaf is cheaper.
+ *
+ * Children are always stored after their parent, so refitting just walks
+ * the nodes backwards.  Queries use a small stack instead of recursion and
+ * the item boxes are kept in leaf order so a leaf's boxes are together in
+ * memory.
+ */
+
+#include <stdlib.h>
+#include <float.h>
+
+#include "utility.h"
+#include "vec3.h"
+#include "aabb.h"
+#include "ray3.h"
+#include "bvh.h"
+
+#define KM_BVH_BINS 16
+
+typedef struct kmBVHEntry {
+	kmInt node;
+	kmScalar t;     /* distance the node was found at, to skip it if something nearer has been found since */
+} kmBVHEntry;
+
+static kmScalar kmBVHAxis(const kmVec3* v, int axis)
+{
+	return axis == 0 ? v->x : axis == 1 ? v->y : v->z;
+}
+
+static void kmBVHEmpty(kmAABB* pBox)
+{
+	kmVec3Fill(&pBox->min, FLT_MAX, FLT_MAX, FLT_MAX);
+	kmVec3Fill(&pBox->max, -FLT_MAX, -FLT_MAX, -FLT_MAX);
+}
+
+static void kmBVHGrow(kmAABB* pBox, const kmAABB* pIn)
+{
+	if (pIn->min.x < pBox->min.x) pBox->min.x = pIn->min.x;
+	if (pIn->min.y < pBox->min.y) pBox->min.y = pIn->min.y;
+	if (pIn->min.z < pBox->min.z) pBox->min.z = pIn->min.z;
+	if (pIn->max.x > pBox->max.x) pBox->max.x = pIn->max.x;
+	if (pIn->max.y > pBox->max.y) pBox->max.y = pIn->max.y;
+	if (pIn->max.z > pBox->max.z) pBox->max.z = pIn->max.z;
+}
+
+static void kmBVHGrowPoint(kmAABB* pBox, const kmVec3* pPoint)
+{
+	kmAABB point;
+	point.min = *pPoint;
+	point.max = *pPoint;
+	kmBVHGrow(pBox, &point);
+}
+
+/* half the surface area, only ever compared */
+static kmScalar kmBVHArea(const kmAABB* pBox)
+{
+	kmScalar dx = pBox->max.x - pBox->min.x;
+	kmScalar dy = pBox->max.y - pBox->min.y;
+	kmScalar dz = pBox->max.z - pBox->min.z;
+	if (dx < 0)
+		return 0;
+	return dx * dy + dy * dz + dz * dx;
+}
+
+static int kmBVHBin(kmScalar c, kmScalar min, kmScalar scale)
+{
+	int b = (int)((c - min) * scale);
+	return b < KM_BVH_BINS - 1 ? b : KM_BVH_BINS - 1;
+}
+
+/*
+ * finds the cheapest split of a node's items, returning its cost (area *
+ * items for both halves) with the axis and first bin of the right half,
+ * or -1 if they can't be split
+ */
+static kmScalar kmBVHSplit(const kmInt* items, int count, const kmAABB* boxes, const kmVec3* centres,
+                           const kmAABB* pCentreBounds, int* pAxis, int* pBin)
+{
+	kmScalar best = -1;
+	int axis, i, k;
+
+	for (axis = 0; axis < 3; axis++) {
+		kmAABB bins[KM_BVH_BINS], left;
+		int counts[KM_BVH_BINS], leftCount = 0, rightCount;
+		kmScalar leftCosts[KM_BVH_BINS];
+		kmScalar min = kmBVHAxis(&pCentreBounds->min, axis);
+		kmScalar extent = kmBVHAxis(&pCentreBounds->max, axis) - min;
+		kmScalar scale;
+
+		if (extent <= 0)
+			continue;
+		scale = KM_BVH_BINS / extent;
+
+		for (i = 0; i < KM_BVH_BINS; i++) {
+			kmBVHEmpty(&bins[i]);
+			counts[i] = 0;
+		}
+		for (k = 0; k < count; k++) {
+			int b = kmBVHBin(kmBVHAxis(&centres[items[k]], axis), min, scale);
+			kmBVHGrow(&bins[b], &boxes[items[k]]);
+			counts[b]++;
+		}
+
+		/* sweep from the left then from the right, splitting before bin i */
+		kmBVHEmpty(&left);
+		for (i = 1; i < KM_BVH_BINS; i++) {
+			kmBVHGrow(&left, &bins[i - 1]);
+			leftCount += counts[i - 1];
+			leftCosts[i] = kmBVHArea(&left) * leftCount;
+		}
+
+		kmBVHEmpty(&left);
+		rightCount = 0;
+		for (i = KM_BVH_BINS - 1; i > 0; i--) {
+			kmScalar cost;
+			kmBVHGrow(&left, &bins[i]);
+			rightCount += counts[i];
+			if (rightCount == 0 || rightCount == count)
+				continue;
+			cost = leftCosts[i] + kmBVHArea(&left) * rightCount;
+			if (best < 0 || cost < best) {
+				best = cost;
+				*pAxis = axis;
+				*pBin = i;
+			}
+		}
+	}
+	return best;
+}
+
+/**
+ * Builds a BVH over count boxes, items in queries are indexes into boxes.
+ * The BVH doesn't keep a pointer to boxes.  Returns pOut
+ */
+kmBVH* kmBVHBuild(kmBVH* pOut, const kmAABB* boxes, unsigned int count)
+{
+	struct { kmInt node; int depth; } stack[KM_BVH_MAX_DEPTH + 1];
+	kmVec3* centres;
+	unsigned int k;
+	int sp = 0;
+
+	pOut->numItems = count;
+	pOut->numNodes = count ? 1 : 0;
+	pOut->items = malloc(sizeof(kmInt) * (count ? count : 1));
+	pOut->itemBoxes = malloc(sizeof(kmAABB) * (count ? count : 1));
+	pOut->nodes = malloc(sizeof(kmBVHNode) * (count ? count * 2 - 1 : 1));
+	if (!count)
+		return pOut;
+
+	centres = malloc(sizeof(kmVec3) * count);
+	for (k = 0; k < count; k++) {
+		pOut->items[k] = k;
+		kmAABBCentre(&boxes[k], &centres[k]);
+	}
+
+	pOut->nodes[0].first = 0;
+	pOut->nodes[0].count = count;
+	stack[sp].node = 0;
+	stack[sp++].depth = 0;
+
+	while (sp) {
+		kmBVHNode* node = &pOut->nodes[stack[--sp].node];
+		int depth = stack[sp].depth;
+		kmInt* items = pOut->items + node->first;
+		kmAABB centreBounds;
+		kmScalar cost, min, scale;
+		int axis = 0, bin = 0, i, j, left;
+
+		kmBVHEmpty(&node->box);
+		kmBVHEmpty(&centreBounds);
+		for (i = 0; i < node->count; i++) {
+			kmBVHGrow(&node->box, &boxes[items[i]]);
+			kmBVHGrowPoint(&centreBounds, &centres[items[i]]);
+		}
+
+		if (node->count <= 2 || depth >= KM_BVH_MAX_DEPTH - 1)
+			continue;
+		cost = kmBVHSplit(items, node->count, boxes, centres, &centreBounds, &axis, &bin);
+		if (cost < 0)
+			continue;
+		/* one unit to visit the node against one per item in the halves */
+		if (node->count <= KM_BVH_MAX_LEAF && 1 + cost / kmBVHArea(&node->box) >= node->count)
+			continue;
+
+		min = kmBVHAxis(&centreBounds.min, axis);
+		scale = KM_BVH_BINS / (kmBVHAxis(&centreBounds.max, axis) - min);
+		for (i = 0, j = node->count - 1; i <= j;) {
+			if (kmBVHBin(kmBVHAxis(&centres[items[i]], axis), min, scale) < bin) {
+				i++;
+			} else {
+				kmInt t = items[i];
+				items[i] = items[j];
+				items[j--] = t;
+			}
+		}
+
+		left = pOut->numNodes;
+		pOut->numNodes += 2;
+		pOut->nodes[left].first = node->first;
+		pOut->nodes[left].count = i;
+		pOut->nodes[left + 1].first = node->first + i;
+		pOut->nodes[left + 1].count = node->count - i;
+		node->first = left;
+		node->count = 0;
+
+		stack[sp].node = left;
+		stack[sp++].depth = depth + 1;
+		stack[sp].node = left + 1;
+		stack[sp++].depth = depth + 1;
+	}
+
+	for (k = 0; k < count; k++)
+		pOut->itemBoxes[k] = boxes[pOut->items[k]];
+	free(centres);
+	return pOut;
+}
+
+/**
+ * Recalculates the node boxes from boxes, which must be the same number
+ * of boxes in the same order as the BVH was built with.  The tree isn't
+ * changed so queries get slower as things move further from where they
+ * were, build it again when that happens.  Returns pBVH
+ */
+kmBVH* kmBVHRefit(kmBVH* pBVH, const kmAABB* boxes)
+{
+	unsigned int k;
+	int n, i;
+
+	for (k = 0; k < pBVH->numItems; k++)
+		pBVH->itemBoxes[k] = boxes[pBVH->items[k]];
+
+	for (n = (int)pBVH->numNodes - 1; n >= 0; n--) {
+		kmBVHNode* node = &pBVH->nodes[n];
+		if (node->count) {
+			node->box = pBVH->itemBoxes[node->first];
+			for (i = 1; i < node->count; i++)
+				kmBVHGrow(&node->box, &pBVH->itemBoxes[node->first + i]);
+		} else {
+			node->box = pBVH->nodes[node->first].box;
+			kmBVHGrow(&node->box, &pBVH->nodes[node->first + 1].box);
+		}
+	}
+	return pBVH;
+}
+
+void kmBVHFree(kmBVH* pBVH)
+{
+	free(pBVH->nodes);
+	free(pBVH->items);
+	free(pBVH->itemBoxes);
+	pBVH->nodes = NULL;
+	pBVH->items = NULL;
+	pBVH->itemBoxes = NULL;
+	pBVH->numNodes = pBVH->numItems = 0;
+}
+
+/*
+ * slab test, where the ray enters the box if that's between 0 and tMax,
+ * inv is 1 / the ray's direction
+ */
+static kmBool kmBVHRayBox(const kmAABB* pBox, const kmVec3* start, const kmVec3* inv,
+                          kmScalar tMax, kmScalar* pT)
+{
+	kmScalar t1 = (pBox->min.x - start->x) * inv->x, t2 = (pBox->max.x - start->x) * inv->x;
+	kmScalar tNear = t1 < t2 ? t1 : t2, tFar = t1 < t2 ? t2 : t1;
+
+	t1 = (pBox->min.y - start->y) * inv->y;
+	t2 = (pBox->max.y - start->y) * inv->y;
+	if ((t1 < t2 ? t1 : t2) > tNear) tNear = t1 < t2 ? t1 : t2;
+	if ((t1 < t2 ? t2 : t1) < tFar) tFar = t1 < t2 ? t2 : t1;
+
+	t1 = (pBox->min.z - start->z) * inv->z;
+	t2 = (pBox->max.z - start->z) * inv->z;
+	if ((t1 < t2 ? t1 : t2) > tNear) tNear = t1 < t2 ? t1 : t2;
+	if ((t1 < t2 ? t2 : t1) < tFar) tFar = t1 < t2 ? t2 : t1;
+
+	if (tNear < 0) tNear = 0;
+	if (tFar > tMax) tFar = tMax;
+	*pT = tNear;
+	return tNear <= tFar;
+}
+
+/**
+ * Finds the nearest item the ray hits at or before *pT (in multiples of
+ * the ray's direction, pass FLT_MAX for no limit).  Without a test
+ * function an item is hit when its box is, otherwise test decides (see
+ * kmBVHRayTest).  Returns the item and sets *pT to where it was hit, or
+ * returns -1 leaving *pT alone
+ */
+int kmBVHRayCast(const kmBVH* pBVH, const kmRay3* pRay, kmBVHRayTest test, void* user, kmScalar* pT)
+{
+	kmBVHEntry stack[KM_BVH_MAX_DEPTH + 1];
+	kmVec3 inv;
+	kmScalar best = *pT, t, tLeft, tRight;
+	int sp = 0, hit = -1, i;
+
+	kmVec3Fill(&inv, 1.0f / pRay->dir.x, 1.0f / pRay->dir.y, 1.0f / pRay->dir.z);
+	if (!pBVH->numNodes || !kmBVHRayBox(&pBVH->nodes[0].box, &pRay->start, &inv, best, &t))
+		return -1;
+	stack[sp].node = 0;
+	stack[sp++].t = t;
+
+	while (sp) {
+		const kmBVHNode* node = &pBVH->nodes[stack[--sp].node];
+		if (stack[sp].t > best)
+			continue;
+
+		if (node->count) {
+			for (i = node->first; i < node->first + node->count; i++) {
+				if (!kmBVHRayBox(&pBVH->itemBoxes[i], &pRay->start, &inv, best, &t))
+					continue;
+				if (test) {
+					if (test(user, pBVH->items[i], pRay, &best))
+						hit = pBVH->items[i];
+				} else if (t < best || hit == -1) {
+					best = t;
+					hit = pBVH->items[i];
+				}
+			}
+		} else {
+			kmBool left = kmBVHRayBox(&pBVH->nodes[node->first].box, &pRay->start, &inv, best, &tLeft);
+			kmBool right = kmBVHRayBox(&pBVH->nodes[node->first + 1].box, &pRay->start, &inv, best, &tRight);
+
+			/* the nearer child goes on top */
+			if (left && right && tLeft < tRight) {
+				stack[sp].node = node->first + 1;
+				stack[sp++].t = tRight;
+				right = KM_FALSE;
+			}
+			if (left) {
+				stack[sp].node = node->first;
+				stack[sp++].t = tLeft;
+			}
+			if (right) {
+				stack[sp].node = node->first + 1;
+				stack[sp++].t = tRight;
+			}
+		}
+	}
+
+	if (hit != -1)
+		*pT = best;
+	return hit;
+}
+
+static kmBool kmBVHBoxesOverlap(const kmAABB* a, const kmAABB* b)
+{
+	return a->min.x <= b->max.x && a->max.x >= b->min.x &&
+	       a->min.y <= b->max.y && a->max.y >= b->min.y &&
+	       a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+/**
+ * Finds the items whose boxes overlap pBox (touching counts), storing up
+ * to max of them in pItems.  Returns how many there are in total, which
+ * can be more than max
+ */
+unsigned int kmBVHOverlap(const kmBVH* pBVH, const kmAABB* pBox, int* pItems, unsigned int max)
+{
+	kmInt stack[KM_BVH_MAX_DEPTH + 1];
+	unsigned int found = 0;
+	int sp = 0, i;
+
+	if (!pBVH->numNodes)
+		return 0;
+	stack[sp++] = 0;
+
+	while (sp) {
+		const kmBVHNode* node = &pBVH->nodes[stack[--sp]];
+		if (!kmBVHBoxesOverlap(&node->box, pBox))
+			continue;
+
+		if (node->count) {
+			for (i = node->first; i < node->first + node->count; i++) {
+				if (!kmBVHBoxesOverlap(&pBVH->itemBoxes[i], pBox))
+					continue;
+				if (found < max)
+					pItems[found] = pBVH->items[i];
+				found++;
+			}
+		} else {
+			stack[sp++] = node->first + 1;
+			stack[sp++] = node->first;
+		}
+	}
+	return found;
+}
+
+/* squared distance from a point to the nearest point in a box, 0 inside */
+static kmScalar kmBVHDistanceSq(const kmAABB* pBox, const kmVec3* p)
+{
+	kmScalar dx = p->x < pBox->min.x ? pBox->min.x - p->x : p->x > pBox->max.x ? p->x - pBox->max.x : 0;
+	kmScalar dy = p->y < pBox->min.y ? pBox->min.y - p->y : p->y > pBox->max.y ? p->y - pBox->max.y : 0;
+	kmScalar dz = p->z < pBox->min.z ? pBox->min.z - p->z : p->z > pBox->max.z ? p->z - pBox->max.z : 0;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * Finds the item whose box is nearest pPoint, setting *pDistanceSq to the
+ * squared distance to the box (0 if the point is inside it).  Returns -1
+ * if the BVH is empty
+ */
+int kmBVHNearest(const kmBVH* pBVH, const kmVec3* pPoint, kmScalar* pDistanceSq)
+{
+	kmBVHEntry stack[KM_BVH_MAX_DEPTH + 1];
+	kmScalar best = FLT_MAX, d, dLeft, dRight;
+	int sp = 0, hit = -1, i;
+
+	if (!pBVH->numNodes)
+		return -1;
+	stack[sp].node = 0;
+	stack[sp++].t = kmBVHDistanceSq(&pBVH->nodes[0].box, pPoint);
+
+	while (sp) {
+		const kmBVHNode* node = &pBVH->nodes[stack[--sp].node];
+		if (stack[sp].t >= best && hit != -1)
+			continue;
+
+		if (node->count) {
+			for (i = node->first; i < node->first + node->count; i++) {
+				d = kmBVHDistanceSq(&pBVH->itemBoxes[i], pPoint);
+				if (d < best || hit == -1) {
+					best = d;
+					hit = pBVH->items[i];
+				}
+			}
+		} else {
+			dLeft = kmBVHDistanceSq(&pBVH->nodes[node->first].box, pPoint);
+			dRight = kmBVHDistanceSq(&pBVH->nodes[node->first + 1].box, pPoint);
+
+			/* the nearer child goes on top */
+			if (dLeft < dRight) {
+				stack[sp].node = node->first + 1;
+				stack[sp++].t = dRight;
+				stack[sp].node = node->first;
+				stack[sp++].t = dLeft;
+			} else {
+				stack[sp].node = node->first;
+				stack[sp++].t = dLeft;
+				stack[sp].node = node->first + 1;
+				stack[sp++].t = dRight;
+			}
+		}
+	}
+
+	*pDistanceSq = best;
+	return hit;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file bvh.h
+ *
+ * A bounding volume hierarchy over an array of kmAABBs (one per mesh or
+ * object) for picking with rays and finding what overlaps a box or is
+ * nearest a point without testing every box
+ */
+
+#ifndef BVH_H_INCLUDED
+#define BVH_H_INCLUDED
+
+#include "utility.h"
+#include "aabb.h"
+
+struct kmVec3;
+struct kmRay3;
+
+/* the most items a leaf will have unless they can't be split */
+#define KM_BVH_MAX_LEAF 8
+/* deeper nodes become leaves, queries use a stack this size */
+#define KM_BVH_MAX_DEPTH 64
+
+/**
+ * Nodes are stored in one array, a leaf (count > 0) holds items first to
+ * first + count - 1 in the BVH's items, otherwise the node's children are
+ * nodes first and first + 1.  Node 0 is the root
+ */
+typedef struct kmBVHNode {
+	kmAABB box;
+	kmInt first;
+	kmInt count;
+} kmBVHNode;
+
+typedef struct kmBVH {
+	kmBVHNode* nodes;
+	unsigned int numNodes;
+	unsigned int numItems;
+	kmInt* items;       /** index into the array of boxes the BVH was built from, in leaf order */
+	kmAABB* itemBoxes;  /** each item's box, in the same order as items */
+} kmBVH;
+
+/**
+ * Called by kmBVHRayCast for an item whose box the ray hits nearer than
+ * *pT, return KM_TRUE and set *pT if the ray hits the item itself (its
+ * triangles, say) nearer than *pT
+ */
+typedef kmBool (*kmBVHRayTest)(void* user, int item, const struct kmRay3* pRay, kmScalar* pT);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+kmBVH* kmBVHBuild(kmBVH* pOut, const kmAABB* boxes, unsigned int count); /** Builds the hierarchy with binned SAH, free it with kmBVHFree */
+kmBVH* kmBVHRefit(kmBVH* pBVH, const kmAABB* boxes); /** Updates the node boxes after the boxes (the same number, in the same order) have moved */
+void kmBVHFree(kmBVH* pBVH);
+
+int kmBVHRayCast(const kmBVH* pBVH, const struct kmRay3* pRay, kmBVHRayTest test, void* user, kmScalar* pT);
+unsigned int kmBVHOverlap(const kmBVH* pBVH, const kmAABB* pBox, int* pItems, unsigned int max);
+int kmBVHNearest(const kmBVH* pBVH, const struct kmVec3* pPoint, kmScalar* pDistanceSq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BVH_H_INCLUDED */
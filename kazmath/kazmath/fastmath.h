@@ -0,0 +1,121 @@
+/**
+ * @file fastmath.h
+ *
+ * Private to kazmath, the sine, cosine and reciprocal square root used by
+ * the rotation and normalize functions.  Normally these are just libm's
+ * sinf, cosf and 1 / sqrtf, define KAZMATH_FAST_MATH (when building
+ * kazmath, eg add -DKAZMATH_FAST_MATH to FLAGS) to use approximations:
+ *
+ * kmInlineSinCos reduces the angle to within pi/4 of a multiple of pi/2 and
+ * evaluates a polynomial for each, the largest error is about 9.3e-8 (1 or
+ * 2 ulp near 1) for angles within +-10,000 radians, growing beyond that as
+ * the reduction loses precision (about 1e-6 at +-100,000).  Larger angles
+ * (and NaN) go to sinf and cosf, the quadrant wouldn't fit in an int.
+ *
+ * kmInlineRsqrt takes the SSE or NEON estimate and refines it with Newton
+ * steps (one for SSE's 12 bit estimate, two for NEON's 8 bits), the
+ * largest relative error is about 2.5e-7 with SSE and 4.7e-6 without SIMD
+ * (a bit trick estimate and two steps).
+ *
+ * Neither is used with USE_DOUBLE_PRECISION.  make bench-fastmath measures
+ * the errors and times both against libm.
+ *
+ * A few functions keep temporaries in double (kmMat4Inverse's determinant,
+ * kmMat4RotationQuaternion's products), converting every value in and out.
+ * They're declared as kmWideScalar, which is kmScalar instead when kazmath
+ * is built with KAZMATH_FLOAT_INTERNALS.  make bench-float measures what
+ * that costs in precision and saves in time.
+ */
+
+#ifndef FASTMATH_H_INCLUDED
+#define FASTMATH_H_INCLUDED
+
+#include <math.h>
+#include "utility.h"
+
+#if defined(KAZMATH_FAST_MATH) && !defined(USE_DOUBLE_PRECISION)
+#define KM_FAST_MATH
+#if !defined(KAZMATH_NO_SIMD)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define KM_FAST_RSQRT_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define KM_FAST_RSQRT_NEON
+#endif
+#endif
+#endif
+
+#if defined(KAZMATH_FLOAT_INTERNALS)
+typedef kmScalar kmWideScalar;
+#else
+typedef double kmWideScalar;
+#endif
+
+/* beyond this kmInlineSinCos uses libm */
+#define KM_FAST_SINCOS_RANGE 100000.0f
+
+static inline void kmInlineSinCos(kmScalar radians, kmScalar* pSin, kmScalar* pCos)
+{
+#if defined(KM_FAST_MATH)
+	/* pi/2 in three parts, the first two with few enough bits that
+	   multiplying them by the quadrant is exact */
+	const float c1 = 1.5703125f, c2 = 4.83751296997e-4f, c3 = 7.54978995489e-8f;
+	union { float f; unsigned int i; } sn, cs;
+	float sc[2], r, r2;
+	int q;
+
+	if (!(fabsf(radians) <= KM_FAST_SINCOS_RANGE)) {
+		*pSin = sinf(radians);
+		*pCos = cosf(radians);
+		return;
+	}
+	q = (int)(radians * 0.636619772f + copysignf(0.5f, radians));
+	r = ((radians - q * c1) - q * c2) - q * c3;
+	r2 = r * r;
+
+	/* minimax polynomials for |r| <= pi/4, from cephes */
+	sc[0] = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+	sc[1] = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+	/* swapped in odd quadrants and negated in the lower (sine) or left
+	   (cosine) half, without branches as angles are rarely predictable */
+	sn.f = sc[q & 1];
+	cs.f = sc[(q & 1) ^ 1];
+	sn.i ^= (unsigned int)(q & 2) << 30;
+	cs.i ^= (unsigned int)((q + 1) & 2) << 30;
+	*pSin = sn.f;
+	*pCos = cs.f;
+#else
+	*pSin = sinf(radians);
+	*pCos = cosf(radians);
+#endif
+}
+
+/* 1 / sqrt(x), x must be greater than zero */
+static inline kmScalar kmInlineRsqrt(kmScalar x)
+{
+#if defined(KM_FAST_RSQRT_SSE)
+	/* the same operations as kmStreamRsqrt so the stream functions agree */
+	float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+	return y * (1.5f - 0.5f * x * y * y);
+#elif defined(KM_FAST_RSQRT_NEON)
+	float32x2_t v = vdup_n_f32(x);
+	float32x2_t y = vrsqrte_f32(v);
+	y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+	y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+	return vget_lane_f32(y, 0);
+#elif defined(KM_FAST_MATH)
+	union { float f; unsigned int i; } u;
+	float y;
+	u.f = x;
+	u.i = 0x5f375a86 - (u.i >> 1);
+	y = u.f;
+	y = y * (1.5f - 0.5f * x * y * y);
+	return y * (1.5f - 0.5f * x * y * y);
+#else
+	return 1.0f / sqrtf(x);
+#endif
+}
+
+#endif /* FASTMATH_H_INCLUDED */
@@ -0,0 +1,219 @@
+/**
+ * @file frustum.c
+ *
+ * A sphere is outside when its centre is more than the radius behind any
+ * plane and partially inside when it is less than the radius in front of
+ * one.  Boxes use their centre and half size, the box's "radius" against a
+ * plane being the half size projected on to the plane's normal.
+ *
+ * The batch versions test 4 bounds against each plane with SSE or NEON,
+ * doing the same operations as the single versions so the results are
+ * always the same.
+ */
+
+#include <math.h>
+
+#include "utility.h"
+#include "vec3.h"
+#include "mat4.h"
+#include "aabb.h"
+#include "vec3stream.h"
+#include "frustum.h"
+#include "streamsimd.h"
+
+/**
+ * Extracts the frustum planes from a projection * view matrix, pass
+ * projection * view * model to get them in model space instead.  Returns
+ * pOut
+ */
+kmFrustum* kmFrustumFromMat4(kmFrustum* pOut, const kmMat4* pViewProjection)
+{
+	kmPlaneExtractFromMat4(&pOut->planes[KM_PLANE_LEFT], pViewProjection, 1);
+	kmPlaneExtractFromMat4(&pOut->planes[KM_PLANE_RIGHT], pViewProjection, -1);
+	kmPlaneExtractFromMat4(&pOut->planes[KM_PLANE_BOTTOM], pViewProjection, 2);
+	kmPlaneExtractFromMat4(&pOut->planes[KM_PLANE_TOP], pViewProjection, -2);
+	kmPlaneExtractFromMat4(&pOut->planes[KM_PLANE_NEAR], pViewProjection, 3);
+	kmPlaneExtractFromMat4(&pOut->planes[KM_PLANE_FAR], pViewProjection, -3);
+	return pOut;
+}
+
+kmEnum kmFrustumContainsPoint(const kmFrustum* pF, const kmVec3* pPoint)
+{
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		const kmPlane* p = &pF->planes[i];
+		if (p->a * pPoint->x + p->b * pPoint->y + p->c * pPoint->z + p->d < 0)
+			return KM_CONTAINS_NONE;
+	}
+	return KM_CONTAINS_ALL;
+}
+
+kmEnum kmFrustumContainsSphere(const kmFrustum* pF, const kmVec3* pCentre, kmScalar radius)
+{
+	kmEnum result = KM_CONTAINS_ALL;
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		const kmPlane* p = &pF->planes[i];
+		kmScalar d = p->a * pCentre->x + p->b * pCentre->y + p->c * pCentre->z + p->d;
+		if (d < -radius)
+			return KM_CONTAINS_NONE;
+		if (d < radius)
+			result = KM_CONTAINS_PARTIAL;
+	}
+	return result;
+}
+
+kmEnum kmFrustumContainsAABB(const kmFrustum* pF, const kmAABB* pBox)
+{
+	kmEnum result = KM_CONTAINS_ALL;
+	kmScalar cx = (pBox->min.x + pBox->max.x) * 0.5f;
+	kmScalar cy = (pBox->min.y + pBox->max.y) * 0.5f;
+	kmScalar cz = (pBox->min.z + pBox->max.z) * 0.5f;
+	kmScalar ex = (pBox->max.x - pBox->min.x) * 0.5f;
+	kmScalar ey = (pBox->max.y - pBox->min.y) * 0.5f;
+	kmScalar ez = (pBox->max.z - pBox->min.z) * 0.5f;
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		const kmPlane* p = &pF->planes[i];
+		kmScalar d = p->a * cx + p->b * cy + p->c * cz + p->d;
+		kmScalar r = fabsf(p->a) * ex + fabsf(p->b) * ey + fabsf(p->c) * ez;
+		if (d < -r)
+			return KM_CONTAINS_NONE;
+		if (d < r)
+			result = KM_CONTAINS_PARTIAL;
+	}
+	return result;
+}
+
+#if defined(KM_STREAM_SIMD)
+
+/* lane j's bit moved to the bottom of byte j */
+static const unsigned int kmFrustumSpread[16] = {
+	0x00000000, 0x00000001, 0x00000100, 0x00000101,
+	0x00010000, 0x00010001, 0x00010100, 0x00010101,
+	0x01000000, 0x01000001, 0x01000100, 0x01000101,
+	0x01010000, 0x01010001, 0x01010100, 0x01010101
+};
+
+/*
+ * a bit per lane from the masks, returns how many aren't outside, done
+ * without branches as which lanes are inside is unpredictable
+ *
+ * relies on KM_CONTAINS_NONE being 0 and KM_CONTAINS_PARTIAL being
+ * KM_CONTAINS_ALL - 1
+ */
+static unsigned int kmFrustumResults(kmUchar* pOut, int outside, int partial)
+{
+	unsigned int out = kmFrustumSpread[outside];
+	unsigned int r = (KM_CONTAINS_ALL * 0x01010101u - kmFrustumSpread[partial]) & ~(out * 0xff);
+	pOut[0] = r;
+	pOut[1] = r >> 8;
+	pOut[2] = r >> 16;
+	pOut[3] = r >> 24;
+	return 4 - ((out * 0x01010101u) >> 24);
+}
+
+#endif
+
+unsigned int kmFrustumContainsSpheres(kmUchar* pOut, const kmFrustum* pF, const kmVec3Stream* pCentres, const kmScalar* radii, unsigned int count)
+{
+	unsigned int i = 0, visible = 0;
+
+#if defined(KM_STREAM_SIMD)
+	kmStreamVec a[6], b[6], c[6], d[6];
+	kmStreamVec zero = kmStreamSet(0);
+	int p;
+
+	for (p = 0; p < 6; p++) {
+		a[p] = kmStreamSet(pF->planes[p].a);
+		b[p] = kmStreamSet(pF->planes[p].b);
+		c[p] = kmStreamSet(pF->planes[p].c);
+		d[p] = kmStreamSet(pF->planes[p].d);
+	}
+
+	for (; i + 4 <= count; i += 4) {
+		kmStreamVec x = kmStreamLoad(pCentres->x + i);
+		kmStreamVec y = kmStreamLoad(pCentres->y + i);
+		kmStreamVec z = kmStreamLoad(pCentres->z + i);
+		kmStreamVec r = kmStreamLoad(radii + i);
+		kmStreamVec negR = kmStreamSub(zero, r);
+		kmStreamMask outside = kmStreamLess(zero, zero);
+		kmStreamMask partial = outside;
+
+		for (p = 0; p < 6; p++) {
+			kmStreamVec dist = kmStreamAdd(kmStreamAdd(kmStreamAdd(kmStreamMul(a[p], x),
+				kmStreamMul(b[p], y)), kmStreamMul(c[p], z)), d[p]);
+			outside = kmStreamOr(outside, kmStreamLess(dist, negR));
+			partial = kmStreamOr(partial, kmStreamLess(dist, r));
+		}
+		visible += kmFrustumResults(pOut + i, kmStreamBits(outside), kmStreamBits(partial));
+	}
+#endif
+
+	for (; i < count; i++) {
+		kmVec3 centre;
+		kmVec3StreamGet(&centre, pCentres, i);
+		pOut[i] = kmFrustumContainsSphere(pF, &centre, radii[i]);
+		if (pOut[i] != KM_CONTAINS_NONE)
+			visible++;
+	}
+	return visible;
+}
+
+unsigned int kmFrustumContainsAABBs(kmUchar* pOut, const kmFrustum* pF, const kmVec3Stream* pMin, const kmVec3Stream* pMax, unsigned int count)
+{
+	unsigned int i = 0, visible = 0;
+
+#if defined(KM_STREAM_SIMD)
+	kmStreamVec a[6], b[6], c[6], d[6], absA[6], absB[6], absC[6];
+	kmStreamVec zero = kmStreamSet(0), half = kmStreamSet(0.5f);
+	int p;
+
+	for (p = 0; p < 6; p++) {
+		a[p] = kmStreamSet(pF->planes[p].a);
+		b[p] = kmStreamSet(pF->planes[p].b);
+		c[p] = kmStreamSet(pF->planes[p].c);
+		d[p] = kmStreamSet(pF->planes[p].d);
+		absA[p] = kmStreamAbs(a[p]);
+		absB[p] = kmStreamAbs(b[p]);
+		absC[p] = kmStreamAbs(c[p]);
+	}
+
+	for (; i + 4 <= count; i += 4) {
+		kmStreamVec minX = kmStreamLoad(pMin->x + i), maxX = kmStreamLoad(pMax->x + i);
+		kmStreamVec minY = kmStreamLoad(pMin->y + i), maxY = kmStreamLoad(pMax->y + i);
+		kmStreamVec minZ = kmStreamLoad(pMin->z + i), maxZ = kmStreamLoad(pMax->z + i);
+		kmStreamVec cx = kmStreamMul(kmStreamAdd(minX, maxX), half);
+		kmStreamVec cy = kmStreamMul(kmStreamAdd(minY, maxY), half);
+		kmStreamVec cz = kmStreamMul(kmStreamAdd(minZ, maxZ), half);
+		kmStreamVec ex = kmStreamMul(kmStreamSub(maxX, minX), half);
+		kmStreamVec ey = kmStreamMul(kmStreamSub(maxY, minY), half);
+		kmStreamVec ez = kmStreamMul(kmStreamSub(maxZ, minZ), half);
+		kmStreamMask outside = kmStreamLess(zero, zero);
+		kmStreamMask partial = outside;
+
+		for (p = 0; p < 6; p++) {
+			kmStreamVec dist = kmStreamAdd(kmStreamAdd(kmStreamAdd(kmStreamMul(a[p], cx),
+				kmStreamMul(b[p], cy)), kmStreamMul(c[p], cz)), d[p]);
+			kmStreamVec r = kmStreamAdd(kmStreamAdd(kmStreamMul(absA[p], ex),
+				kmStreamMul(absB[p], ey)), kmStreamMul(absC[p], ez));
+			outside = kmStreamOr(outside, kmStreamLess(dist, kmStreamSub(zero, r)));
+			partial = kmStreamOr(partial, kmStreamLess(dist, r));
+		}
+		visible += kmFrustumResults(pOut + i, kmStreamBits(outside), kmStreamBits(partial));
+	}
+#endif
+
+	for (; i < count; i++) {
+		kmAABB box;
+		kmVec3StreamGet(&box.min, pMin, i);
+		kmVec3StreamGet(&box.max, pMax, i);
+		pOut[i] = kmFrustumContainsAABB(pF, &box);
+		if (pOut[i] != KM_CONTAINS_NONE)
+			visible++;
+	}
+	return visible;
+}
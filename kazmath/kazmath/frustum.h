@@ -0,0 +1,48 @@
+/**
+ * @file frustum.h
+ *
+ * The six planes of a view frustum for culling bounding spheres and boxes,
+ * the batch versions take structure of arrays bounds (see vec3stream.h)
+ */
+
+#ifndef FRUSTUM_H_INCLUDED
+#define FRUSTUM_H_INCLUDED
+
+#include "utility.h"
+#include "plane.h"
+
+struct kmMat4;
+struct kmVec3;
+struct kmAABB;
+struct kmVec3Stream;
+
+/**
+ * Indexed by KM_PLANE_LEFT to KM_PLANE_FAR, the planes are normalized and
+ * face inwards so a point is inside when it is in front of all of them
+ */
+typedef struct kmFrustum {
+	kmPlane planes[6];
+} kmFrustum;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+kmFrustum* kmFrustumFromMat4(kmFrustum* pOut, const struct kmMat4* pViewProjection); /** Extracts the planes from a projection * view (* model) matrix */
+kmEnum kmFrustumContainsPoint(const kmFrustum* pF, const struct kmVec3* pPoint); /** KM_CONTAINS_NONE or KM_CONTAINS_ALL */
+kmEnum kmFrustumContainsSphere(const kmFrustum* pF, const struct kmVec3* pCentre, kmScalar radius);
+kmEnum kmFrustumContainsAABB(const kmFrustum* pF, const struct kmAABB* pBox);
+
+/*
+ * pOut gets a KM_CONTAINS_ value for each of the count bounds (the same as
+ * the single versions would return), returns how many are at least
+ * partially inside
+ */
+unsigned int kmFrustumContainsSpheres(kmUchar* pOut, const kmFrustum* pF, const struct kmVec3Stream* pCentres, const kmScalar* radii, unsigned int count);
+unsigned int kmFrustumContainsAABBs(kmUchar* pOut, const kmFrustum* pF, const struct kmVec3Stream* pMin, const struct kmVec3Stream* pMax, unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRUSTUM_H_INCLUDED */
@@ -28,12 +28,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "vec2.h"
 #include "vec3.h"
+#include "vec3stream.h"
 #include "mat3.h"
 #include "mat4.h"
 #include "utility.h"
 #include "quaternion.h"
+#include "quatstream.h"
+#include "trs.h"
 #include "plane.h"
 #include "aabb.h"
+#include "frustum.h"
+#include "bvh.h"
 #include "ray2.h"
 #include "ray3.h"
 
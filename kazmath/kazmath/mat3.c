@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mat3.h"
 #include "mat4.h"
 #include "quaternion.h"
+#include "fastmath.h"
 
 kmMat3* kmMat3Fill(kmMat3* pOut, const kmScalar* pMat)
 {
@@ -222,13 +223,15 @@ kmMat3* kmMat3Rotation(kmMat3* pOut, const kmScalar radians)
      M = |  sin(A)   cos(A)   0  |
          |  0        0        1  |
 	*/
+	kmScalar s, c;
+	kmInlineSinCos(radians, &s, &c);
 
-	pOut->mat[0] = cosf(radians);
-	pOut->mat[1] = sinf(radians);
+	pOut->mat[0] = c;
+	pOut->mat[1] = s;
 	pOut->mat[2] = 0.0f;
 
-	pOut->mat[3] = -sinf(radians);;
-	pOut->mat[4] = cosf(radians);
+	pOut->mat[3] = -s;
+	pOut->mat[4] = c;
 	pOut->mat[5] = 0.0f;
 
 	pOut->mat[6] = 0.0f;
@@ -287,8 +290,8 @@ kmMat3* kmMat3RotationQuaternion(kmMat3* pOut, const kmQuaternion* pIn)
 
 kmMat3* kmMat3RotationAxisAngle(kmMat3* pOut, const struct kmVec3* axis, kmScalar radians)
 {
-    kmScalar rcos = cosf(radians);
-    kmScalar rsin = sinf(radians);
+    kmScalar rcos, rsin;
+    kmInlineSinCos(radians, &rsin, &rcos);
 
     pOut->mat[0] = rcos + axis->x * axis->x * (1 - rcos);
     pOut->mat[1] = axis->z * rsin + axis->y * axis->x * (1 - rcos);
@@ -325,18 +328,20 @@ kmMat3* kmMat3RotationX(kmMat3* pOut, const kmScalar radians)
 	     |  0  sin(A)  cos(A) |
 
 	*/
+	kmScalar s, c;
+	kmInlineSinCos(radians, &s, &c);
 
 	pOut->mat[0] = 1.0f;
 	pOut->mat[1] = 0.0f;
 	pOut->mat[2] = 0.0f;
 
 	pOut->mat[3] = 0.0f;
-	pOut->mat[4] = cosf(radians);
-	pOut->mat[5] = sinf(radians);
+	pOut->mat[4] = c;
+	pOut->mat[5] = s;
 
 	pOut->mat[6] = 0.0f;
-	pOut->mat[7] = -sinf(radians);
-	pOut->mat[8] = cosf(radians);
+	pOut->mat[7] = -s;
+	pOut->mat[8] = c;
 
 	return pOut;
 }
@@ -352,18 +357,20 @@ kmMat3* kmMat3RotationY(kmMat3* pOut, const kmScalar radians)
 	 M = |  0       1   0      |
 	     | -sin(A)  0   cos(A) |
 	*/
+	kmScalar s, c;
+	kmInlineSinCos(radians, &s, &c);
 
-	pOut->mat[0] = cosf(radians);
+	pOut->mat[0] = c;
 	pOut->mat[1] = 0.0f;
-	pOut->mat[2] = -sinf(radians);
+	pOut->mat[2] = -s;
 
 	pOut->mat[3] = 0.0f;
 	pOut->mat[4] = 1.0f;
 	pOut->mat[5] = 0.0f;
 
-	pOut->mat[6] = sinf(radians);
+	pOut->mat[6] = s;
 	pOut->mat[7] = 0.0f;
-	pOut->mat[8] = cosf(radians);
+	pOut->mat[8] = c;
 
 	return pOut;
 }
@@ -379,13 +386,15 @@ kmMat3* kmMat3RotationZ(kmMat3* pOut, const kmScalar radians)
 	 M = |  sin(A)   cos(A)   0  |
 	     |  0        0        1  |
 	*/
+	kmScalar s, c;
+	kmInlineSinCos(radians, &s, &c);
 
-	pOut->mat[0] = cosf(radians);
-	pOut->mat[1] =-sinf(radians);
+	pOut->mat[0] = c;
+	pOut->mat[1] = -s;
 	pOut->mat[2] = 0.0f;
 
-	pOut->mat[3] = sinf(radians);;
-	pOut->mat[4] = cosf(radians);
+	pOut->mat[3] = s;
+	pOut->mat[4] = c;
 	pOut->mat[5] = 0.0f;
 
 	pOut->mat[6] = 0.0f;
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <memory.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include "utility.h"
 #include "vec3.h"
@@ -36,6 +37,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mat3.h"
 #include "quaternion.h"
 #include "plane.h"
+#include "fastmath.h"
 
 /**
  * Fills a kmMat4 structure with the values from a 16
@@ -69,7 +71,7 @@ kmMat4* kmMat4Identity(kmMat4* pOut)
  */
 kmMat4* kmMat4Inverse(kmMat4* pOut, const kmMat4* pM) {
     kmMat4 tmp;
-    double det;
+    kmWideScalar det;
     int i;
 
     tmp.mat[0] = pM->mat[5]  * pM->mat[10] * pM->mat[15] -
@@ -190,7 +192,7 @@ kmMat4* kmMat4Inverse(kmMat4* pOut, const kmMat4* pM) {
         return NULL;
     }
 
-    det = 1.0 / det;
+    det = 1 / det;
 
     for (i = 0; i < 16; i++) {
         pOut->mat[i] = tmp.mat[i] * det;
@@ -198,6 +200,122 @@ kmMat4* kmMat4Inverse(kmMat4* pOut, const kmMat4* pM) {
 
     return pOut;
 }
+/**
+ * Calculates the inverse of an affine matrix (the bottom row is 0, 0, 0, 1
+ * so it is a linear transform plus a translation), the 3x3 part is inverted
+ * and the translation moved back through it.  Much cheaper than
+ * kmMat4Inverse but wrong for anything with a projection in it.
+ * @Return Returns NULL if there is no inverse, else pOut
+ */
+kmMat4* kmMat4InverseAffine(kmMat4* pOut, const kmMat4* pM)
+{
+	const kmScalar *m = pM->mat;
+	kmScalar *o = pOut->mat;
+	kmScalar r[9], det, tx = m[12], ty = m[13], tz = m[14];
+
+	/* cofactors of the 3x3, transposed */
+	r[0] = m[5] * m[10] - m[9] * m[6];
+	r[1] = m[9] * m[2] - m[1] * m[10];
+	r[2] = m[1] * m[6] - m[5] * m[2];
+	r[3] = m[8] * m[6] - m[4] * m[10];
+	r[4] = m[0] * m[10] - m[8] * m[2];
+	r[5] = m[4] * m[2] - m[0] * m[6];
+	r[6] = m[4] * m[9] - m[8] * m[5];
+	r[7] = m[8] * m[1] - m[0] * m[9];
+	r[8] = m[0] * m[5] - m[4] * m[1];
+
+	det = m[0] * r[0] + m[4] * r[1] + m[8] * r[2];
+	if (det == 0) {
+		return NULL;
+	}
+	det = 1 / det;
+
+	o[0] = r[0] * det; o[4] = r[3] * det; o[8] = r[6] * det;
+	o[1] = r[1] * det; o[5] = r[4] * det; o[9] = r[7] * det;
+	o[2] = r[2] * det; o[6] = r[5] * det; o[10] = r[8] * det;
+	o[12] = -(o[0] * tx + o[4] * ty + o[8] * tz);
+	o[13] = -(o[1] * tx + o[5] * ty + o[9] * tz);
+	o[14] = -(o[2] * tx + o[6] * ty + o[10] * tz);
+	o[3] = o[7] = o[11] = 0;
+	o[15] = 1;
+
+	return pOut;
+}
+
+/**
+ * Calculates the inverse of a rigid body transform, a rotation (the 3x3
+ * part is orthonormal) plus a translation like a view matrix from
+ * kmMat4LookAt.  The rotation is transposed and the translation moved
+ * back through it, there are no divides and it can't fail.
+ * @Return Returns pOut
+ */
+kmMat4* kmMat4InverseRigid(kmMat4* pOut, const kmMat4* pM)
+{
+	const kmScalar *m = pM->mat;
+	kmScalar r[9] = { m[0], m[4], m[8], m[1], m[5], m[9], m[2], m[6], m[10] };
+	kmScalar tx = m[12], ty = m[13], tz = m[14];
+	kmScalar *o = pOut->mat;
+
+	o[0] = r[0]; o[4] = r[3]; o[8] = r[6];
+	o[1] = r[1]; o[5] = r[4]; o[9] = r[7];
+	o[2] = r[2]; o[6] = r[5]; o[10] = r[8];
+	o[12] = -(o[0] * tx + o[4] * ty + o[8] * tz);
+	o[13] = -(o[1] * tx + o[5] * ty + o[9] * tz);
+	o[14] = -(o[2] * tx + o[6] * ty + o[10] * tz);
+	o[3] = o[7] = o[11] = 0;
+	o[15] = 1;
+
+	return pOut;
+}
+
+/**
+ * Returns KM_MAT4_RIGID if pM is a rotation plus a translation (columns
+ * of unit length and at right angles to within kmMat4RigidEpsilon),
+ * KM_MAT4_AFFINE if its bottom row is exactly 0, 0, 0, 1 and
+ * KM_MAT4_GENERAL otherwise
+ */
+int kmMat4Classify(const kmMat4* pM)
+{
+	const kmScalar *m = pM->mat;
+	kmScalar xx, yy, zz, xy, xz, yz;
+
+	if (m[3] != 0 || m[7] != 0 || m[11] != 0 || m[15] != 1) {
+		return KM_MAT4_GENERAL;
+	}
+
+	/* the 3x3 times its transpose should be the identity */
+	xx = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+	yy = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+	zz = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+	xy = m[0] * m[4] + m[1] * m[5] + m[2] * m[6];
+	xz = m[0] * m[8] + m[1] * m[9] + m[2] * m[10];
+	yz = m[4] * m[8] + m[5] * m[9] + m[6] * m[10];
+
+	if (fabs(xx - 1) < kmMat4RigidEpsilon && fabs(yy - 1) < kmMat4RigidEpsilon &&
+	        fabs(zz - 1) < kmMat4RigidEpsilon && fabs(xy) < kmMat4RigidEpsilon &&
+	        fabs(xz) < kmMat4RigidEpsilon && fabs(yz) < kmMat4RigidEpsilon) {
+		return KM_MAT4_RIGID;
+	}
+	return KM_MAT4_AFFINE;
+}
+
+/**
+ * Inverts pM with the cheapest method that is correct for it, see
+ * kmMat4Classify
+ * @Return Returns NULL if there is no inverse, else pOut
+ */
+kmMat4* kmMat4InverseAuto(kmMat4* pOut, const kmMat4* pM)
+{
+	switch (kmMat4Classify(pM)) {
+	case KM_MAT4_RIGID:
+		return kmMat4InverseRigid(pOut, pM);
+	case KM_MAT4_AFFINE:
+		return kmMat4InverseAffine(pOut, pM);
+	default:
+		return kmMat4Inverse(pOut, pM);
+	}
+}
+
 /**
  * Returns KM_TRUE if pIn is an identity matrix
  * KM_FALSE otherwise
@@ -229,11 +347,96 @@ kmMat4* kmMat4Transpose(kmMat4* pOut, const kmMat4* pIn)
     return pOut;
 }
 
+/*
+ * SIMD versions of the multiply keep each column of pM1 in a register and
+ * build a column of the result as col0*b0 + col1*b1 + col2*b2 + col3*b3
+ * adding in the same order as the scalar code so the results are the same
+ * (bit for bit unless the compiler fuses the scalar multiply-adds)
+ *
+ * define KAZMATH_NO_SIMD to always use the scalar code
+ */
+#if !defined(KAZMATH_NO_SIMD) && !defined(USE_DOUBLE_PRECISION)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define KM_MAT4_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define KM_MAT4_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(KM_MAT4_SSE)
+
+static inline __m128 kmMat4ColumnSSE(const __m128* a, const kmScalar* b)
+{
+	__m128 col = _mm_loadu_ps(b);
+	__m128 r = _mm_mul_ps(a[0], _mm_shuffle_ps(col, col, _MM_SHUFFLE(0, 0, 0, 0)));
+	r = _mm_add_ps(r, _mm_mul_ps(a[1], _mm_shuffle_ps(col, col, _MM_SHUFFLE(1, 1, 1, 1))));
+	r = _mm_add_ps(r, _mm_mul_ps(a[2], _mm_shuffle_ps(col, col, _MM_SHUFFLE(2, 2, 2, 2))));
+	return _mm_add_ps(r, _mm_mul_ps(a[3], _mm_shuffle_ps(col, col, _MM_SHUFFLE(3, 3, 3, 3))));
+}
+
+static inline void kmMat4MultiplySSE(kmScalar* out, const __m128* a, const kmScalar* b)
+{
+	__m128 c0 = kmMat4ColumnSSE(a, b);
+	__m128 c1 = kmMat4ColumnSSE(a, b + 4);
+	__m128 c2 = kmMat4ColumnSSE(a, b + 8);
+	__m128 c3 = kmMat4ColumnSSE(a, b + 12);
+	_mm_storeu_ps(out, c0);
+	_mm_storeu_ps(out + 4, c1);
+	_mm_storeu_ps(out + 8, c2);
+	_mm_storeu_ps(out + 12, c3);
+}
+
+#elif defined(KM_MAT4_NEON)
+
+/* separate multiplies and adds, vmla/vfma could round differently */
+static inline float32x4_t kmMat4ColumnNEON(const float32x4_t* a, const kmScalar* b)
+{
+	float32x4_t col = vld1q_f32(b);
+	float32x4_t r = vmulq_lane_f32(a[0], vget_low_f32(col), 0);
+	r = vaddq_f32(r, vmulq_lane_f32(a[1], vget_low_f32(col), 1));
+	r = vaddq_f32(r, vmulq_lane_f32(a[2], vget_high_f32(col), 0));
+	return vaddq_f32(r, vmulq_lane_f32(a[3], vget_high_f32(col), 1));
+}
+
+static inline void kmMat4MultiplyNEON(kmScalar* out, const float32x4_t* a, const kmScalar* b)
+{
+	float32x4_t c0 = kmMat4ColumnNEON(a, b);
+	float32x4_t c1 = kmMat4ColumnNEON(a, b + 4);
+	float32x4_t c2 = kmMat4ColumnNEON(a, b + 8);
+	float32x4_t c3 = kmMat4ColumnNEON(a, b + 12);
+	vst1q_f32(out, c0);
+	vst1q_f32(out + 4, c1);
+	vst1q_f32(out + 8, c2);
+	vst1q_f32(out + 12, c3);
+}
+
+#endif
+
 /**
  * Multiplies pM1 with pM2, stores the result in pOut, returns pOut
+ * pOut may be the same matrix as either pM1 or pM2
  */
 kmMat4* kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
 {
+#if defined(KM_MAT4_SSE)
+	__m128 a[4];
+	a[0] = _mm_loadu_ps(pM1->mat);
+	a[1] = _mm_loadu_ps(pM1->mat + 4);
+	a[2] = _mm_loadu_ps(pM1->mat + 8);
+	a[3] = _mm_loadu_ps(pM1->mat + 12);
+	kmMat4MultiplySSE(pOut->mat, a, pM2->mat);
+	return pOut;
+#elif defined(KM_MAT4_NEON)
+	float32x4_t a[4];
+	a[0] = vld1q_f32(pM1->mat);
+	a[1] = vld1q_f32(pM1->mat + 4);
+	a[2] = vld1q_f32(pM1->mat + 8);
+	a[3] = vld1q_f32(pM1->mat + 12);
+	kmMat4MultiplyNEON(pOut->mat, a, pM2->mat);
+	return pOut;
+#else
 	kmScalar mat[16];
 
 	const kmScalar *m1 = pM1->mat, *m2 = pM2->mat;
@@ -261,6 +464,39 @@ kmMat4* kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
 
 	memcpy(pOut->mat, mat, sizeof(kmScalar)*16);
 
+	return pOut;
+#endif
+}
+
+/**
+ * Multiplies pM1 with each of the count matrices in pM2 storing the
+ * results in pOut, for example a view projection with many model matrices
+ * pOut may be pM2 but pM1 must not be one of the pOut matrices
+ * @Return Returns pOut
+ */
+kmMat4* kmMat4MultiplyBatch(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2, unsigned int count)
+{
+	unsigned int n;
+#if defined(KM_MAT4_SSE)
+	__m128 a[4];
+	a[0] = _mm_loadu_ps(pM1->mat);
+	a[1] = _mm_loadu_ps(pM1->mat + 4);
+	a[2] = _mm_loadu_ps(pM1->mat + 8);
+	a[3] = _mm_loadu_ps(pM1->mat + 12);
+	for (n = 0; n < count; n++)
+		kmMat4MultiplySSE(pOut[n].mat, a, pM2[n].mat);
+#elif defined(KM_MAT4_NEON)
+	float32x4_t a[4];
+	a[0] = vld1q_f32(pM1->mat);
+	a[1] = vld1q_f32(pM1->mat + 4);
+	a[2] = vld1q_f32(pM1->mat + 8);
+	a[3] = vld1q_f32(pM1->mat + 12);
+	for (n = 0; n < count; n++)
+		kmMat4MultiplyNEON(pOut[n].mat, a, pM2[n].mat);
+#else
+	for (n = 0; n < count; n++)
+		kmMat4Multiply(&pOut[n], pM1, &pM2[n]);
+#endif
 	return pOut;
 }
 
@@ -343,19 +579,22 @@ kmMat4* kmMat4RotationX(kmMat4* pOut, const kmScalar radians)
 
 	*/
 
+	kmScalar s, c;
+	kmInlineSinCos(radians, &s, &c);
+
 	pOut->mat[0] = 1.0f;
 	pOut->mat[1] = 0.0f;
 	pOut->mat[2] = 0.0f;
 	pOut->mat[3] = 0.0f;
 
 	pOut->mat[4] = 0.0f;
-	pOut->mat[5] = cosf(radians);
-	pOut->mat[6] = sinf(radians);
+	pOut->mat[5] = c;
+	pOut->mat[6] = s;
 	pOut->mat[7] = 0.0f;
 
 	pOut->mat[8] = 0.0f;
-	pOut->mat[9] = -sinf(radians);
-	pOut->mat[10] = cosf(radians);
+	pOut->mat[9] = -s;
+	pOut->mat[10] = c;
 	pOut->mat[11] = 0.0f;
 
 	pOut->mat[12] = 0.0f;
@@ -378,10 +617,12 @@ kmMat4* kmMat4RotationY(kmMat4* pOut, const kmScalar radians)
 	     | -sin(A)  0   cos(A)  0 |
 	     |  0       0   0       1 |
 	*/
+	kmScalar s, c;
+	kmInlineSinCos(radians, &s, &c);
 
-	pOut->mat[0] = cosf(radians);
+	pOut->mat[0] = c;
 	pOut->mat[1] = 0.0f;
-	pOut->mat[2] = -sinf(radians);
+	pOut->mat[2] = -s;
 	pOut->mat[3] = 0.0f;
 
 	pOut->mat[4] = 0.0f;
@@ -389,9 +630,9 @@ kmMat4* kmMat4RotationY(kmMat4* pOut, const kmScalar radians)
 	pOut->mat[6] = 0.0f;
 	pOut->mat[7] = 0.0f;
 
-	pOut->mat[8] = sinf(radians);
+	pOut->mat[8] = s;
 	pOut->mat[9] = 0.0f;
-	pOut->mat[10] = cosf(radians);
+	pOut->mat[10] = c;
 	pOut->mat[11] = 0.0f;
 
 	pOut->mat[12] = 0.0f;
@@ -414,14 +655,16 @@ kmMat4* kmMat4RotationZ(kmMat4* pOut, const kmScalar radians)
 	     |  0        0        1   0 |
 	     |  0        0        0   1 |
 	*/
+	kmScalar s, c;
+	kmInlineSinCos(radians, &s, &c);
 
-	pOut->mat[0] = cosf(radians);
-	pOut->mat[1] = sinf(radians);
+	pOut->mat[0] = c;
+	pOut->mat[1] = s;
 	pOut->mat[2] = 0.0f;
 	pOut->mat[3] = 0.0f;
 
-	pOut->mat[4] = -sinf(radians);;
-	pOut->mat[5] = cosf(radians);
+	pOut->mat[4] = -s;
+	pOut->mat[5] = c;
 	pOut->mat[6] = 0.0f;
 	pOut->mat[7] = 0.0f;
 
@@ -441,23 +684,38 @@ kmMat4* kmMat4RotationZ(kmMat4* pOut, const kmScalar radians)
 /**
  * Builds a rotation matrix from pitch, yaw and roll. The resulting
  * matrix is stored in pOut and pOut is returned
+ *
+ * This is RotationY(yaw) * RotationX(pitch) * RotationZ(roll) written out,
+ * the products are grouped as the multiplies would do them
  */
 kmMat4* kmMat4RotationYawPitchRoll(kmMat4* pOut, const kmScalar pitch, const kmScalar yaw, const kmScalar roll)
 {
+	kmScalar sp, cp, sy, cy, sr, cr;
+	kmInlineSinCos(pitch, &sp, &cp);
+	kmInlineSinCos(yaw, &sy, &cy);
+	kmInlineSinCos(roll, &sr, &cr);
+
+	pOut->mat[0] = cy * cr + sy * (sp * sr);
+	pOut->mat[1] = cp * sr;
+	pOut->mat[2] = cy * (sp * sr) - sy * cr;
+	pOut->mat[3] = 0.0f;
 
-    kmMat4 yaw_matrix;
-    kmMat4RotationY(&yaw_matrix, yaw);
-
-    kmMat4 pitch_matrix;
-    kmMat4RotationX(&pitch_matrix, pitch);
+	pOut->mat[4] = sy * (sp * cr) - cy * sr;
+	pOut->mat[5] = cp * cr;
+	pOut->mat[6] = sy * sr + cy * (sp * cr);
+	pOut->mat[7] = 0.0f;
 
-    kmMat4 roll_matrix;
-    kmMat4RotationZ(&roll_matrix, roll);
+	pOut->mat[8] = sy * cp;
+	pOut->mat[9] = -sp;
+	pOut->mat[10] = cy * cp;
+	pOut->mat[11] = 0.0f;
 
-    kmMat4Multiply(pOut, &pitch_matrix, &roll_matrix);
-    kmMat4Multiply(pOut, &yaw_matrix, pOut);
+	pOut->mat[12] = 0.0f;
+	pOut->mat[13] = 0.0f;
+	pOut->mat[14] = 0.0f;
+	pOut->mat[15] = 1.0f;
 
-    return pOut;
+	return pOut;
 }
 
 /** Converts a quaternion to a rotation matrix,
@@ -465,17 +723,17 @@ kmMat4* kmMat4RotationYawPitchRoll(kmMat4* pOut, const kmScalar pitch, const kmS
  */
 kmMat4* kmMat4RotationQuaternion(kmMat4* pOut, const kmQuaternion* pQ)
 {    
-    double xx = pQ->x * pQ->x;
-    double xy = pQ->x * pQ->y;
-    double xz = pQ->x * pQ->z;
-    double xw = pQ->x * pQ->w;
+    kmWideScalar xx = pQ->x * pQ->x;
+    kmWideScalar xy = pQ->x * pQ->y;
+    kmWideScalar xz = pQ->x * pQ->z;
+    kmWideScalar xw = pQ->x * pQ->w;
 
-    double yy = pQ->y * pQ->y;
-    double yz = pQ->y * pQ->z;
-    double yw = pQ->y * pQ->w;
+    kmWideScalar yy = pQ->y * pQ->y;
+    kmWideScalar yz = pQ->y * pQ->z;
+    kmWideScalar yw = pQ->y * pQ->w;
 
-    double zz = pQ->z * pQ->z;
-    double zw = pQ->z * pQ->w;
+    kmWideScalar zz = pQ->z * pQ->z;
+    kmWideScalar zw = pQ->z * pQ->w;
 
     pOut->mat[0] = 1 - 2 * (yy + zz);
     pOut->mat[1] = 2 * (xy + zw);
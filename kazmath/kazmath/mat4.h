@@ -42,6 +42,14 @@ mat = | 1   5   9  13 |
         | 3   7  11  15 |
 */
 
+/* matrix classes from kmMat4Classify */
+#define KM_MAT4_GENERAL 0
+#define KM_MAT4_AFFINE 1
+#define KM_MAT4_RIGID 2
+
+/* how far from orthonormal a rotation can be and still count as rigid */
+#define kmMat4RigidEpsilon 1e-5
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -56,12 +64,17 @@ kmMat4* kmMat4Fill(kmMat4* pOut, const kmScalar* pMat);
 kmMat4* kmMat4Identity(kmMat4* pOut);
 
 kmMat4* kmMat4Inverse(kmMat4* pOut, const kmMat4* pM);
+kmMat4* kmMat4InverseAffine(kmMat4* pOut, const kmMat4* pM);
+kmMat4* kmMat4InverseRigid(kmMat4* pOut, const kmMat4* pM);
+kmMat4* kmMat4InverseAuto(kmMat4* pOut, const kmMat4* pM);
+int kmMat4Classify(const kmMat4* pM);
 
 
 int kmMat4IsIdentity(const kmMat4* pIn);
 
 kmMat4* kmMat4Transpose(kmMat4* pOut, const kmMat4* pIn);
 kmMat4* kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2);
+kmMat4* kmMat4MultiplyBatch(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2, unsigned int count);
 
 kmMat4* kmMat4Assign(kmMat4* pOut, const kmMat4* pIn);
 kmMat4* kmMat4AssignMat3(kmMat4* pOut, const struct kmMat3* pIn);
@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vec4.h"
 #include "plane.h"
 #include "mat4.h"
+#include "fastmath.h"
 
 kmScalar kmPlaneDot(const kmPlane* pP, const kmVec4* pV)
 {
@@ -213,7 +214,7 @@ kmPlane* kmPlaneExtractFromMat4(kmPlane* pOut, const struct kmMat4* pIn, kmInt r
 kmVec3* kmPlaneGetIntersection(kmVec3* pOut, const kmPlane* p1, const kmPlane* p2, const kmPlane* p3) {
     kmVec3 n1, n2, n3, cross;
     kmVec3 r1, r2, r3;
-    double denom = 0;
+    kmWideScalar denom = 0;
     
     kmVec3Fill(&n1, p1->a, p1->b, p1->c);
     kmVec3Fill(&n2, p2->a, p2->b, p2->c);
@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mat3.h"
 #include "vec3.h"
 #include "quaternion.h"
+#include "fastmath.h"
 
 int kmQuaternionAreEqual(const kmQuaternion* p1, const kmQuaternion* p2) {
     if ((p1->x < (p2->x + kmEpsilon) && p1->x > (p2->x - kmEpsilon)) &&
@@ -164,9 +165,15 @@ kmQuaternion* kmQuaternionMultiply(kmQuaternion* pOut,
 kmQuaternion* kmQuaternionNormalize(kmQuaternion* pOut,
 											const kmQuaternion* pIn)
 {
+#if defined(KM_FAST_MATH)
+	kmScalar lengthSq = kmQuaternionLengthSq(pIn);
+
+    if (lengthSq < kmEpsilon * kmEpsilon)
+#else
 	kmScalar length = kmQuaternionLength(pIn);
 
     if (fabs(length) < kmEpsilon)
+#endif
     {
         pOut->x = 0.0;
         pOut->y = 0.0;
@@ -176,12 +183,22 @@ kmQuaternion* kmQuaternionNormalize(kmQuaternion* pOut,
         return pOut;
     }
 
+#if defined(KM_FAST_MATH)
+    kmScalar l = kmInlineRsqrt(lengthSq);
+    kmQuaternionFill(pOut,
+        pIn->x * l,
+        pIn->y * l,
+        pIn->z * l,
+        pIn->w * l
+    );
+#else
     kmQuaternionFill(pOut,
-        pOut->x / length,
-        pOut->y / length,
-        pOut->z / length,
-        pOut->w / length
+        pIn->x / length,
+        pIn->y / length,
+        pIn->z / length,
+        pIn->w / length
     );
+#endif
 
 	return pOut;
 }
@@ -191,13 +208,13 @@ kmQuaternion* kmQuaternionRotationAxisAngle(kmQuaternion* pOut,
 									const kmVec3* pV,
 									kmScalar angle)
 {
-    kmScalar rad = angle * 0.5f;
-	kmScalar scale	= sinf(rad);
+    kmScalar scale, w;
+	kmInlineSinCos(angle * 0.5f, &scale, &w);
 
 	pOut->x = pV->x * scale;
 	pOut->y = pV->y * scale;
 	pOut->z = pV->z * scale;
-    pOut->w = cosf(rad);
+    pOut->w = w;
 
 	kmQuaternionNormalize(pOut, pOut);
 
@@ -335,12 +352,10 @@ kmQuaternion* kmQuaternionRotationPitchYawRoll(kmQuaternion* pOut,
     assert(roll <= 2*kmPI);
 
     // Finds the Sin and Cosin for each half angles.
-    float sY = sinf(yaw * 0.5);
-    float cY = cosf(yaw * 0.5);
-    float sZ = sinf(roll * 0.5);
-    float cZ = cosf(roll * 0.5);
-    float sX = sinf(pitch * 0.5);
-    float cX = cosf(pitch * 0.5);
+    kmScalar sY, cY, sZ, cZ, sX, cX;
+    kmInlineSinCos(yaw * 0.5f, &sY, &cY);
+    kmInlineSinCos(roll * 0.5f, &sZ, &cZ);
+    kmInlineSinCos(pitch * 0.5f, &sX, &cX);
 
     // Formula to construct a new Quaternion based on Euler Angles.
     pOut->w = cY * cZ * cX - sY * sZ * sX;
@@ -359,7 +374,7 @@ kmQuaternion* kmQuaternionSlerp(kmQuaternion* pOut,
 {
 
     kmScalar dot = kmQuaternionDot(q1, q2);
-    const double DOT_THRESHOLD = 0.9995;
+    const kmWideScalar DOT_THRESHOLD = 0.9995;
 
     if (dot > DOT_THRESHOLD) {
         kmQuaternion diff;
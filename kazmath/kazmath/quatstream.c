@@ -0,0 +1,214 @@
+/**
+ * @file quatstream.c
+ *
+ * Like vec3stream.c each function does 4 quaternions at a time with SSE or
+ * NEON and the remainder with scalar code doing the same operations, so a
+ * quaternion's result doesn't depend on where it is in the stream.
+ *
+ * There's no vector acos or sin so slerp uses polynomials for them,
+ * acos(a) = sqrt(1 - a) * P(a) from Abramowitz and Stegun 4.4.46 and the
+ * Taylor series of sin to x^11 (the angles are at most pi/2), and
+ * 1 / sin(acos(a)) = 1 / sqrt(1 - a^2) so there's no divide.  Nearly equal
+ * quaternions are interpolated linearly as in kmQuaternionSlerp.
+ *
+ * Both need kmStreamRsqrt, so like normalize in vec3stream.c they're scalar
+ * on 32 bit ARM unless kazmath is built with KAZMATH_FAST_MATH
+ */
+
+#include <math.h>
+
+#include "utility.h"
+#include "vec3.h"
+#include "quaternion.h"
+#include "quatstream.h"
+#include "streamsimd.h"
+#include "fastmath.h"
+
+/* the same threshold as kmQuaternionSlerp */
+#define KM_QUAT_STREAM_LINEAR 0.9995f
+
+kmQuaternionStream* kmQuaternionStreamFill(kmQuaternionStream* pOut, kmScalar* x, kmScalar* y, kmScalar* z, kmScalar* w)
+{
+	pOut->x = x;
+	pOut->y = y;
+	pOut->z = z;
+	pOut->w = w;
+	return pOut;
+}
+
+kmQuaternion* kmQuaternionStreamGet(kmQuaternion* pOut, const kmQuaternionStream* pIn, unsigned int i)
+{
+	pOut->x = pIn->x[i];
+	pOut->y = pIn->y[i];
+	pOut->z = pIn->z[i];
+	pOut->w = pIn->w[i];
+	return pOut;
+}
+
+kmQuaternionStream* kmQuaternionStreamSet(kmQuaternionStream* pOut, unsigned int i, const kmQuaternion* pIn)
+{
+	pOut->x[i] = pIn->x;
+	pOut->y[i] = pIn->y;
+	pOut->z[i] = pIn->z;
+	pOut->w[i] = pIn->w;
+	return pOut;
+}
+
+static inline kmScalar kmQuaternionStreamAcos(kmScalar a)
+{
+	kmScalar p = 1.5707963050f + a * (-0.2145988016f + a * (0.0889789874f + a * (-0.0501743046f +
+		a * (0.0308918810f + a * (-0.0170881256f + a * (0.0066700901f + a * -0.0012624911f))))));
+	return (1 - a) * kmInlineRsqrt(1 - a) * p;
+}
+
+static inline kmScalar kmQuaternionStreamSin(kmScalar x)
+{
+	kmScalar x2 = x * x;
+	return x + x * x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f + x2 * (-1.9841270e-4f +
+		x2 * (2.7557319e-6f + x2 * -2.5052108e-8f))));
+}
+
+/*
+ * q1 * s1 + q2 * s2 (q2 negated if the dot product d is) normalized
+ */
+static inline void kmQuaternionStreamBlend(kmQuaternionStream* pOut, const kmQuaternionStream* pQ1, const kmQuaternionStream* pQ2,
+                                           kmScalar d, kmScalar s1, kmScalar s2, unsigned int i)
+{
+	kmScalar x, y, z, w, l;
+
+	if (signbit(d))
+		s2 = -s2;
+	x = pQ1->x[i] * s1 + pQ2->x[i] * s2;
+	y = pQ1->y[i] * s1 + pQ2->y[i] * s2;
+	z = pQ1->z[i] * s1 + pQ2->z[i] * s2;
+	w = pQ1->w[i] * s1 + pQ2->w[i] * s2;
+	l = x * x + y * y + z * z + w * w;
+	l = l > 0 ? kmInlineRsqrt(l) : 0;
+	pOut->x[i] = x * l;
+	pOut->y[i] = y * l;
+	pOut->z[i] = z * l;
+	pOut->w[i] = w * l;
+}
+
+static inline kmScalar kmQuaternionStreamDot(const kmQuaternionStream* pQ1, const kmQuaternionStream* pQ2, unsigned int i)
+{
+	return pQ1->x[i] * pQ2->x[i] + pQ1->y[i] * pQ2->y[i] + pQ1->z[i] * pQ2->z[i] + pQ1->w[i] * pQ2->w[i];
+}
+
+#if defined(KM_STREAM_RSQRT)
+
+static inline kmStreamVec kmQuaternionStreamDot4(const kmQuaternionStream* pQ1, const kmQuaternionStream* pQ2, unsigned int i)
+{
+	return kmStreamAdd(kmStreamAdd(kmStreamAdd(
+		kmStreamMul(kmStreamLoad(pQ1->x + i), kmStreamLoad(pQ2->x + i)),
+		kmStreamMul(kmStreamLoad(pQ1->y + i), kmStreamLoad(pQ2->y + i))),
+		kmStreamMul(kmStreamLoad(pQ1->z + i), kmStreamLoad(pQ2->z + i))),
+		kmStreamMul(kmStreamLoad(pQ1->w + i), kmStreamLoad(pQ2->w + i)));
+}
+
+static inline void kmQuaternionStreamBlend4(kmQuaternionStream* pOut, const kmQuaternionStream* pQ1, const kmQuaternionStream* pQ2,
+                                            kmStreamVec d, kmStreamVec s1, kmStreamVec s2, unsigned int i)
+{
+	kmStreamVec x, y, z, w, l;
+
+	s2 = kmStreamFlipSign(s2, d);
+	x = kmStreamAdd(kmStreamMul(kmStreamLoad(pQ1->x + i), s1), kmStreamMul(kmStreamLoad(pQ2->x + i), s2));
+	y = kmStreamAdd(kmStreamMul(kmStreamLoad(pQ1->y + i), s1), kmStreamMul(kmStreamLoad(pQ2->y + i), s2));
+	z = kmStreamAdd(kmStreamMul(kmStreamLoad(pQ1->z + i), s1), kmStreamMul(kmStreamLoad(pQ2->z + i), s2));
+	w = kmStreamAdd(kmStreamMul(kmStreamLoad(pQ1->w + i), s1), kmStreamMul(kmStreamLoad(pQ2->w + i), s2));
+	l = kmStreamAdd(kmStreamAdd(kmStreamAdd(kmStreamMul(x, x), kmStreamMul(y, y)), kmStreamMul(z, z)), kmStreamMul(w, w));
+	l = kmStreamIfPositive(l, kmStreamRsqrt(l));
+	kmStreamStore(pOut->x + i, kmStreamMul(x, l));
+	kmStreamStore(pOut->y + i, kmStreamMul(y, l));
+	kmStreamStore(pOut->z + i, kmStreamMul(z, l));
+	kmStreamStore(pOut->w + i, kmStreamMul(w, l));
+}
+
+/* the polynomials above, coefficient by coefficient */
+static inline kmStreamVec kmQuaternionStreamAcos4(kmStreamVec a)
+{
+	static const float c[8] = { 1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f,
+	                            0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f };
+	kmStreamVec p = kmStreamSet(c[7]), oneMinusA = kmStreamSub(kmStreamSet(1), a);
+	int k;
+
+	for (k = 6; k >= 0; k--)
+		p = kmStreamAdd(kmStreamSet(c[k]), kmStreamMul(a, p));
+	return kmStreamMul(kmStreamMul(oneMinusA, kmStreamRsqrt(oneMinusA)), p);
+}
+
+static inline kmStreamVec kmQuaternionStreamSin4(kmStreamVec x)
+{
+	static const float c[5] = { -1.6666667e-1f, 8.3333333e-3f, -1.9841270e-4f, 2.7557319e-6f, -2.5052108e-8f };
+	kmStreamVec x2 = kmStreamMul(x, x), p = kmStreamSet(c[4]);
+	int k;
+
+	for (k = 3; k >= 0; k--)
+		p = kmStreamAdd(kmStreamSet(c[k]), kmStreamMul(x2, p));
+	return kmStreamAdd(x, kmStreamMul(kmStreamMul(x, x2), p));
+}
+
+#endif
+
+/**
+ * Interpolates count pairs of quaternions by t, the results are stored in
+ * pOut, returns pOut
+ */
+kmQuaternionStream* kmQuaternionStreamNlerp(kmQuaternionStream* pOut, const kmQuaternionStream* pQ1, const kmQuaternionStream* pQ2, kmScalar t, unsigned int count)
+{
+	unsigned int i = 0;
+
+#if defined(KM_STREAM_RSQRT)
+	kmStreamVec s1 = kmStreamSet(1 - t), s2 = kmStreamSet(t);
+
+	for (; i + 4 <= count; i += 4)
+		kmQuaternionStreamBlend4(pOut, pQ1, pQ2, kmQuaternionStreamDot4(pQ1, pQ2, i), s1, s2, i);
+#endif
+
+	for (; i < count; i++)
+		kmQuaternionStreamBlend(pOut, pQ1, pQ2, kmQuaternionStreamDot(pQ1, pQ2, i), 1 - t, t, i);
+	return pOut;
+}
+
+/**
+ * Spherically interpolates count pairs of quaternions by t, the results
+ * are stored in pOut, returns pOut
+ */
+kmQuaternionStream* kmQuaternionStreamSlerp(kmQuaternionStream* pOut, const kmQuaternionStream* pQ1, const kmQuaternionStream* pQ2, kmScalar t, unsigned int count)
+{
+	unsigned int i = 0;
+
+#if defined(KM_STREAM_RSQRT)
+	kmStreamVec one = kmStreamSet(1), linear = kmStreamSet(KM_QUAT_STREAM_LINEAR);
+	kmStreamVec vt = kmStreamSet(t), oneMinusT = kmStreamSet(1 - t);
+
+	for (; i + 4 <= count; i += 4) {
+		kmStreamVec d = kmQuaternionStreamDot4(pQ1, pQ2, i);
+		kmStreamVec a = kmStreamAbs(d);
+		kmStreamVec theta = kmQuaternionStreamAcos4(a);
+		kmStreamVec inv = kmStreamRsqrt(kmStreamSub(one, kmStreamMul(a, a)));
+		kmStreamVec s1 = kmStreamMul(kmQuaternionStreamSin4(kmStreamMul(oneMinusT, theta)), inv);
+		kmStreamVec s2 = kmStreamMul(kmQuaternionStreamSin4(kmStreamMul(vt, theta)), inv);
+		/* nearly the same, the lanes above are nonsense when a is 1 */
+		kmStreamMask nearlyEqual = kmStreamLess(linear, a);
+
+		s1 = kmStreamSelect(nearlyEqual, oneMinusT, s1);
+		s2 = kmStreamSelect(nearlyEqual, vt, s2);
+		kmQuaternionStreamBlend4(pOut, pQ1, pQ2, d, s1, s2, i);
+	}
+#endif
+
+	for (; i < count; i++) {
+		kmScalar d = kmQuaternionStreamDot(pQ1, pQ2, i);
+		kmScalar a = fabsf(d), s1 = 1 - t, s2 = t;
+
+		if (!(KM_QUAT_STREAM_LINEAR < a)) {
+			kmScalar theta = kmQuaternionStreamAcos(a);
+			kmScalar inv = kmInlineRsqrt(1 - a * a);
+			s1 = kmQuaternionStreamSin((1 - t) * theta) * inv;
+			s2 = kmQuaternionStreamSin(t * theta) * inv;
+		}
+		kmQuaternionStreamBlend(pOut, pQ1, pQ2, d, s1, s2, i);
+	}
+	return pOut;
+}
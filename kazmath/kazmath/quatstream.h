@@ -0,0 +1,46 @@
+/**
+ * @file quatstream.h
+ *
+ * Structure of arrays quaternions for animating thousands of objects at a
+ * time, interpolating each object's rotation between two key frames with
+ * SSE or NEON the same way vec3stream.h does for vectors (on 32 bit ARM
+ * only with KAZMATH_FAST_MATH, see quatstream.c)
+ */
+
+#ifndef QUATSTREAM_H_INCLUDED
+#define QUATSTREAM_H_INCLUDED
+
+#include "utility.h"
+
+struct kmQuaternion;
+
+typedef struct kmQuaternionStream {
+	kmScalar* x;
+	kmScalar* y;
+	kmScalar* z;
+	kmScalar* w;
+} kmQuaternionStream;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * pOut may be the same stream as either input but the arrays must not
+ * otherwise overlap, count doesn't need to be a multiple of 4
+ *
+ * Unlike kmQuaternionSlerp both interpolations take the shorter way round
+ * (negating q2 when the dot product is negative) and always give a unit
+ * quaternion
+ */
+kmQuaternionStream* kmQuaternionStreamFill(kmQuaternionStream* pOut, kmScalar* x, kmScalar* y, kmScalar* z, kmScalar* w);
+struct kmQuaternion* kmQuaternionStreamGet(struct kmQuaternion* pOut, const kmQuaternionStream* pIn, unsigned int i); /** Copies quaternion i out of the stream */
+kmQuaternionStream* kmQuaternionStreamSet(kmQuaternionStream* pOut, unsigned int i, const struct kmQuaternion* pIn); /** Copies a quaternion into the stream at i */
+
+kmQuaternionStream* kmQuaternionStreamNlerp(kmQuaternionStream* pOut, const kmQuaternionStream* pQ1, const kmQuaternionStream* pQ2, kmScalar t, unsigned int count); /** Normalized linear interpolation, the angle doesn't change at a constant rate */
+kmQuaternionStream* kmQuaternionStreamSlerp(kmQuaternionStream* pOut, const kmQuaternionStream* pQ1, const kmQuaternionStream* pQ2, kmScalar t, unsigned int count); /** Spherical linear interpolation, within about 1e-6 of kmQuaternionSlerp */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* QUATSTREAM_H_INCLUDED */
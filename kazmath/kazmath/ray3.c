@@ -1,5 +1,11 @@
+#include <math.h>
+#include <float.h>
+
 #include "plane.h"
+#include "aabb.h"
 #include "ray3.h"
+#include "streamsimd.h"
+#include "fastmath.h"
 
 kmRay3* kmRay3Fill(kmRay3* ray, kmScalar px, kmScalar py, kmScalar pz, kmScalar vx, kmScalar vy, kmScalar vz) {
     ray->start.x = px;
@@ -21,7 +27,7 @@ kmRay3* kmRay3FromPointAndDirection(kmRay3* ray, const kmVec3* point, const kmVe
 
 kmVec3* kmRay3IntersectPlane(kmVec3* pOut, const kmRay3* ray, const kmPlane* plane) {
     //t = - (A*org.x + B*org.y + C*org.z + D) / (A*dir.x + B*dir.y + C*dir.z )
-    double t = -(plane->a * ray->start.x +
+    kmWideScalar t = -(plane->a * ray->start.x +
                  plane->b * ray->start.y +
                  plane->c * ray->start.z + plane->d) / (
                  plane->a * ray->dir.x +
@@ -34,3 +40,259 @@ kmVec3* kmRay3IntersectPlane(kmVec3* pOut, const kmRay3* ray, const kmPlane* pla
     kmVec3Add(pOut, &ray->start, &scaled_dir);
     return pOut;
 }
+
+/*
+ * Moller-Trumbore with the divide left until the hit is known to be no
+ * further than tMax, a, b and c are the triangle's x, y, z
+ */
+static inline kmBool kmRay3Triangle(const kmVec3* start, const kmVec3* dir, const kmScalar* a,
+                                    const kmScalar* b, const kmScalar* c, kmScalar tMax, kmScalar* pT) {
+    kmScalar e1x = b[0] - a[0], e1y = b[1] - a[1], e1z = b[2] - a[2];
+    kmScalar e2x = c[0] - a[0], e2y = c[1] - a[1], e2z = c[2] - a[2];
+    kmScalar px = dir->y * e2z - dir->z * e2y;
+    kmScalar py = dir->z * e2x - dir->x * e2z;
+    kmScalar pz = dir->x * e2y - dir->y * e2x;
+    kmScalar det = e1x * px + e1y * py + e1z * pz;
+    kmScalar sx = start->x - a[0], sy = start->y - a[1], sz = start->z - a[2];
+    kmScalar qx, qy, qz, u, v, t;
+
+    if (det == 0)
+        return KM_FALSE;
+    // flipping s flips u, v and t so they can be compared with a positive det
+    if (det < 0) {
+        det = -det;
+        sx = -sx;
+        sy = -sy;
+        sz = -sz;
+    }
+
+    u = sx * px + sy * py + sz * pz;
+    if (u < 0 || u > det)
+        return KM_FALSE;
+
+    qx = sy * e1z - sz * e1y;
+    qy = sz * e1x - sx * e1z;
+    qz = sx * e1y - sy * e1x;
+    v = dir->x * qx + dir->y * qy + dir->z * qz;
+    if (v < 0 || u + v > det)
+        return KM_FALSE;
+
+    t = e2x * qx + e2y * qy + e2z * qz;
+    if (t < 0 || t > tMax * det)
+        return KM_FALSE;
+
+    *pT = t / det;
+    return KM_TRUE;
+}
+
+static void kmRay3Result(const kmRay3* ray, kmScalar t, kmVec3* intersection, kmScalar* distance) {
+    if (intersection) {
+        kmVec3 scaled_dir;
+        kmVec3Scale(&scaled_dir, &ray->dir, t);
+        kmVec3Add(intersection, &ray->start, &scaled_dir);
+    }
+    if (distance)
+        *distance = t;
+}
+
+/**
+ * Tests both sides of the triangle, normal is the unit normal of its
+ * front (anticlockwise) face
+ */
+kmBool kmRay3IntersectTriangle(const kmRay3* ray, const kmVec3* p1, const kmVec3* p2, const kmVec3* p3,
+                               kmVec3* intersection, kmVec3* normal, kmScalar* distance) {
+    kmScalar a[3] = { p1->x, p1->y, p1->z };
+    kmScalar b[3] = { p2->x, p2->y, p2->z };
+    kmScalar c[3] = { p3->x, p3->y, p3->z };
+    kmScalar t;
+
+    if (!kmRay3Triangle(&ray->start, &ray->dir, a, b, c, FLT_MAX, &t))
+        return KM_FALSE;
+
+    kmRay3Result(ray, t, intersection, distance);
+    if (normal) {
+        kmVec3 e1, e2;
+        kmVec3Subtract(&e1, p2, p1);
+        kmVec3Subtract(&e2, p3, p1);
+        kmVec3Normalize(normal, kmVec3Cross(normal, &e1, &e2));
+    }
+    return KM_TRUE;
+}
+
+/**
+ * Slab test, a ray starting inside the box hits it at distance 0
+ */
+kmBool kmRay3IntersectAABB(const kmRay3* ray, const kmAABB* box, kmVec3* intersection, kmScalar* distance) {
+    kmScalar tNear = 0, tFar = FLT_MAX;
+    kmScalar start[3] = { ray->start.x, ray->start.y, ray->start.z };
+    kmScalar dir[3] = { ray->dir.x, ray->dir.y, ray->dir.z };
+    kmScalar min[3] = { box->min.x, box->min.y, box->min.z };
+    kmScalar max[3] = { box->max.x, box->max.y, box->max.z };
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        kmScalar inv, t1, t2;
+        if (dir[i] == 0) {
+            // parallel to the slab, it misses unless it starts between them
+            if (start[i] < min[i] || start[i] > max[i])
+                return KM_FALSE;
+            continue;
+        }
+        inv = 1.0f / dir[i];
+        t1 = (min[i] - start[i]) * inv;
+        t2 = (max[i] - start[i]) * inv;
+        if (t1 > t2) {
+            kmScalar t = t1;
+            t1 = t2;
+            t2 = t;
+        }
+        if (t1 > tNear) tNear = t1;
+        if (t2 < tFar) tFar = t2;
+        if (tNear > tFar)
+            return KM_FALSE;
+    }
+
+    kmRay3Result(ray, tNear, intersection, distance);
+    return KM_TRUE;
+}
+
+/**
+ * A ray starting inside the sphere hits it at distance 0
+ */
+kmBool kmRay3IntersectSphere(const kmRay3* ray, const kmVec3* centre, kmScalar radius,
+                             kmVec3* intersection, kmScalar* distance) {
+    kmVec3 m, l;
+    kmScalar a, b, c, disc, t;
+
+    kmVec3Subtract(&m, &ray->start, centre);
+    a = kmVec3Dot(&ray->dir, &ray->dir);
+    b = kmVec3Dot(&m, &ray->dir);
+    c = kmVec3Dot(&m, &m) - radius * radius;
+
+    // outside and pointing away
+    if (a == 0 || (c > 0 && b > 0))
+        return KM_FALSE;
+
+    /*
+     * b * b - a * c loses most of its precision when the sphere is small
+     * and far away, a * (radius^2 - the squared distance from the centre to
+     * the line) is the same thing without the cancellation
+     */
+    kmVec3Scale(&l, &ray->dir, b / a);
+    kmVec3Subtract(&l, &m, &l);
+    disc = a * (radius * radius - kmVec3Dot(&l, &l));
+    if (disc < 0)
+        return KM_FALSE;
+
+    t = (-b - sqrtf(disc)) / a;
+    kmRay3Result(ray, t < 0 ? 0 : t, intersection, distance);
+    return KM_TRUE;
+}
+
+#if defined(KM_STREAM_SIMD)
+
+/*
+ * kmRay3Triangle on 4 triangles at once, the corners are gathered into
+ * structure of arrays first.  Uses the same operations so the distances
+ * are the same, returns a bit for each triangle hit no further than tMax
+ * with num and det (t = num / det) for each
+ */
+static int kmRay3Triangles4(const kmVec3* start, const kmVec3* dir, const kmScalar* corners[12],
+                            kmScalar tMax, kmScalar* num, kmScalar* det) {
+    kmScalar g[9][4];
+    kmStreamVec ax, ay, az, e1x, e1y, e1z, e2x, e2y, e2z, px, py, pz, d, sx, sy, sz, qx, qy, qz, u, v, t;
+    kmStreamVec zero = kmStreamSet(0), dx = kmStreamSet(dir->x), dy = kmStreamSet(dir->y), dz = kmStreamSet(dir->z);
+    kmStreamMask hit;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        const kmScalar* a = corners[i * 3];
+        const kmScalar* b = corners[i * 3 + 1];
+        const kmScalar* c = corners[i * 3 + 2];
+        g[0][i] = a[0]; g[1][i] = a[1]; g[2][i] = a[2];
+        g[3][i] = b[0] - a[0]; g[4][i] = b[1] - a[1]; g[5][i] = b[2] - a[2];
+        g[6][i] = c[0] - a[0]; g[7][i] = c[1] - a[1]; g[8][i] = c[2] - a[2];
+    }
+    ax = kmStreamLoad(g[0]); ay = kmStreamLoad(g[1]); az = kmStreamLoad(g[2]);
+    e1x = kmStreamLoad(g[3]); e1y = kmStreamLoad(g[4]); e1z = kmStreamLoad(g[5]);
+    e2x = kmStreamLoad(g[6]); e2y = kmStreamLoad(g[7]); e2z = kmStreamLoad(g[8]);
+
+    px = kmStreamSub(kmStreamMul(dy, e2z), kmStreamMul(dz, e2y));
+    py = kmStreamSub(kmStreamMul(dz, e2x), kmStreamMul(dx, e2z));
+    pz = kmStreamSub(kmStreamMul(dx, e2y), kmStreamMul(dy, e2x));
+    d = kmStreamAdd(kmStreamAdd(kmStreamMul(e1x, px), kmStreamMul(e1y, py)), kmStreamMul(e1z, pz));
+
+    /* negating s where det is negative, the same as the scalar code */
+    sx = kmStreamFlipSign(kmStreamSub(kmStreamSet(start->x), ax), d);
+    sy = kmStreamFlipSign(kmStreamSub(kmStreamSet(start->y), ay), d);
+    sz = kmStreamFlipSign(kmStreamSub(kmStreamSet(start->z), az), d);
+    hit = kmStreamLess(zero, kmStreamAbs(d));
+    d = kmStreamAbs(d);
+
+    u = kmStreamAdd(kmStreamAdd(kmStreamMul(sx, px), kmStreamMul(sy, py)), kmStreamMul(sz, pz));
+    hit = kmStreamAnd(hit, kmStreamAnd(kmStreamLessEqual(zero, u), kmStreamLessEqual(u, d)));
+
+    qx = kmStreamSub(kmStreamMul(sy, e1z), kmStreamMul(sz, e1y));
+    qy = kmStreamSub(kmStreamMul(sz, e1x), kmStreamMul(sx, e1z));
+    qz = kmStreamSub(kmStreamMul(sx, e1y), kmStreamMul(sy, e1x));
+    v = kmStreamAdd(kmStreamAdd(kmStreamMul(dx, qx), kmStreamMul(dy, qy)), kmStreamMul(dz, qz));
+    hit = kmStreamAnd(hit, kmStreamAnd(kmStreamLessEqual(zero, v), kmStreamLessEqual(kmStreamAdd(u, v), d)));
+
+    t = kmStreamAdd(kmStreamAdd(kmStreamMul(e2x, qx), kmStreamMul(e2y, qy)), kmStreamMul(e2z, qz));
+    hit = kmStreamAnd(hit, kmStreamAnd(kmStreamLessEqual(zero, t),
+                                       kmStreamLessEqual(t, kmStreamMul(kmStreamSet(tMax), d))));
+
+    kmStreamStore(num, t);
+    kmStreamStore(det, d);
+    return kmStreamBits(hit);
+}
+
+#endif
+
+/**
+ * Tests every triangle of a mesh in the layout GBO files use, verts is x,
+ * y, z for each vertex and count is the number of indices, or of vertices
+ * when indices is NULL (a triangle soup).
+ *
+ * *distance is the furthest to look on the way in, pass FLT_MAX for no
+ * limit.  Returns the nearest triangle hit (index / 3) setting *distance
+ * to where, or -1
+ */
+int kmRay3IntersectTriangles(const kmRay3* ray, const kmScalar* verts, const unsigned short* indices,
+                             unsigned int count, kmScalar* distance) {
+    kmScalar best = *distance, t;
+    unsigned int i = 0;
+    int hit = -1;
+
+#if defined(KM_STREAM_SIMD)
+    for (; i + 12 <= count; i += 12) {
+        const kmScalar* corners[12];
+        kmScalar num[4], det[4];
+        int j, bits;
+
+        for (j = 0; j < 12; j++)
+            corners[j] = verts + 3 * (indices ? indices[i + j] : i + j);
+        bits = kmRay3Triangles4(&ray->start, &ray->dir, corners, best, num, det);
+        for (j = 0; bits; j++, bits >>= 1) {
+            if ((bits & 1) && num[j] <= best * det[j]) {
+                best = num[j] / det[j];
+                hit = i / 3 + j;
+            }
+        }
+    }
+#endif
+
+    for (; i + 2 < count; i += 3) {
+        const kmScalar* a = verts + 3 * (indices ? indices[i] : i);
+        const kmScalar* b = verts + 3 * (indices ? indices[i + 1] : i + 1);
+        const kmScalar* c = verts + 3 * (indices ? indices[i + 2] : i + 2);
+        if (kmRay3Triangle(&ray->start, &ray->dir, a, b, c, best, &t)) {
+            best = t;
+            hit = i / 3;
+        }
+    }
+
+    if (hit != -1)
+        *distance = best;
+    return hit;
+}
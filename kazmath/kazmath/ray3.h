@@ -14,11 +14,21 @@ typedef struct kmRay3 {
 } kmRay3;
 
 struct kmPlane;
+struct kmAABB;
 
 kmRay3* kmRay3Fill(kmRay3* ray, kmScalar px, kmScalar py, kmScalar pz, kmScalar vx, kmScalar vy, kmScalar vz);
 kmRay3* kmRay3FromPointAndDirection(kmRay3* ray, const kmVec3* point, const kmVec3* direction);
 kmVec3* kmRay3IntersectPlane(kmVec3* pOut, const kmRay3* ray, const struct kmPlane* plane);
 
+/*
+ * distances are in multiples of the ray's direction, intersection, normal
+ * and distance can be NULL
+ */
+kmBool kmRay3IntersectTriangle(const kmRay3* ray, const kmVec3* p1, const kmVec3* p2, const kmVec3* p3, kmVec3* intersection, kmVec3* normal, kmScalar* distance);
+kmBool kmRay3IntersectAABB(const kmRay3* ray, const struct kmAABB* box, kmVec3* intersection, kmScalar* distance);
+kmBool kmRay3IntersectSphere(const kmRay3* ray, const kmVec3* centre, kmScalar radius, kmVec3* intersection, kmScalar* distance);
+int kmRay3IntersectTriangles(const kmRay3* ray, const kmScalar* verts, const unsigned short* indices, unsigned int count, kmScalar* distance);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,108 @@
+/**
+ * @file streamsimd.h
+ *
+ * Private to kazmath, 4 wide SSE or NEON operations shared by the stream
+ * (structure of arrays) functions.  KM_STREAM_SIMD is defined when they're
+ * available and KM_STREAM_SQRT when there's also a vector square root and
+ * divide (not on 32 bit ARM), define KAZMATH_NO_SIMD to use neither.
+ * KM_STREAM_RSQRT is defined when there's a kmStreamRsqrt, which is either
+ * 1 / sqrt (so not on 32 bit ARM) or, with KAZMATH_FAST_MATH, the same
+ * estimate and Newton steps as kmInlineRsqrt in fastmath.h so the stream
+ * and single functions agree.
+ *
+ * Masks are the result of a comparison, kmStreamBits turns one into a bit
+ * per lane (lane 0 is bit 0)
+ */
+
+#ifndef STREAMSIMD_H_INCLUDED
+#define STREAMSIMD_H_INCLUDED
+
+#if !defined(KAZMATH_NO_SIMD) && !defined(USE_DOUBLE_PRECISION)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define KM_STREAM_SIMD
+#define KM_STREAM_SQRT
+typedef __m128 kmStreamVec;
+typedef __m128 kmStreamMask;
+#define kmStreamLoad(p) _mm_loadu_ps(p)
+#define kmStreamStore(p, v) _mm_storeu_ps(p, v)
+#define kmStreamSet(s) _mm_set1_ps(s)
+#define kmStreamAdd(a, b) _mm_add_ps(a, b)
+#define kmStreamSub(a, b) _mm_sub_ps(a, b)
+#define kmStreamMul(a, b) _mm_mul_ps(a, b)
+#define kmStreamAbs(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), a)
+#define kmStreamDiv(a, b) _mm_div_ps(a, b)
+#define kmStreamSqrt(a) _mm_sqrt_ps(a)
+/* a where mask is greater than zero, otherwise zero */
+#define kmStreamIfPositive(mask, a) _mm_and_ps(_mm_cmpgt_ps(mask, _mm_setzero_ps()), a)
+#define kmStreamLess(a, b) _mm_cmplt_ps(a, b)
+#define kmStreamLessEqual(a, b) _mm_cmple_ps(a, b)
+#define kmStreamOr(a, b) _mm_or_ps(a, b)
+#define kmStreamAnd(a, b) _mm_and_ps(a, b)
+#define kmStreamBits(m) _mm_movemask_ps(m)
+/* a with its sign flipped where s is negative */
+#define kmStreamFlipSign(a, s) _mm_xor_ps(a, _mm_and_ps(s, _mm_set1_ps(-0.0f)))
+/* a where the mask is set, otherwise b */
+#define kmStreamSelect(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define KM_STREAM_RSQRT
+#if defined(KAZMATH_FAST_MATH)
+static inline __m128 kmStreamRsqrt(__m128 a)
+{
+	__m128 y = _mm_rsqrt_ps(a);
+	__m128 t = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), a), y), y);
+	return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), t));
+}
+#else
+#define kmStreamRsqrt(a) _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define KM_STREAM_SIMD
+typedef float32x4_t kmStreamVec;
+typedef uint32x4_t kmStreamMask;
+#define kmStreamLoad(p) vld1q_f32(p)
+#define kmStreamStore(p, v) vst1q_f32(p, v)
+#define kmStreamSet(s) vdupq_n_f32(s)
+#define kmStreamAdd(a, b) vaddq_f32(a, b)
+#define kmStreamSub(a, b) vsubq_f32(a, b)
+#define kmStreamMul(a, b) vmulq_f32(a, b)
+#define kmStreamAbs(a) vabsq_f32(a)
+#define kmStreamLess(a, b) vcltq_f32(a, b)
+#define kmStreamLessEqual(a, b) vcleq_f32(a, b)
+#define kmStreamOr(a, b) vorrq_u32(a, b)
+#define kmStreamAnd(a, b) vandq_u32(a, b)
+#define kmStreamFlipSign(a, s) vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), \
+	vandq_u32(vreinterpretq_u32_f32(s), vdupq_n_u32(0x80000000))))
+#define kmStreamSelect(m, a, b) vbslq_f32(m, a, b)
+#define kmStreamIfPositive(mask, a) vreinterpretq_f32_u32(vandq_u32( \
+	vcgtq_f32(mask, vdupq_n_f32(0)), vreinterpretq_u32_f32(a)))
+#if defined(__aarch64__)
+#define KM_STREAM_SQRT
+#define kmStreamDiv(a, b) vdivq_f32(a, b)
+#define kmStreamSqrt(a) vsqrtq_f32(a)
+#endif
+#if defined(KAZMATH_FAST_MATH)
+#define KM_STREAM_RSQRT
+/* an 8 bit estimate so two Newton steps, as kmInlineRsqrt */
+static inline float32x4_t kmStreamRsqrt(float32x4_t a)
+{
+	float32x4_t y = vrsqrteq_f32(a);
+	y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(a, y), y));
+	return vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(a, y), y));
+}
+#elif defined(__aarch64__)
+#define KM_STREAM_RSQRT
+#define kmStreamRsqrt(a) vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(a))
+#endif
+
+static inline int kmStreamBits(uint32x4_t m)
+{
+	static const uint32_t lanes[4] = { 1, 2, 4, 8 };
+	uint32x4_t bits = vandq_u32(m, vld1q_u32(lanes));
+	uint32x2_t sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+	return vget_lane_u32(vpadd_u32(sum, sum), 0);
+}
+#endif
+#endif
+
+#endif /* STREAMSIMD_H_INCLUDED */
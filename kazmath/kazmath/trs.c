@@ -0,0 +1,84 @@
+/**
+ * @file trs.c
+ *
+ * kmTRSToMat4 writes the rotation matrix of the quaternion with each
+ * column multiplied by the scale and the translation in the last column,
+ * what kmMat4Translation, kmMat4RotationQuaternion and kmMat4Scaling
+ * multiplied together would give without building or multiplying them.
+ */
+
+#include "utility.h"
+#include "vec3.h"
+#include "mat4.h"
+#include "quaternion.h"
+#include "trs.h"
+#include "fastmath.h"
+
+kmTRS* kmTRSIdentity(kmTRS* pOut)
+{
+	kmVec3Fill(&pOut->translation, 0, 0, 0);
+	kmQuaternionIdentity(&pOut->rotation);
+	kmVec3Fill(&pOut->scale, 1, 1, 1);
+	return pOut;
+}
+
+kmTRS* kmTRSFill(kmTRS* pOut, const kmVec3* pTranslation, const kmQuaternion* pRotation, const kmVec3* pScale)
+{
+	kmVec3Assign(&pOut->translation, pTranslation);
+	kmQuaternionAssign(&pOut->rotation, pRotation);
+	kmVec3Assign(&pOut->scale, pScale);
+	return pOut;
+}
+
+/**
+ * The product of the yaw (y), pitch (x) and roll (z) quaternions in the
+ * order kmMat4RotationYawPitchRoll multiplies its matrices, returns pOut
+ */
+kmQuaternion* kmTRSRotationYawPitchRoll(kmQuaternion* pOut, kmScalar pitch, kmScalar yaw, kmScalar roll)
+{
+	kmScalar sp, cp, sy, cy, sr, cr;
+	kmInlineSinCos(pitch * 0.5f, &sp, &cp);
+	kmInlineSinCos(yaw * 0.5f, &sy, &cy);
+	kmInlineSinCos(roll * 0.5f, &sr, &cr);
+
+	pOut->x = cy * sp * cr + sy * cp * sr;
+	pOut->y = sy * cp * cr - cy * sp * sr;
+	pOut->z = cy * cp * sr - sy * sp * cr;
+	pOut->w = cy * cp * cr + sy * sp * sr;
+	return pOut;
+}
+
+/**
+ * Builds the matrix translation * rotation * scale, the result is stored
+ * in pOut, returns pOut
+ */
+kmMat4* kmTRSToMat4(kmMat4* pOut, const kmTRS* pIn)
+{
+	const kmQuaternion* q = &pIn->rotation;
+	kmScalar xx = q->x * q->x, xy = q->x * q->y, xz = q->x * q->z, xw = q->x * q->w;
+	kmScalar yy = q->y * q->y, yz = q->y * q->z, yw = q->y * q->w;
+	kmScalar zz = q->z * q->z, zw = q->z * q->w;
+	kmScalar sx = pIn->scale.x, sy = pIn->scale.y, sz = pIn->scale.z;
+
+	pOut->mat[0] = (1 - 2 * (yy + zz)) * sx;
+	pOut->mat[1] = 2 * (xy + zw) * sx;
+	pOut->mat[2] = 2 * (xz - yw) * sx;
+	pOut->mat[3] = 0;
+
+	pOut->mat[4] = 2 * (xy - zw) * sy;
+	pOut->mat[5] = (1 - 2 * (xx + zz)) * sy;
+	pOut->mat[6] = 2 * (yz + xw) * sy;
+	pOut->mat[7] = 0;
+
+	pOut->mat[8] = 2 * (xz + yw) * sz;
+	pOut->mat[9] = 2 * (yz - xw) * sz;
+	pOut->mat[10] = (1 - 2 * (xx + yy)) * sz;
+	pOut->mat[11] = 0;
+
+	pOut->mat[12] = pIn->translation.x;
+	pOut->mat[13] = pIn->translation.y;
+	pOut->mat[14] = pIn->translation.z;
+	pOut->mat[15] = 1;
+
+	return pOut;
+}
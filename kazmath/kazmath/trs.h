@@ -0,0 +1,36 @@
+/**
+ * @file trs.h
+ *
+ * An object's transform kept as a translation, a rotation quaternion and a
+ * scale instead of a matrix, cheaper to build and to interpolate, turned
+ * into a model matrix (translation * rotation * scale) with one call
+ */
+
+#ifndef TRS_H_INCLUDED
+#define TRS_H_INCLUDED
+
+#include "utility.h"
+#include "vec3.h"
+#include "quaternion.h"
+
+struct kmMat4;
+
+typedef struct kmTRS {
+	kmVec3 translation;
+	kmQuaternion rotation;  /** must be unit length */
+	kmVec3 scale;
+} kmTRS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+kmTRS* kmTRSIdentity(kmTRS* pOut);
+kmTRS* kmTRSFill(kmTRS* pOut, const kmVec3* pTranslation, const kmQuaternion* pRotation, const kmVec3* pScale);
+kmQuaternion* kmTRSRotationYawPitchRoll(kmQuaternion* pOut, kmScalar pitch, kmScalar yaw, kmScalar roll); /** The same rotation as kmMat4RotationYawPitchRoll as a quaternion */
+struct kmMat4* kmTRSToMat4(struct kmMat4* pOut, const kmTRS* pIn);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* TRS_H_INCLUDED */
@@ -24,6 +24,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "utility.h"
+#include "fastmath.h"
 
 /**
  * Returns the square of s (e.g. s*s)
@@ -62,3 +63,21 @@ kmScalar kmClamp(kmScalar x, kmScalar min, kmScalar max)
 {
     return x < min ? min : (x > max ? max : x);
 }
+
+/**
+ * Sets *pSin and *pCos to the sine and cosine of radians, approximated if
+ * kazmath was built with KAZMATH_FAST_MATH (see fastmath.h for the error)
+ */
+void kmSinCos(kmScalar radians, kmScalar* pSin, kmScalar* pCos)
+{
+	kmInlineSinCos(radians, pSin, pCos);
+}
+
+/**
+ * Returns 1 / sqrt(x) for x greater than zero, approximated if kazmath was
+ * built with KAZMATH_FAST_MATH
+ */
+kmScalar kmRsqrt(kmScalar x)
+{
+	return kmInlineRsqrt(x);
+}
@@ -88,6 +88,9 @@ extern kmBool kmAlmostEqual(kmScalar lhs, kmScalar rhs);
 
 extern kmScalar kmClamp(kmScalar x, kmScalar min, kmScalar max);
 
+extern void kmSinCos(kmScalar radians, kmScalar* pSin, kmScalar* pCos);
+extern kmScalar kmRsqrt(kmScalar x);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mat3.h"
 #include "vec2.h"
 #include "utility.h"
+#include "fastmath.h"
 
 kmVec2* kmVec2Fill(kmVec2* pOut, kmScalar x, kmScalar y)
 {
@@ -52,7 +53,7 @@ kmVec2* kmVec2Normalize(kmVec2* pOut, const kmVec2* pIn)
         if (!pIn->x && !pIn->y)
                 return kmVec2Assign(pOut, pIn);
 
-	kmScalar l = 1.0f / kmVec2Length(pIn);
+	kmScalar l = kmInlineRsqrt(pIn->x * pIn->x + pIn->y * pIn->y);
 
 	kmVec2 v;
 	v.x = pIn->x * l;
@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <memory.h>
 
 #include "utility.h"
+#include "fastmath.h"
 #include "vec4.h"
 #include "mat4.h"
 #include "mat3.h"
@@ -83,7 +84,7 @@ kmVec3* kmVec3Normalize(kmVec3* pOut, const kmVec3* pIn)
         if (!pIn->x && !pIn->y && !pIn->z)
                 return kmVec3Assign(pOut, pIn);
 
-        kmScalar l = 1.0f / kmVec3Length(pIn);
+        kmScalar l = kmInlineRsqrt(pIn->x * pIn->x + pIn->y * pIn->y + pIn->z * pIn->z);
 
 	kmVec3 v;
 	v.x = pIn->x * l;
@@ -0,0 +1,261 @@
+/**
+ * @file vec3stream.c
+ *
+ * Each function works on 4 vectors at a time with SSE or NEON (the same
+ * selection as kmMat4Multiply) then finishes any remainder with scalar
+ * code.  Operations are done in the same order as the kmVec3 functions so
+ * the results match them (bit for bit unless the compiler fuses the scalar
+ * multiply-adds).
+ *
+ * 32 bit ARM has no vector square root or divide so normalize and length
+ * are scalar there (normalize isn't with KAZMATH_FAST_MATH), see
+ * streamsimd.h
+ */
+
+#include <math.h>
+
+#include "utility.h"
+#include "vec3.h"
+#include "mat4.h"
+#include "vec3stream.h"
+#include "streamsimd.h"
+#include "fastmath.h"
+
+kmVec3Stream* kmVec3StreamFill(kmVec3Stream* pOut, kmScalar* x, kmScalar* y, kmScalar* z)
+{
+	pOut->x = x;
+	pOut->y = y;
+	pOut->z = z;
+	return pOut;
+}
+
+kmVec3* kmVec3StreamGet(kmVec3* pOut, const kmVec3Stream* pIn, unsigned int i)
+{
+	pOut->x = pIn->x[i];
+	pOut->y = pIn->y[i];
+	pOut->z = pIn->z[i];
+	return pOut;
+}
+
+kmVec3Stream* kmVec3StreamSet(kmVec3Stream* pOut, unsigned int i, const kmVec3* pIn)
+{
+	pOut->x[i] = pIn->x;
+	pOut->y[i] = pIn->y;
+	pOut->z[i] = pIn->z;
+	return pOut;
+}
+
+/*
+ * transforms with or without the translation, w is 1 or 0
+ */
+static void kmVec3StreamMultiply(kmVec3Stream* pOut, const kmVec3Stream* pIn, const kmMat4* pM,
+                                 kmScalar w, unsigned int count)
+{
+	const kmScalar* m = pM->mat;
+	kmScalar tx = m[12] * w, ty = m[13] * w, tz = m[14] * w;
+	unsigned int i = 0;
+
+#if defined(KM_STREAM_SIMD)
+	kmStreamVec m0 = kmStreamSet(m[0]), m1 = kmStreamSet(m[1]), m2 = kmStreamSet(m[2]);
+	kmStreamVec m4 = kmStreamSet(m[4]), m5 = kmStreamSet(m[5]), m6 = kmStreamSet(m[6]);
+	kmStreamVec m8 = kmStreamSet(m[8]), m9 = kmStreamSet(m[9]), m10 = kmStreamSet(m[10]);
+	kmStreamVec vx = kmStreamSet(tx), vy = kmStreamSet(ty), vz = kmStreamSet(tz);
+
+	for (; i + 4 <= count; i += 4) {
+		kmStreamVec x = kmStreamLoad(pIn->x + i);
+		kmStreamVec y = kmStreamLoad(pIn->y + i);
+		kmStreamVec z = kmStreamLoad(pIn->z + i);
+		kmStreamVec rx = kmStreamAdd(kmStreamAdd(kmStreamAdd(kmStreamMul(x, m0), kmStreamMul(y, m4)), kmStreamMul(z, m8)), vx);
+		kmStreamVec ry = kmStreamAdd(kmStreamAdd(kmStreamAdd(kmStreamMul(x, m1), kmStreamMul(y, m5)), kmStreamMul(z, m9)), vy);
+		kmStreamVec rz = kmStreamAdd(kmStreamAdd(kmStreamAdd(kmStreamMul(x, m2), kmStreamMul(y, m6)), kmStreamMul(z, m10)), vz);
+		kmStreamStore(pOut->x + i, rx);
+		kmStreamStore(pOut->y + i, ry);
+		kmStreamStore(pOut->z + i, rz);
+	}
+#endif
+
+	for (; i < count; i++) {
+		kmScalar x = pIn->x[i], y = pIn->y[i], z = pIn->z[i];
+		pOut->x[i] = x * m[0] + y * m[4] + z * m[8] + tx;
+		pOut->y[i] = x * m[1] + y * m[5] + z * m[9] + ty;
+		pOut->z[i] = x * m[2] + y * m[6] + z * m[10] + tz;
+	}
+}
+
+/**
+ * Transforms count vectors (assuming w=1) by pM, the results are stored in
+ * pOut, returns pOut
+ */
+kmVec3Stream* kmVec3StreamTransform(kmVec3Stream* pOut, const kmVec3Stream* pIn, const kmMat4* pM, unsigned int count)
+{
+	kmVec3StreamMultiply(pOut, pIn, pM, 1, count);
+	return pOut;
+}
+
+/**
+ * Transforms count normals by pM ignoring its translation, the results are
+ * stored in pOut, returns pOut
+ */
+kmVec3Stream* kmVec3StreamTransformNormal(kmVec3Stream* pOut, const kmVec3Stream* pIn, const kmMat4* pM, unsigned int count)
+{
+	kmVec3StreamMultiply(pOut, pIn, pM, 0, count);
+	return pOut;
+}
+
+/**
+ * Sets count vectors to unit length, zero vectors are left as zero.
+ * The results are stored in pOut, returns pOut
+ */
+kmVec3Stream* kmVec3StreamNormalize(kmVec3Stream* pOut, const kmVec3Stream* pIn, unsigned int count)
+{
+	unsigned int i = 0;
+
+#if defined(KM_STREAM_RSQRT)
+	for (; i + 4 <= count; i += 4) {
+		kmStreamVec x = kmStreamLoad(pIn->x + i);
+		kmStreamVec y = kmStreamLoad(pIn->y + i);
+		kmStreamVec z = kmStreamLoad(pIn->z + i);
+		kmStreamVec l = kmStreamAdd(kmStreamAdd(kmStreamMul(x, x), kmStreamMul(y, y)), kmStreamMul(z, z));
+		l = kmStreamIfPositive(l, kmStreamRsqrt(l));
+		kmStreamStore(pOut->x + i, kmStreamMul(x, l));
+		kmStreamStore(pOut->y + i, kmStreamMul(y, l));
+		kmStreamStore(pOut->z + i, kmStreamMul(z, l));
+	}
+#endif
+
+	for (; i < count; i++) {
+		kmScalar x = pIn->x[i], y = pIn->y[i], z = pIn->z[i];
+		kmScalar l = x * x + y * y + z * z;
+		l = l > 0 ? kmInlineRsqrt(l) : 0;
+		pOut->x[i] = x * l;
+		pOut->y[i] = y * l;
+		pOut->z[i] = z * l;
+	}
+	return pOut;
+}
+
+/**
+ * Vectors perpendicular to each pair of vectors, the results are stored in
+ * pOut, returns pOut
+ */
+kmVec3Stream* kmVec3StreamCross(kmVec3Stream* pOut, const kmVec3Stream* pV1, const kmVec3Stream* pV2, unsigned int count)
+{
+	unsigned int i = 0;
+
+#if defined(KM_STREAM_SIMD)
+	for (; i + 4 <= count; i += 4) {
+		kmStreamVec ax = kmStreamLoad(pV1->x + i), ay = kmStreamLoad(pV1->y + i), az = kmStreamLoad(pV1->z + i);
+		kmStreamVec bx = kmStreamLoad(pV2->x + i), by = kmStreamLoad(pV2->y + i), bz = kmStreamLoad(pV2->z + i);
+		kmStreamVec rx = kmStreamSub(kmStreamMul(ay, bz), kmStreamMul(az, by));
+		kmStreamVec ry = kmStreamSub(kmStreamMul(az, bx), kmStreamMul(ax, bz));
+		kmStreamVec rz = kmStreamSub(kmStreamMul(ax, by), kmStreamMul(ay, bx));
+		kmStreamStore(pOut->x + i, rx);
+		kmStreamStore(pOut->y + i, ry);
+		kmStreamStore(pOut->z + i, rz);
+	}
+#endif
+
+	for (; i < count; i++) {
+		kmScalar ax = pV1->x[i], ay = pV1->y[i], az = pV1->z[i];
+		kmScalar bx = pV2->x[i], by = pV2->y[i], bz = pV2->z[i];
+		pOut->x[i] = ay * bz - az * by;
+		pOut->y[i] = az * bx - ax * bz;
+		pOut->z[i] = ax * by - ay * bx;
+	}
+	return pOut;
+}
+
+/**
+ * pV1 + pV2 * s for count vectors, the results are stored in pOut, returns
+ * pOut
+ */
+kmVec3Stream* kmVec3StreamAddScaled(kmVec3Stream* pOut, const kmVec3Stream* pV1, const kmVec3Stream* pV2, kmScalar s, unsigned int count)
+{
+	unsigned int i = 0;
+
+#if defined(KM_STREAM_SIMD)
+	kmStreamVec vs = kmStreamSet(s);
+
+	for (; i + 4 <= count; i += 4) {
+		kmStreamStore(pOut->x + i, kmStreamAdd(kmStreamLoad(pV1->x + i), kmStreamMul(kmStreamLoad(pV2->x + i), vs)));
+		kmStreamStore(pOut->y + i, kmStreamAdd(kmStreamLoad(pV1->y + i), kmStreamMul(kmStreamLoad(pV2->y + i), vs)));
+		kmStreamStore(pOut->z + i, kmStreamAdd(kmStreamLoad(pV1->z + i), kmStreamMul(kmStreamLoad(pV2->z + i), vs)));
+	}
+#endif
+
+	for (; i < count; i++) {
+		pOut->x[i] = pV1->x[i] + pV2->x[i] * s;
+		pOut->y[i] = pV1->y[i] + pV2->y[i] * s;
+		pOut->z[i] = pV1->z[i] + pV2->z[i] * s;
+	}
+	return pOut;
+}
+
+/**
+ * pIn * s + pV for count vectors, the results are stored in pOut, returns
+ * pOut
+ */
+kmVec3Stream* kmVec3StreamScaleAdd(kmVec3Stream* pOut, const kmVec3Stream* pIn, kmScalar s, const kmVec3* pV, unsigned int count)
+{
+	unsigned int i = 0;
+
+#if defined(KM_STREAM_SIMD)
+	kmStreamVec vs = kmStreamSet(s);
+	kmStreamVec vx = kmStreamSet(pV->x), vy = kmStreamSet(pV->y), vz = kmStreamSet(pV->z);
+
+	for (; i + 4 <= count; i += 4) {
+		kmStreamStore(pOut->x + i, kmStreamAdd(kmStreamMul(kmStreamLoad(pIn->x + i), vs), vx));
+		kmStreamStore(pOut->y + i, kmStreamAdd(kmStreamMul(kmStreamLoad(pIn->y + i), vs), vy));
+		kmStreamStore(pOut->z + i, kmStreamAdd(kmStreamMul(kmStreamLoad(pIn->z + i), vs), vz));
+	}
+#endif
+
+	for (; i < count; i++) {
+		pOut->x[i] = pIn->x[i] * s + pV->x;
+		pOut->y[i] = pIn->y[i] * s + pV->y;
+		pOut->z[i] = pIn->z[i] * s + pV->z;
+	}
+	return pOut;
+}
+
+/**
+ * Dot products of count pairs of vectors stored in pOut, returns pOut
+ */
+kmScalar* kmVec3StreamDot(kmScalar* pOut, const kmVec3Stream* pV1, const kmVec3Stream* pV2, unsigned int count)
+{
+	unsigned int i = 0;
+
+#if defined(KM_STREAM_SIMD)
+	for (; i + 4 <= count; i += 4) {
+		kmStreamVec d = kmStreamMul(kmStreamLoad(pV1->x + i), kmStreamLoad(pV2->x + i));
+		d = kmStreamAdd(d, kmStreamMul(kmStreamLoad(pV1->y + i), kmStreamLoad(pV2->y + i)));
+		d = kmStreamAdd(d, kmStreamMul(kmStreamLoad(pV1->z + i), kmStreamLoad(pV2->z + i)));
+		kmStreamStore(pOut + i, d);
+	}
+#endif
+
+	for (; i < count; i++)
+		pOut[i] = pV1->x[i] * pV2->x[i] + pV1->y[i] * pV2->y[i] + pV1->z[i] * pV2->z[i];
+	return pOut;
+}
+
+/**
+ * Lengths of count vectors stored in pOut, returns pOut
+ */
+kmScalar* kmVec3StreamLength(kmScalar* pOut, const kmVec3Stream* pIn, unsigned int count)
+{
+	unsigned int i = 0;
+
+#if defined(KM_STREAM_SQRT)
+	for (; i + 4 <= count; i += 4) {
+		kmStreamVec x = kmStreamLoad(pIn->x + i);
+		kmStreamVec y = kmStreamLoad(pIn->y + i);
+		kmStreamVec z = kmStreamLoad(pIn->z + i);
+		kmStreamStore(pOut + i, kmStreamSqrt(kmStreamAdd(kmStreamAdd(kmStreamMul(x, x), kmStreamMul(y, y)), kmStreamMul(z, z))));
+	}
+#endif
+
+	for (; i < count; i++)
+		pOut[i] = sqrtf(pIn->x[i] * pIn->x[i] + pIn->y[i] * pIn->y[i] + pIn->z[i] * pIn->z[i]);
+	return pOut;
+}
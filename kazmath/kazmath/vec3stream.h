@@ -0,0 +1,47 @@
+/**
+ * @file vec3stream.h
+ *
+ * Structure of arrays versions of the kmVec3 functions for working on
+ * thousands of vectors at a time (particles, vertices), each component is
+ * in its own array so 4 vectors can be processed with one SIMD instruction
+ */
+
+#ifndef VEC3STREAM_H_INCLUDED
+#define VEC3STREAM_H_INCLUDED
+
+#include "utility.h"
+
+struct kmMat4;
+struct kmVec3;
+
+typedef struct kmVec3Stream {
+	kmScalar* x;
+	kmScalar* y;
+	kmScalar* z;
+} kmVec3Stream;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * pOut may be the same stream as any input but the arrays must not
+ * otherwise overlap, count doesn't need to be a multiple of 4
+ */
+kmVec3Stream* kmVec3StreamFill(kmVec3Stream* pOut, kmScalar* x, kmScalar* y, kmScalar* z);
+struct kmVec3* kmVec3StreamGet(struct kmVec3* pOut, const kmVec3Stream* pIn, unsigned int i); /** Copies vector i out of the stream */
+kmVec3Stream* kmVec3StreamSet(kmVec3Stream* pOut, unsigned int i, const struct kmVec3* pIn); /** Copies a vector into the stream at i */
+
+kmVec3Stream* kmVec3StreamTransform(kmVec3Stream* pOut, const kmVec3Stream* pIn, const struct kmMat4* pM, unsigned int count); /** kmVec3Transform on each vector (w = 1) */
+kmVec3Stream* kmVec3StreamTransformNormal(kmVec3Stream* pOut, const kmVec3Stream* pIn, const struct kmMat4* pM, unsigned int count); /** kmVec3TransformNormal on each vector (w = 0) */
+kmVec3Stream* kmVec3StreamNormalize(kmVec3Stream* pOut, const kmVec3Stream* pIn, unsigned int count); /** Unit length vectors, zero vectors stay zero */
+kmVec3Stream* kmVec3StreamCross(kmVec3Stream* pOut, const kmVec3Stream* pV1, const kmVec3Stream* pV2, unsigned int count);
+kmVec3Stream* kmVec3StreamAddScaled(kmVec3Stream* pOut, const kmVec3Stream* pV1, const kmVec3Stream* pV2, kmScalar s, unsigned int count); /** pV1 + pV2 * s, eg position += velocity * dt */
+kmVec3Stream* kmVec3StreamScaleAdd(kmVec3Stream* pOut, const kmVec3Stream* pIn, kmScalar s, const struct kmVec3* pV, unsigned int count); /** pIn * s + pV, eg velocity = velocity * (1 - drag * dt) + gravity * dt */
+kmScalar* kmVec3StreamDot(kmScalar* pOut, const kmVec3Stream* pV1, const kmVec3Stream* pV2, unsigned int count);
+kmScalar* kmVec3StreamLength(kmScalar* pOut, const kmVec3Stream* pIn, unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* VEC3STREAM_H_INCLUDED */
@@ -28,6 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <assert.h>
 
 #include "utility.h"
+#include "fastmath.h"
 #include "vec4.h"
 #include "mat4.h"
 
@@ -83,7 +84,7 @@ kmVec4* kmVec4Normalize(kmVec4* pOut, const kmVec4* pIn) {
     if (!pIn->x && !pIn->y && !pIn->z && !pIn->w)
         return kmVec4Assign(pOut, pIn);
 
-	kmScalar l = 1.0f / kmVec4Length(pIn);
+	kmScalar l = kmInlineRsqrt(pIn->x * pIn->x + pIn->y * pIn->y + pIn->z * pIn->z + pIn->w * pIn->w);
 
 	kmVec4 v;
 	v.x = pIn->x * l;
@@ -1,6 +1,13 @@
 uniform sampler2D u_texture;
 
+#ifdef POINT_ATTRIBS
+varying vec4 v_color;
+#endif
+
 void main() {
 	gl_FragColor = texture2D(u_texture,gl_PointCoord);
+#ifdef POINT_ATTRIBS
+	gl_FragColor *= v_color;
+#endif
 	//gl_FragColor = vec4(1,1,1,0.5);
 }
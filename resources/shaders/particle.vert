@@ -3,10 +3,51 @@ attribute vec3		vertex_attrib;
 uniform mat4		mvp_uniform;
 
 uniform float		u_point_size;
+// when above 0 sizes are world units, pixels = size * u_attenuation / distance
+uniform float		u_attenuation;
+uniform vec2		u_size_range;	// smallest and largest size in pixels
+
+#ifdef BALLISTIC
+// vertex_attrib is where the point starts, it moves from u_time = spawn
+attribute vec3		vel_attrib;
+attribute float		spawn_attrib;
+
+uniform float		u_time;
+uniform vec3		u_gravity;
+uniform float		u_drag;		// slows points by u_drag * velocity
+#endif
+
+#ifdef POINT_ATTRIBS
+attribute float		size_attrib;
+attribute vec4		color_attrib;
+
+varying vec4		v_color;
+#endif
 
 void main(void) {
 
-	gl_PointSize = u_point_size;
+#ifdef POINT_ATTRIBS
+	float size = size_attrib;
+	v_color = color_attrib;
+#else
+	float size = u_point_size;
+#endif
+#ifdef BALLISTIC
+	// distance travelled per unit of starting velocity and of gravity
+	float age = u_time - spawn_attrib;
+	float v = age, g = 0.5 * age * age;
+	if (u_drag > 0.0) {
+		v = (1.0 - exp(-u_drag * age)) / u_drag;
+		g = (age - v) / u_drag;
+	}
+	gl_Position = mvp_uniform * vec4(vertex_attrib + vel_attrib * v + u_gravity * g, 1);
+	// not spawned yet, outside the clip volume
+	if (age < 0.0) gl_Position = vec4(2, 2, 2, 1);
+#else
 	gl_Position = mvp_uniform * vec4(vertex_attrib,1);
+#endif
+	// w is the distance in front of the eye with a perspective projection
+	if (u_attenuation > 0.0) size *= u_attenuation / gl_Position.w;
+	gl_PointSize = clamp(size, u_size_range.x, u_size_range.y);
 
 }
@@ -0,0 +1,304 @@
+#include <stdlib.h>
+#include "jobs.h"
+
+// the most jobs a thread can have started and not yet finished
+#define JOBS_PER_THREAD 4096
+#define JOB_MASK (JOBS_PER_THREAD - 1)
+
+// parallelFor splits the range into this many jobs for each thread
+#define JOBS_PER_FOR 4
+
+struct job_t {
+    jobFunc_t func;
+    void *data;
+    struct jobCounter_t *counter;
+    struct job_t *next;         // in a counter's waiting list
+    atomic_int busy;            // its slot in the ring can't be reused yet
+};
+
+/*
+ * the Chase-Lev deque, only the owner changes bottom (pushing and taking)
+ * while anyone can steal by moving top up with a compare and swap, when
+ * they meet the owner has to win the same race for the last job
+ */
+struct jobWorker_t {
+    struct jobSystem_t *js;
+    thrd_t thread;
+    atomic_long top, bottom;
+    _Atomic(struct job_t *) deque[JOBS_PER_THREAD];
+    struct job_t ring[JOBS_PER_THREAD];     // jobs this thread starts
+    unsigned int nextJob;
+    unsigned int seed;          // for picking who to steal from
+};
+
+struct jobSystem_t {
+    int threads, started;       // started is how many of them are new threads
+    struct jobWorker_t *worker[MAX_JOB_THREADS];
+    mtx_t lock;                 // only for sleeping
+    cnd_t wake;
+    atomic_int sleeping, quit;
+};
+
+// which worker (and so deque and ring) the running thread is
+static _Thread_local struct jobWorker_t *currentWorker;
+
+static int pushJob(struct jobWorker_t *w, struct job_t *job) {
+    long b = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&w->top, memory_order_acquire);
+    if (b - t >= JOBS_PER_THREAD) return 0;
+    atomic_store_explicit(&w->deque[b & JOB_MASK], job, memory_order_relaxed);
+    // thieves load bottom with acquire so they see the job once they see it
+    atomic_store_explicit(&w->bottom, b + 1, memory_order_release);
+    return 1;
+}
+
+static struct job_t* takeJob(struct jobWorker_t *w) {
+    long b = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&w->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&w->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    struct job_t *job = atomic_load_explicit(&w->deque[b & JOB_MASK], memory_order_relaxed);
+    if (t == b) {
+        // the last one, a thief may be after it too
+        if (!atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed))
+            job = NULL;
+        atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+static struct job_t* stealJob(struct jobWorker_t *w) {
+    long t = atomic_load_explicit(&w->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&w->bottom, memory_order_acquire);
+    if (t >= b) return NULL;
+    struct job_t *job = atomic_load_explicit(&w->deque[t & JOB_MASK], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed))
+        return NULL;
+    return job;
+}
+
+// the thread's own jobs first then the others', starting at a random one
+static struct job_t* findJob(struct jobSystem_t *js, struct jobWorker_t *w) {
+    struct job_t *job = takeJob(w);
+    if (job || js->threads == 1) return job;
+
+    w->seed = w->seed * 1103515245 + 12345;
+    int first = (w->seed >> 16) % js->threads;
+    for (int i = 0; i < js->threads; i++) {
+        struct jobWorker_t *victim = js->worker[(first + i) % js->threads];
+        if (victim != w && (job = stealJob(victim))) return job;
+    }
+    return NULL;
+}
+
+static int anyJobs(struct jobSystem_t *js) {
+    for (int i = 0; i < js->threads; i++) {
+        struct jobWorker_t *w = js->worker[i];
+        if (atomic_load(&w->bottom) > atomic_load(&w->top)) return 1;
+    }
+    return 0;
+}
+
+static void finishJob(struct jobSystem_t *js, struct job_t *job);
+
+static void executeJob(struct jobSystem_t *js, struct job_t *job) {
+    job->func(job->data);
+    finishJob(js, job);
+}
+
+// runs a job if there is one, otherwise gives up the rest of its time
+static void helpOut(struct jobSystem_t *js) {
+    struct job_t *job = findJob(js, currentWorker);
+    if (job) executeJob(js, job);
+    else thrd_yield();
+}
+
+static void wakeWorker(struct jobSystem_t *js) {
+    // the push has to be seen before sleeping is looked at
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&js->sleeping)) {
+        mtx_lock(&js->lock);
+        cnd_signal(&js->wake);
+        mtx_unlock(&js->lock);
+    }
+}
+
+// pushed onto the running thread's deque, helping out while it's full
+static void queueJob(struct jobSystem_t *js, struct job_t *job) {
+    while (!pushJob(currentWorker, job)) helpOut(js);
+    wakeWorker(js);
+}
+
+static void releaseWaiting(struct jobSystem_t *js, struct jobCounter_t *counter) {
+    struct job_t *job = atomic_exchange(&counter->waiting, NULL);
+    while (job) {
+        struct job_t *next = job->next;
+        queueJob(js, job);
+        job = next;
+    }
+}
+
+/*
+ * once count is 0 the counter may be gone (eg off the waiting thread's
+ * stack) as soon as the waiter sees finishing is 0 too
+ */
+static void finishJob(struct jobSystem_t *js, struct job_t *job) {
+    struct jobCounter_t *counter = job->counter;
+    atomic_store(&job->busy, 0);
+    if (!counter) return;
+    atomic_fetch_add(&counter->finishing, 1);
+    if (atomic_fetch_sub(&counter->count, 1) == 1) releaseWaiting(js, counter);
+    atomic_fetch_sub(&counter->finishing, 1);
+}
+
+// the next slot of the running thread's ring, helping out until it's free
+static struct job_t* newJob(struct jobSystem_t *js, jobFunc_t func, void *data,
+                            struct jobCounter_t *counter) {
+    struct jobWorker_t *w = currentWorker;
+    struct job_t *job = &w->ring[w->nextJob++ & JOB_MASK];
+    while (atomic_load(&job->busy)) helpOut(js);
+    atomic_store(&job->busy, 1);
+    job->func = func;
+    job->data = data;
+    job->counter = counter;
+    if (counter) atomic_fetch_add(&counter->count, 1);
+    return job;
+}
+
+static int jobWorker(void *arg) {
+    struct jobWorker_t *w = arg;
+    struct jobSystem_t *js = w->js;
+    currentWorker = w;
+
+    while (!atomic_load(&js->quit)) {
+        struct job_t *job = findJob(js, w);
+        if (job) {
+            executeJob(js, job);
+            continue;
+        }
+
+        /*
+         * sleeping is counted before looking again so a job pushed after
+         * the last look sees it and wakes someone
+         */
+        mtx_lock(&js->lock);
+        atomic_fetch_add(&js->sleeping, 1);
+        if (!anyJobs(js) && !atomic_load(&js->quit)) cnd_wait(&js->wake, &js->lock);
+        atomic_fetch_sub(&js->sleeping, 1);
+        mtx_unlock(&js->lock);
+    }
+    return 0;
+}
+
+static struct jobWorker_t* createWorker(struct jobSystem_t *js, int n) {
+    struct jobWorker_t *w = calloc(1, sizeof(struct jobWorker_t));
+    w->js = js;
+    w->seed = n + 1;
+    return w;
+}
+
+/*
+ * threads includes the one calling this, which becomes one of the system's
+ * threads (it only runs jobs while waiting in waitJobs or parallelFor)
+ */
+struct jobSystem_t* createJobSystem(int threads) {
+    if (threads < 1) threads = 1;
+    if (threads > MAX_JOB_THREADS) threads = MAX_JOB_THREADS;
+
+    struct jobSystem_t *js = calloc(1, sizeof(struct jobSystem_t));
+    mtx_init(&js->lock, mtx_plain);
+    cnd_init(&js->wake);
+    for (int i = 0; i < threads; i++) js->worker[i] = createWorker(js, i);
+    js->threads = threads;
+    currentWorker = js->worker[0];
+
+    // if a thread can't be started its deque stays empty, the others do the work
+    for (int i = 1; i < threads; i++) {
+        if (thrd_create(&js->worker[i]->thread, jobWorker, js->worker[i]) != thrd_success) break;
+        js->started++;
+    }
+    return js;
+}
+
+// func(data) is run by one of the threads, counter can be NULL
+void runJob(struct jobSystem_t* js, jobFunc_t func, void* data, struct jobCounter_t* counter) {
+    queueJob(js, newJob(js, func, data, counter));
+}
+
+/*
+ * runs func(data) once after's count is 0, counting it in counter straight
+ * away, so waiting for counter includes it
+ */
+void runJobAfter(struct jobSystem_t* js, jobFunc_t func, void* data,
+                 struct jobCounter_t* counter, struct jobCounter_t* after) {
+    struct job_t *job = newJob(js, func, data, counter);
+    job->next = atomic_load(&after->waiting);
+    while (!atomic_compare_exchange_weak(&after->waiting, &job->next, job));
+    // after may have finished before it was on the list
+    if (atomic_load(&after->count) == 0) releaseWaiting(js, after);
+}
+
+// runs jobs (anyone's) until counter gets to 0
+void waitJobs(struct jobSystem_t* js, struct jobCounter_t* counter) {
+    while (atomic_load(&counter->count) || atomic_load(&counter->finishing)) helpOut(js);
+}
+
+struct forRange_t {
+    void (*func)(void* data, int first, int end);
+    void *data;
+    int first, end;
+};
+
+static void forJob(void *data) {
+    struct forRange_t *r = data;
+    r->func(r->data, r->first, r->end);
+}
+
+/*
+ * func(data, first, end) for ranges from 0 to count split between the
+ * threads, returns once they're all done
+ */
+void parallelFor(struct jobSystem_t* js, int count, void (*func)(void* data, int first, int end),
+                 void* data) {
+    struct forRange_t range[MAX_JOB_THREADS * JOBS_PER_FOR];
+    struct jobCounter_t counter = { 0 };
+    int jobs = js->threads == 1 ? 1 : js->threads * JOBS_PER_FOR;
+    if (jobs > count) jobs = count;
+    if (jobs < 1) return;
+
+    for (int i = 0; i < jobs; i++) {
+        range[i].func = func;
+        range[i].data = data;
+        range[i].first = (long)count * i / jobs;
+        range[i].end = (long)count * (i + 1) / jobs;
+    }
+    // the first is done here rather than pushed
+    for (int i = 1; i < jobs; i++) runJob(js, forJob, &range[i], &counter);
+    forJob(&range[0]);
+    waitJobs(js, &counter);
+}
+
+int jobThreads(struct jobSystem_t* js) {
+    return js->threads;
+}
+
+// every job has to have finished
+void freeJobSystem(struct jobSystem_t* js) {
+    mtx_lock(&js->lock);
+    atomic_store(&js->quit, 1);
+    cnd_broadcast(&js->wake);
+    mtx_unlock(&js->lock);
+    for (int i = 1; i <= js->started; i++) thrd_join(js->worker[i]->thread, NULL);
+    if (currentWorker && currentWorker->js == js) currentWorker = NULL;
+    for (int i = 0; i < js->threads; i++) free(js->worker[i]);
+    cnd_destroy(&js->wake);
+    mtx_destroy(&js->lock);
+    free(js);
+}
@@ -0,0 +1,123 @@
+#include <time.h>
+#include <errno.h>
+#include <math.h>
+#include "loop.h"
+
+// a frame more than this late starts the deadlines again from now
+#define LATE_FRAMES 2
+
+static double monotonicNow(struct loopClock_t *clock) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void monotonicSleepUntil(struct loopClock_t *clock, double when) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)when;
+    ts.tv_nsec = (long)((when - ts.tv_sec) * 1e9);
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+#ifdef TIMER_ABSTIME
+    // carries on sleeping after a signal, any other error falls back to
+    // sleeping for however long is left
+    int err;
+    while ((err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR);
+    if (err == 0) return;
+#endif
+
+    // not thrd_sleep, tinycthread.c and its header can disagree about
+    // which clock TIME_UTC is
+    double delay = when - monotonicNow(clock);
+    if (delay <= 0) return;
+    ts.tv_sec = (time_t)delay;
+    ts.tv_nsec = (long)((delay - ts.tv_sec) * 1e9);
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR);
+}
+
+static struct loopClock_t monotonicClock = { monotonicNow, monotonicSleepUntil };
+
+// period is usually step, or a multiple of it
+void initGameLoop(struct gameLoop_t *loop, double step, double period) {
+    loop->step = step;
+    loop->period = period;
+    loop->maxUpdates = 10;
+    loop->alpha = 0;
+    loop->clock = &monotonicClock;
+    loop->start = loop->deadline = -1;
+    loop->behind = 0;
+    loop->updates = 0;
+    resetLoopStats(loop);
+}
+
+/*
+ * call at the start of each frame, returns how many updates of step
+ * seconds to do and sets alpha for drawing between the last two
+ */
+int startFrame(struct gameLoop_t *loop) {
+    double now = loop->clock->now(loop->clock);
+
+    if (loop->start < 0) {
+        // the first frame does one update
+        loop->deadline = now;
+        loop->behind = loop->step;
+    } else {
+        double frame = now - loop->start;
+        loop->behind += frame;
+        loop->frames++;
+        loop->sum += frame;
+        loop->sumSquares += frame * frame;
+        if (frame < loop->shortest) loop->shortest = frame;
+        if (frame > loop->longest) loop->longest = frame;
+    }
+    loop->start = now;
+
+    // a whole step less a rounding error is still a step
+    double whole = floor(loop->behind / loop->step + 1e-9);
+    loop->behind -= whole * loop->step;
+    if (loop->behind < 0) loop->behind = 0;
+    // past maxUpdates the rest is dropped
+    int updates = whole > loop->maxUpdates ? loop->maxUpdates : (int)whole;
+    loop->updates += updates;
+    loop->alpha = loop->behind / loop->step;
+    return updates;
+}
+
+/*
+ * sleeps until the next frame is due, deadlines are period apart from the
+ * first frame so a frame that's a little late is made up by the next
+ */
+void endFrame(struct gameLoop_t *loop) {
+    if (loop->period <= 0) return;
+
+    loop->deadline += loop->period;
+    double now = loop->clock->now(loop->clock);
+    if (now > loop->deadline) {
+        loop->missed++;
+        if (now - loop->deadline > loop->period * LATE_FRAMES) loop->deadline = now;
+        return;
+    }
+    loop->clock->sleepUntil(loop->clock, loop->deadline);
+}
+
+void getLoopStats(struct gameLoop_t *loop, struct loopStats_t *stats) {
+    stats->frames = loop->frames;
+    stats->missed = loop->missed;
+    stats->mean = stats->jitter = stats->shortest = stats->longest = 0;
+    if (!loop->frames) return;
+
+    stats->mean = loop->sum / loop->frames;
+    double variance = loop->sumSquares / loop->frames - stats->mean * stats->mean;
+    stats->jitter = variance > 0 ? sqrt(variance) : 0;
+    stats->shortest = loop->shortest;
+    stats->longest = loop->longest;
+}
+
+void resetLoopStats(struct gameLoop_t *loop) {
+    loop->frames = loop->missed = 0;
+    loop->sum = loop->sumSquares = 0;
+    loop->shortest = 1e9;
+    loop->longest = 0;
+}
@@ -18,43 +18,73 @@ main code
 
 */
 
-int loadObj(struct obj_t *obj,const char *objFile, char *vert, char *frag)
+struct {    // blob of globals for picking a level of detail
+    float projScale;    // pixels per unit at a distance of 1, 0 = no lods
+    float tolerance;    // largest on screen error allowed, in pixels
+    int drawn, full;    // vertices drawn this frame with and without lods
+} __objLod = { 0, 2.0, 0, 0 };
+
+static void createLod(struct objLod_t *lod, int numVerts, float *verts,
+                      float *txVert, float *norms, int numIndices,
+                      unsigned short *indices)
 {
-    FILE *pFile;
-    pFile = fopen( objFile , "rb" );
-    if (pFile==NULL) {
-        printf("Cant find open model - %s\n",objFile);
-        return false;
-    }
-    unsigned int magic;
-    int NumVerts;
+    lod->num_verts = numVerts;
+    lod->num_indices = numIndices;
 
-    fread (&magic,1, sizeof(unsigned int), pFile );
-    if (magic!=0x614f4247) {
-        printf("Does not appear to be a version 'a' GBO file\n");
-        return false;
-    }
-    fread(&NumVerts,1,sizeof(unsigned int), pFile );
+    glGenBuffers(1, &lod->vbo_vert);
+    glBindBuffer(GL_ARRAY_BUFFER, lod->vbo_vert);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * numVerts, verts,
+                 GL_STATIC_DRAW);
 
-    float* Verts = malloc(sizeof(float) * 3 * NumVerts);
-    fread(Verts,1,sizeof(float) * 3 * NumVerts, pFile );
+    glGenBuffers(1, &lod->vbo_tex);
+    glBindBuffer(GL_ARRAY_BUFFER, lod->vbo_tex);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 2 * numVerts, txVert,
+                 GL_STATIC_DRAW);
 
-    float* Norms = malloc(sizeof(float) * 3 * NumVerts);
-    fread(Norms,1,sizeof(float) * 3 * NumVerts, pFile );
+    glGenBuffers(1, &lod->vbo_norm);
+    glBindBuffer(GL_ARRAY_BUFFER, lod->vbo_norm);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * numVerts, norms,
+                 GL_STATIC_DRAW);
 
-    float* TexCoords = malloc(sizeof(float) * 2 * NumVerts);
-    fread(TexCoords,1,sizeof(float) * 2 * NumVerts, pFile );
+    lod->ibo = 0;
+    if (numIndices) {
+        glGenBuffers(1, &lod->ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod->ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * numIndices,
+                     indices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
 
-    createObj(obj,NumVerts,Verts,TexCoords,Norms,vert,frag);
+/*
+ *  bounding sphere centred on the bounding box of the verts
+ */
+static void objBounds(struct obj_t *obj, int numVerts, float *verts)
+{
+    float mn[3] = { 0, 0, 0 }, mx[3] = { 0, 0, 0 }, r2 = 0;
 
-    free(TexCoords);
-    free(Norms);
-    free(Verts);
+    for (int i = 0; i < numVerts; i++) {
+        for (int c = 0; c < 3; c++) {
+            if (i == 0 || verts[i * 3 + c] < mn[c]) mn[c] = verts[i * 3 + c];
+            if (i == 0 || verts[i * 3 + c] > mx[c]) mx[c] = verts[i * 3 + c];
+        }
+    }
+    for (int c = 0; c < 3; c++) obj->centre[c] = (mn[c] + mx[c]) / 2;
 
-    return true;
+    for (int i = 0; i < numVerts; i++) {
+        float d = 0;
+        for (int c = 0; c < 3; c++)
+            d += (verts[i * 3 + c] - obj->centre[c]) * (verts[i * 3 + c] - obj->centre[c]);
+        if (d > r2) r2 = d;
+    }
+    obj->radius = sqrtf(r2);
 }
 
-int loadObjCopyShader(struct obj_t *obj,const char *objFile, struct obj_t *sdrobj)
+/*
+ *  reads a version 'a' (single triangle soup) or version 'b' (indexed
+ *  with levels of detail) GBO straight into GPU buffers
+ */
+static int loadGbo(struct obj_t *obj, const char *objFile)
 {
     FILE *pFile;
     pFile = fopen( objFile , "rb" );
@@ -63,92 +93,136 @@ int loadObjCopyShader(struct obj_t *obj,const char *objFile, struct obj_t *sdrob
         return false;
     }
     unsigned int magic;
-    int NumVerts;
 
     fread (&magic,1, sizeof(unsigned int), pFile );
-    if (magic!=0x614f4247) {
-        printf("Does not appear to be a version 'a' GBO file\n");
+    if (magic!=0x614f4247 && magic!=0x624f4247) {
+        printf("Does not appear to be a version 'a' or 'b' GBO file\n");
+        fclose(pFile);
         return false;
     }
-    fread(&NumVerts,1,sizeof(unsigned int), pFile );
 
-    float* Verts = malloc(sizeof(float) * 3 * NumVerts);
-    fread(Verts,1,sizeof(float) * 3 * NumVerts, pFile );
+    obj->num_lods = 1;
+    if (magic==0x624f4247) {
+        float bounds[4];
+        fread(&obj->num_lods,1,sizeof(unsigned int), pFile );
+        fread(bounds,4,sizeof(float), pFile );
+        if (obj->num_lods < 1 || obj->num_lods > OBJ_MAX_LODS) {
+            printf("%s has %i lods, up to %i are supported\n",objFile,
+                   obj->num_lods,OBJ_MAX_LODS);
+            fclose(pFile);
+            return false;
+        }
+        obj->centre[0] = bounds[0];
+        obj->centre[1] = bounds[1];
+        obj->centre[2] = bounds[2];
+        obj->radius = bounds[3];
+    }
+
+    for (int l = 0; l < obj->num_lods; l++) {
+        int NumVerts, NumIndices = 0;
+        float error = 0;
+
+        fread(&NumVerts,1,sizeof(unsigned int), pFile );
+        if (magic==0x624f4247) {
+            fread(&NumIndices,1,sizeof(unsigned int), pFile );
+            fread(&error,1,sizeof(float), pFile );
+        }
+
+        float* Verts = malloc(sizeof(float) * 3 * NumVerts);
+        fread(Verts,1,sizeof(float) * 3 * NumVerts, pFile );
 
-    float* Norms = malloc(sizeof(float) * 3 * NumVerts);
-    fread(Norms,1,sizeof(float) * 3 * NumVerts, pFile );
+        float* Norms = malloc(sizeof(float) * 3 * NumVerts);
+        fread(Norms,1,sizeof(float) * 3 * NumVerts, pFile );
 
-    float* TexCoords = malloc(sizeof(float) * 2 * NumVerts);
-    fread(TexCoords,1,sizeof(float) * 2 * NumVerts, pFile );
+        float* TexCoords = malloc(sizeof(float) * 2 * NumVerts);
+        fread(TexCoords,1,sizeof(float) * 2 * NumVerts, pFile );
 
-    createObjCopyShader(obj,NumVerts, Verts,TexCoords,
-                        Norms, sdrobj);
+        unsigned short* Indices = malloc(sizeof(unsigned short) * NumIndices);
+        fread(Indices,1,sizeof(unsigned short) * NumIndices, pFile );
 
-    free(TexCoords);
-    free(Norms);
-    free(Verts);
+        createLod(&obj->lod[l],NumVerts,Verts,TexCoords,Norms,NumIndices,Indices);
+        obj->lod[l].error = error;
 
+        if (magic==0x614f4247) objBounds(obj,NumVerts,Verts);
+
+        free(Indices);
+        free(TexCoords);
+        free(Norms);
+        free(Verts);
+    }
+
+    fclose(pFile);
     return true;
 }
 
-
-int createObj(struct obj_t *obj, int numVerts, float *verts, float *txVert,
-              float *norms, char *vertShader, char *fragShader)
+/*
+ *  the program comes from the shared registry so objs using the same
+ *  shaders only compile them once
+ */
+static int createObjShader(struct obj_t *obj, char *vertShader, char *fragShader)
 {
-    obj->num_verts = numVerts;
+    struct program_t *p = getProgram(vertShader, fragShader, NULL);
+    obj->shader = p;
+    if (!p)
+        return 0;
 
-    glGenBuffers(1, &obj->vbo_vert);
-    glBindBuffer(GL_ARRAY_BUFFER, obj->vbo_vert);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * numVerts, verts,
-                 GL_STATIC_DRAW);
+    obj->program = p->id;
+    obj->vert_attrib = programLocation(p, shaderAttrib, "vertex_attrib");
+    obj->tex_attrib = programLocation(p, shaderAttrib, "uv_attrib");
+    obj->norm_attrib = programLocation(p, shaderAttrib, "norm_attrib");
+    obj->mvp_uniform = programLocation(p, shaderUniform, "mvp_uniform");
+    obj->mv_uniform = programLocation(p, shaderUniform, "mv_uniform");
+    obj->tex_uniform = programLocation(p, shaderUniform, "u_texture");
+    obj->lightDir_uniform = programLocation(p, shaderUniform, "u_lightDir");
+    obj->viewDir_uniform = programLocation(p, shaderUniform, "u_viewDir");
+
+    return 1;
+}
 
-    glGenBuffers(1, &obj->vbo_tex);
-    glBindBuffer(GL_ARRAY_BUFFER, obj->vbo_tex);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 2 * numVerts, txVert,
-                 GL_STATIC_DRAW);
+static void copyObjShader(struct obj_t *obj, struct obj_t *sdrobj)
+{
+    obj->vert_attrib = sdrobj->vert_attrib;
+    obj->tex_attrib = sdrobj->tex_attrib;
+    obj->norm_attrib = sdrobj->norm_attrib;
+    obj->mvp_uniform = sdrobj->mvp_uniform;
+    obj->mv_uniform = sdrobj->mv_uniform;
+    obj->tex_uniform = sdrobj->tex_uniform;
+    obj->lightDir_uniform = sdrobj->lightDir_uniform;
+    obj->viewDir_uniform =  sdrobj->viewDir_uniform;
+    obj->program = sdrobj->program;
 
-    glGenBuffers(1, &obj->vbo_norm);
-    glBindBuffer(GL_ARRAY_BUFFER, obj->vbo_norm);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * numVerts, norms,
-                 GL_STATIC_DRAW);
+    // take another reference so either obj can be freed first
+    obj->shader = sdrobj->shader;
+    if (obj->shader) obj->shader->refs++;
+}
 
-    GLint link_ok = GL_FALSE;
+int loadObj(struct obj_t *obj,const char *objFile, char *vert, char *frag)
+{
+    if (!loadGbo(obj,objFile))
+        return false;
 
-    GLuint vs, fs;
-    if ((vs = create_shader(vertShader, GL_VERTEX_SHADER)) == 0)
-        return 0;
-    if ((fs = create_shader(fragShader, GL_FRAGMENT_SHADER)) == 0)
-        return 0;
+    return createObjShader(obj,vert,frag);
+}
 
-    obj->program = glCreateProgram();
-    glAttachShader(obj->program, vs);
-    glAttachShader(obj->program, fs);
-    glLinkProgram(obj->program);
-    glGetProgramiv(obj->program, GL_LINK_STATUS, &link_ok);
-    if (!link_ok) {
-        printf("glLinkProgram:");
-        print_log(obj->program);
-        return 0;
-    }
+int loadObjCopyShader(struct obj_t *obj,const char *objFile, struct obj_t *sdrobj)
+{
+    if (!loadGbo(obj,objFile))
+        return false;
+
+    copyObjShader(obj,sdrobj);
+    return true;
+}
 
-    obj->vert_attrib =
-        getShaderLocation(shaderAttrib, obj->program, "vertex_attrib");
-    obj->tex_attrib =
-        getShaderLocation(shaderAttrib, obj->program, "uv_attrib");
-    obj->norm_attrib =
-        getShaderLocation(shaderAttrib, obj->program, "norm_attrib");
-    obj->mvp_uniform =
-        getShaderLocation(shaderUniform, obj->program, "mvp_uniform");
-    obj->mv_uniform =
-        getShaderLocation(shaderUniform, obj->program, "mv_uniform");
-    obj->tex_uniform =
-        getShaderLocation(shaderUniform, obj->program, "u_texture");
-    obj->lightDir_uniform =
-        getShaderLocation(shaderUniform, obj->program, "u_lightDir");
-    obj->viewDir_uniform =
-        getShaderLocation(shaderUniform, obj->program, "u_viewDir");
 
+int createObj(struct obj_t *obj, int numVerts, float *verts, float *txVert,
+              float *norms, char *vertShader, char *fragShader)
+{
+    obj->num_lods = 1;
+    createLod(&obj->lod[0], numVerts, verts, txVert, norms, 0, NULL);
+    obj->lod[0].error = 0;
+    objBounds(obj, numVerts, verts);
 
+    return createObjShader(obj, vertShader, fragShader);
 }
 
 /*
@@ -157,36 +231,103 @@ int createObj(struct obj_t *obj, int numVerts, float *verts, float *txVert,
 int createObjCopyShader(struct obj_t *obj, int numVerts, float *verts,
                         float *txVert, float *norms, struct obj_t *sdrobj)
 {
-    obj->num_verts = numVerts;
-    glGenBuffers(1, &obj->vbo_vert);
-    glBindBuffer(GL_ARRAY_BUFFER, obj->vbo_vert);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * numVerts, verts,
-                 GL_STATIC_DRAW);
+    obj->num_lods = 1;
+    createLod(&obj->lod[0], numVerts, verts, txVert, norms, 0, NULL);
+    obj->lod[0].error = 0;
+    objBounds(obj, numVerts, verts);
 
-    glGenBuffers(1, &obj->vbo_tex);
-    glBindBuffer(GL_ARRAY_BUFFER, obj->vbo_tex);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 2 * numVerts, txVert,
-                 GL_STATIC_DRAW);
+    copyObjShader(obj, sdrobj);
+    return true;
+}
 
-    glGenBuffers(1, &obj->vbo_norm);
-    glBindBuffer(GL_ARRAY_BUFFER, obj->vbo_norm);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * numVerts, norms,
-                 GL_STATIC_DRAW);
+/*
+ *  releases the GPU buffers and this obj's hold on its shader program
+ */
+void freeObj(struct obj_t *obj)
+{
+    for (int l = 0; l < obj->num_lods; l++) {
+        struct objLod_t *lod = &obj->lod[l];
+        glDeleteBuffers(1, &lod->vbo_vert);
+        glDeleteBuffers(1, &lod->vbo_tex);
+        glDeleteBuffers(1, &lod->vbo_norm);
+        if (lod->ibo) glDeleteBuffers(1, &lod->ibo);
+    }
+    obj->num_lods = 0;
+    releaseProgram(obj->shader);
+    obj->shader = NULL;
+    obj->program = 0;
+}
 
-    obj->vert_attrib = sdrobj->vert_attrib;
-    obj->tex_attrib = sdrobj->tex_attrib;
-    obj->norm_attrib = sdrobj->norm_attrib;
-    obj->mvp_uniform = sdrobj->mvp_uniform;
-    obj->mv_uniform = sdrobj->mv_uniform;
-    obj->tex_uniform = sdrobj->tex_uniform;
-    obj->lightDir_uniform = sdrobj->lightDir_uniform;
-    obj->viewDir_uniform =  sdrobj->viewDir_uniform;
-    obj->program = sdrobj->program;
+/*
+ *  lods are picked from how big the bounding sphere is on screen, the
+ *  coarsest lod whose error would cover no more than the tolerance in
+ *  pixels is used
+ */
+void reProjectObjs(kmMat4 *projection, int h)
+{
+    __objLod.projScale = projection->mat[5] * h / 2;
+}
+
+void setObjLodTolerance(float pixels)
+{
+    __objLod.tolerance = pixels;
+}
+
+void resetObjStats()
+{
+    __objLod.drawn = __objLod.full = 0;
+}
 
+void getObjStats(int *drawn, int *full)
+{
+    *drawn = __objLod.drawn;
+    *full = __objLod.full;
+}
+
+static int pickLod(struct obj_t *obj, kmMat4 *mv)
+{
+    if (obj->num_lods < 2 || __objLod.projScale == 0 || obj->radius == 0)
+        return 0;
+
+    float *m = mv->mat, *c = obj->centre;
+
+    // the eye looks down -z so distance is -z of the centre in view space
+    float dist = -(m[2] * c[0] + m[6] * c[1] + m[10] * c[2] + m[14]);
+
+    // the model may be scaled, use the largest axis
+    float s = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+    float sy = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+    float sz = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+    if (sy > s) s = sy;
+    if (sz > s) s = sz;
+    float r = obj->radius * sqrtf(s);
+
+    if (dist <= r)
+        return 0;   // inside or right up against the bounds
+
+    float pixels = r * __objLod.projScale / dist;   // projected radius
+
+    int l = 0;
+    for (int i = 1; i < obj->num_lods; i++) {
+        if (obj->lod[i].error / obj->radius * pixels > __objLod.tolerance)
+            break;
+        l = i;
+    }
+    return l;
+}
+
+static int lodVerts(struct objLod_t *lod)
+{
+    return lod->ibo ? lod->num_indices : lod->num_verts;
 }
 
 void drawObj(struct obj_t *obj, kmMat4 * combined, kmMat4 * mv, kmVec3 lightDir, kmVec3 viewDir)
 {
+    struct objLod_t *lod = &obj->lod[pickLod(obj, mv)];
+
+    __objLod.full += lodVerts(&obj->lod[0]);
+    __objLod.drawn += lodVerts(lod);
+
     glUseProgram(obj->program);
 
     glUniformMatrix4fv(obj->mvp_uniform, 1, GL_FALSE, (GLfloat *) combined);
@@ -198,18 +339,24 @@ void drawObj(struct obj_t *obj, kmMat4 * combined, kmMat4 * mv, kmVec3 lightDir,
     glUniform3f(obj->lightDir_uniform,lightDir.x,lightDir.y,lightDir.z);
 
     glEnableVertexAttribArray(obj->vert_attrib);
-    glBindBuffer(GL_ARRAY_BUFFER, obj->vbo_vert);
+    glBindBuffer(GL_ARRAY_BUFFER, lod->vbo_vert);
     glVertexAttribPointer(obj->vert_attrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
     glEnableVertexAttribArray(obj->norm_attrib);
-    glBindBuffer(GL_ARRAY_BUFFER, obj->vbo_norm);
+    glBindBuffer(GL_ARRAY_BUFFER, lod->vbo_norm);
     glVertexAttribPointer(obj->norm_attrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
     glEnableVertexAttribArray(obj->tex_attrib);
-    glBindBuffer(GL_ARRAY_BUFFER, obj->vbo_tex);
+    glBindBuffer(GL_ARRAY_BUFFER, lod->vbo_tex);
     glVertexAttribPointer(obj->tex_attrib, 2, GL_FLOAT, GL_FALSE, 0, 0);
 
-    glDrawArrays(GL_TRIANGLES, 0, obj->num_verts);
+    if (lod->ibo) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod->ibo);
+        glDrawElements(GL_TRIANGLES, lod->num_indices, GL_UNSIGNED_SHORT, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, lod->num_verts);
+    }
 
     glDisableVertexAttribArray(obj->tex_attrib);
     glDisableVertexAttribArray(obj->vert_attrib);
@@ -0,0 +1,265 @@
+#include <kazmath.h>
+#include <stdlib.h>
+#include <string.h>
+#include "support.h"
+#include "particles.h"
+
+#define MAX_PARTICLE_THREADS 16
+
+// below this many particles threads cost more than they save
+#define PARTICLES_PER_THREAD 4096
+
+/*
+ * worker threads wait for generation to change then each updates its
+ * chunk, the thread calling updateParticles does chunk 0
+ */
+struct particleWorker_t {
+    struct particleThreads_t *pool;
+    int chunk;
+};
+
+struct particleThreads_t {
+    int workers;
+    thrd_t thread[MAX_PARTICLE_THREADS];
+    struct particleWorker_t worker[MAX_PARTICLE_THREADS];
+    mtx_t lock;
+    cnd_t start, done;
+    int generation, pending, quit;
+
+    // this update's work, first, size and (once done) live count of each chunk
+    struct particles_t *p;
+    float dt;
+    int first[MAX_PARTICLE_THREADS], size[MAX_PARTICLE_THREADS], live[MAX_PARTICLE_THREADS];
+};
+
+static float* streamArray(int capacity)
+{
+    return malloc(sizeof(float) * capacity);
+}
+
+struct particles_t* createParticles(int capacity) {
+    struct particles_t* p = calloc(1, sizeof(struct particles_t));
+    p->capacity = capacity;
+    kmVec3StreamFill(&p->pos, streamArray(capacity), streamArray(capacity), streamArray(capacity));
+    kmVec3StreamFill(&p->vel, streamArray(capacity), streamArray(capacity), streamArray(capacity));
+    p->age = streamArray(capacity);
+    p->life = streamArray(capacity);
+    p->cloud = createPointCloudAttribs(capacity);
+    p->size = p->cloud->size;
+    p->color = p->cloud->color;
+    return p;
+}
+
+// the cloud's copy of a position, what gets uploaded
+static void stagePosition(struct particles_t* p, int i) {
+    float* pos = p->cloud->pos;
+    pos[i * 3] = p->pos.x[i];
+    pos[i * 3 + 1] = p->pos.y[i];
+    pos[i * 3 + 2] = p->pos.z[i];
+}
+
+static void copyParticle(struct particles_t* p, int to, int from) {
+    p->pos.x[to] = p->pos.x[from];
+    p->pos.y[to] = p->pos.y[from];
+    p->pos.z[to] = p->pos.z[from];
+    p->vel.x[to] = p->vel.x[from];
+    p->vel.y[to] = p->vel.y[from];
+    p->vel.z[to] = p->vel.z[from];
+    p->age[to] = p->age[from];
+    p->life[to] = p->life[from];
+    p->size[to] = p->size[from];
+    memcpy(&p->color[to * 4], &p->color[from * 4], 4);
+    stagePosition(p, to);
+}
+
+/*
+ * adds the particles the emitter owes for dt seconds (as many as there's
+ * room for), returns how many were added
+ */
+int emitParticles(struct particles_t* p, struct particleEmitter_t* e, float dt) {
+    e->owed += e->rate * dt;
+    int n = (int)e->owed;
+    e->owed -= n;
+    if (n > p->capacity - p->count) n = p->capacity - p->count;
+
+    for (int k = 0; k < n; k++) {
+        int i = p->count++;
+        p->pos.x[i] = e->pos.x;
+        p->pos.y[i] = e->pos.y;
+        p->pos.z[i] = e->pos.z;
+        p->vel.x[i] = e->vel.x + rand_range(-e->spread, 2 * e->spread);
+        p->vel.y[i] = e->vel.y + rand_range(-e->spread, 2 * e->spread);
+        p->vel.z[i] = e->vel.z + rand_range(-e->spread, 2 * e->spread);
+        p->age[i] = 0;
+        p->life[i] = e->life;
+        p->size[i] = e->size;
+        memcpy(&p->color[i * 4], e->color, 4);
+        stagePosition(p, i);
+    }
+    return n;
+}
+
+/*
+ * velocity = velocity * (1 - drag * dt) + gravity * dt, then
+ * position += velocity * dt for the n particles from first, the ones past
+ * their life are replaced by the last of the chunk, returns how many are
+ * left (still starting at first)
+ */
+static int updateChunk(struct particles_t* p, float dt, int first, int n) {
+    kmVec3Stream pos, vel;
+    kmVec3 g;
+    kmVec3StreamFill(&pos, p->pos.x + first, p->pos.y + first, p->pos.z + first);
+    kmVec3StreamFill(&vel, p->vel.x + first, p->vel.y + first, p->vel.z + first);
+    kmVec3Scale(&g, &p->gravity, dt);
+    kmVec3StreamScaleAdd(&vel, &vel, 1 - p->drag * dt, &g, n);
+    kmVec3StreamAddScaled(&pos, &pos, &vel, dt, n);
+
+    // a dead particle is replaced by the last, which is then checked
+    int end = first + n;
+    for (int i = first; i < end;) {
+        p->age[i] += dt;
+        if (p->age[i] < p->life[i]) {
+            stagePosition(p, i++);
+        } else {
+            copyParticle(p, i, --end);
+        }
+    }
+    return end - first;
+}
+
+static int particleWorker(void *arg) {
+    struct particleWorker_t *w = arg;
+    struct particleThreads_t *t = w->pool;
+    int seen = 0;
+
+    mtx_lock(&t->lock);
+    for (;;) {
+        while (t->generation == seen && !t->quit) cnd_wait(&t->start, &t->lock);
+        if (t->quit) break;
+        seen = t->generation;
+        mtx_unlock(&t->lock);
+
+        int c = w->chunk;
+        t->live[c] = updateChunk(t->p, t->dt, t->first[c], t->size[c]);
+
+        mtx_lock(&t->lock);
+        if (--t->pending == 0) cnd_signal(&t->done);
+    }
+    mtx_unlock(&t->lock);
+    return 0;
+}
+
+static void stopParticleThreads(struct particleThreads_t *t) {
+    mtx_lock(&t->lock);
+    t->quit = 1;
+    cnd_broadcast(&t->start);
+    mtx_unlock(&t->lock);
+    for (int i = 0; i < t->workers; i++) thrd_join(t->thread[i], NULL);
+    cnd_destroy(&t->start);
+    cnd_destroy(&t->done);
+    mtx_destroy(&t->lock);
+    free(t);
+}
+
+/*
+ * how many threads (including the one calling updateParticles) to update
+ * with, 1 for none
+ */
+void setParticleThreads(struct particles_t* p, int threads) {
+    if (p->threads) stopParticleThreads(p->threads);
+    p->threads = NULL;
+    if (threads > MAX_PARTICLE_THREADS) threads = MAX_PARTICLE_THREADS;
+    if (threads < 2) return;
+
+    struct particleThreads_t *t = calloc(1, sizeof(struct particleThreads_t));
+    mtx_init(&t->lock, mtx_plain);
+    cnd_init(&t->start);
+    cnd_init(&t->done);
+    for (int i = 0; i < threads - 1; i++) {
+        t->worker[i].pool = t;
+        t->worker[i].chunk = i + 1;
+        if (thrd_create(&t->thread[i], particleWorker, &t->worker[i]) != thrd_success) break;
+        t->workers++;
+    }
+    p->threads = t;
+}
+
+/*
+ * after the chunks have removed their own dead there are holes where each
+ * chunk's live particles end, the ones beyond the new count are moved into
+ * the holes before it
+ */
+static void fillHoles(struct particles_t* p, struct particleThreads_t *t, int chunks) {
+    int count = 0;
+    for (int c = 0; c < chunks; c++) count += t->live[c];
+
+    int from = chunks - 1, last = t->first[from] + t->live[from] - 1;
+    for (int c = 0; c < chunks; c++) {
+        int end = t->first[c] + t->size[c];
+        if (end > count) end = count;
+        for (int hole = t->first[c] + t->live[c]; hole < end; hole++) {
+            while (last < t->first[from]) {
+                from--;
+                last = t->first[from] + t->live[from] - 1;
+            }
+            copyParticle(p, hole, last--);
+        }
+    }
+    p->count = count;
+}
+
+/*
+ * moves every particle and removes the ones past their life, the cloud's
+ * positions are ready to draw afterwards
+ */
+void updateParticles(struct particles_t* p, float dt) {
+    struct particleThreads_t *t = p->threads;
+    int chunks = t ? t->workers + 1 : 1;
+    if (p->count < chunks * PARTICLES_PER_THREAD) chunks = 1;
+    if (chunks == 1) {
+        p->count = updateChunk(p, dt, 0, p->count);
+        return;
+    }
+
+    // multiples of 4 so only the last chunk has a scalar remainder
+    int size = (p->count / chunks + 3) & ~3;
+    for (int c = 0; c < chunks; c++) {
+        t->first[c] = c * size;
+        t->size[c] = c == chunks - 1 ? p->count - c * size : size;
+    }
+
+    mtx_lock(&t->lock);
+    t->p = p;
+    t->dt = dt;
+    t->pending = t->workers;
+    t->generation++;
+    cnd_broadcast(&t->start);
+    mtx_unlock(&t->lock);
+
+    t->live[0] = updateChunk(p, dt, t->first[0], t->size[0]);
+
+    mtx_lock(&t->lock);
+    while (t->pending) cnd_wait(&t->done, &t->lock);
+    mtx_unlock(&t->lock);
+
+    fillHoles(p, t, chunks);
+}
+
+void drawParticles(struct particles_t* p, kmMat4* mvp) {
+    p->cloud->totalPoints = p->count;
+    if (p->count) drawPointCloud(p->cloud, mvp);
+}
+
+void freeParticles(struct particles_t* p) {
+    if (p->threads) stopParticleThreads(p->threads);
+    free(p->pos.x);
+    free(p->pos.y);
+    free(p->pos.z);
+    free(p->vel.x);
+    free(p->vel.y);
+    free(p->vel.z);
+    free(p->age);
+    free(p->life);
+    freePointCloud(p->cloud);
+    free(p);
+}
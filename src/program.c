@@ -0,0 +1,177 @@
+#include  <GLES2/gl2.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "support.h"
+
+struct {    // blob of globals for the program registry
+    struct program_t **progs;
+    int count, capacity;
+    int compiled;   // programs compiled and linked since startup
+} __programs;
+
+static char *copyString(const char *s)
+{
+    char *r = malloc(strlen(s) + 1);
+    strcpy(r, s);
+    return r;
+}
+
+static void addLocation(struct program_t *prog, int type, GLint location, char *name)
+{
+    // uniform arrays are reported as name[0], they're looked up as name
+    char *bracket = strchr(name, '[');
+    if (bracket) *bracket = 0;
+
+    struct programLocation_t *l = &prog->locations[prog->numLocations++];
+    l->type = type;
+    l->location = location;
+    l->name = copyString(name);
+}
+
+/*
+ * resolves every active attribute and uniform once when the program is
+ * linked so looking them up later doesn't need to ask GL
+ */
+static void findLocations(struct program_t *prog)
+{
+    GLint attribs, uniforms, attribLen, uniformLen, size;
+    GLenum type;
+
+    glGetProgramiv(prog->id, GL_ACTIVE_ATTRIBUTES, &attribs);
+    glGetProgramiv(prog->id, GL_ACTIVE_UNIFORMS, &uniforms);
+    glGetProgramiv(prog->id, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &attribLen);
+    glGetProgramiv(prog->id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &uniformLen);
+
+    char *name = malloc((attribLen > uniformLen ? attribLen : uniformLen) + 1);
+    prog->locations = malloc(sizeof(struct programLocation_t) * (attribs + uniforms + 1));
+    prog->numLocations = 0;
+
+    for (int i = 0; i < attribs; i++) {
+        glGetActiveAttrib(prog->id, i, attribLen + 1, NULL, &size, &type, name);
+        addLocation(prog, shaderAttrib, glGetAttribLocation(prog->id, name), name);
+    }
+    for (int i = 0; i < uniforms; i++) {
+        glGetActiveUniform(prog->id, i, uniformLen + 1, NULL, &size, &type, name);
+        addLocation(prog, shaderUniform, glGetUniformLocation(prog->id, name), name);
+    }
+    free(name);
+}
+
+static GLuint linkProgram(const char *vert, const char *frag, const char *defines)
+{
+    GLint link_ok = GL_FALSE;
+    GLuint vs, fs, id;
+
+    if ((vs = create_shader_defines(vert, GL_VERTEX_SHADER, defines)) == 0)
+        return 0;
+    if ((fs = create_shader_defines(frag, GL_FRAGMENT_SHADER, defines)) == 0) {
+        glDeleteShader(vs);
+        return 0;
+    }
+
+    id = glCreateProgram();
+    glAttachShader(id, vs);
+    glAttachShader(id, fs);
+    glLinkProgram(id);
+
+    // the linked program doesn't need the shader objects any more
+    glDetachShader(id, vs);
+    glDetachShader(id, fs);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    glGetProgramiv(id, GL_LINK_STATUS, &link_ok);
+    if (!link_ok) {
+        printf("glLinkProgram %s %s:", vert, frag);
+        print_log(id);
+        printf("\n");
+        glDeleteProgram(id);
+        return 0;
+    }
+    return id;
+}
+
+/*
+ * returns a shared program for this pair of shaders and defines (which
+ * can be NULL), only compiling it the first time, NULL if it won't build
+ *
+ * each get should be matched by a releaseProgram
+ */
+struct program_t* getProgram(const char *vert, const char *frag, const char *defines)
+{
+    if (!defines) defines = "";
+
+    for (int i = 0; i < __programs.count; i++) {
+        struct program_t *p = __programs.progs[i];
+        if (!strcmp(p->vert, vert) && !strcmp(p->frag, frag) &&
+                !strcmp(p->defines, defines)) {
+            p->refs++;
+            return p;
+        }
+    }
+
+    GLuint id = linkProgram(vert, frag, defines);
+    if (!id) return NULL;
+    __programs.compiled++;
+
+    struct program_t *p = malloc(sizeof(struct program_t));
+    p->id = id;
+    p->refs = 1;
+    p->vert = copyString(vert);
+    p->frag = copyString(frag);
+    p->defines = copyString(defines);
+    findLocations(p);
+
+    if (__programs.count == __programs.capacity) {
+        __programs.capacity = __programs.capacity ? __programs.capacity * 2 : 8;
+        __programs.progs = realloc(__programs.progs,
+                                   sizeof(struct program_t*) * __programs.capacity);
+    }
+    __programs.progs[__programs.count++] = p;
+    return p;
+}
+
+/*
+ * attribute or uniform location from the ones found at link time
+ */
+GLint programLocation(struct program_t* prog, int type, const char *name)
+{
+    for (int i = 0; i < prog->numLocations; i++) {
+        struct programLocation_t *l = &prog->locations[i];
+        if (l->type == type && !strcmp(l->name, name))
+            return l->location;
+    }
+    printf("Cound not bind shader location %s\n", name);
+    return -1;
+}
+
+/*
+ * the program is deleted when its last user releases it
+ */
+void releaseProgram(struct program_t* prog)
+{
+    if (!prog || --prog->refs > 0) return;
+
+    for (int i = 0; i < __programs.count; i++) {
+        if (__programs.progs[i] == prog) {
+            __programs.progs[i] = __programs.progs[--__programs.count];
+            break;
+        }
+    }
+
+    glDeleteProgram(prog->id);
+    for (int i = 0; i < prog->numLocations; i++)
+        free(prog->locations[i].name);
+    free(prog->locations);
+    free(prog->vert);
+    free(prog->frag);
+    free(prog->defines);
+    free(prog);
+}
+
+void getProgramStats(int *compiled, int *loaded)
+{
+    *compiled = __programs.compiled;
+    *loaded = __programs.count;
+}
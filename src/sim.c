@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include "tinycthread.h"
+#include "loop.h"
+#include "sim.h"
+
+// set in middle when its buffer has been published and not yet read
+#define FRESH 4
+
+void initTripleBuffer(struct tripleBuffer_t *tb, size_t size) {
+    for (int i = 0; i < 3; i++) tb->buffer[i] = calloc(1, size);
+    tb->writing = 0;
+    atomic_init(&tb->middle, 1);
+    tb->reading = 2;
+    tb->got = 0;
+}
+
+void* writingBuffer(struct tripleBuffer_t *tb) {
+    return tb->buffer[tb->writing];
+}
+
+void publishBuffer(struct tripleBuffer_t *tb) {
+    // release so the reader sees what was written, acquire so the reader
+    // has finished with the buffer we get back before we write to it
+    int old = atomic_exchange_explicit(&tb->middle, tb->writing | FRESH, memory_order_acq_rel);
+    tb->writing = old & ~FRESH;
+}
+
+// the newest published buffer, NULL until there's been one
+void* latestBuffer(struct tripleBuffer_t *tb) {
+    if (atomic_load_explicit(&tb->middle, memory_order_relaxed) & FRESH) {
+        int old = atomic_exchange_explicit(&tb->middle, tb->reading, memory_order_acq_rel);
+        tb->reading = old & ~FRESH;
+        tb->got = 1;
+    }
+    return tb->got ? tb->buffer[tb->reading] : NULL;
+}
+
+void freeTripleBuffer(struct tripleBuffer_t *tb) {
+    for (int i = 0; i < 3; i++) free(tb->buffer[i]);
+}
+
+// each snapshot starts with when it was published, then func's part
+struct snapshotHeader_t {
+    double published;
+};
+#define SNAPSHOT_OFFSET ((sizeof(struct snapshotHeader_t) + 15) & ~15)
+
+struct simThread_t {
+    struct gameLoop_t loop;
+    struct tripleBuffer_t snapshots;
+    simFunc_t func;
+    void *data;
+    thrd_t thread;
+    atomic_long steps;
+    atomic_int quit;
+};
+
+static int simThread(void *arg) {
+    struct simThread_t *sim = arg;
+    struct gameLoop_t *loop = &sim->loop;
+
+    while (!atomic_load_explicit(&sim->quit, memory_order_relaxed)) {
+        for (int n = startFrame(loop); n > 0; n--) {
+            char *snapshot = writingBuffer(&sim->snapshots);
+            sim->func(sim->data, snapshot + SNAPSHOT_OFFSET, loop->step);
+            ((struct snapshotHeader_t *)snapshot)->published = loop->clock->now(loop->clock);
+            publishBuffer(&sim->snapshots);
+            atomic_fetch_add_explicit(&sim->steps, 1, memory_order_relaxed);
+        }
+        endFrame(loop);
+    }
+    return 0;
+}
+
+struct simThread_t* startSimThread(double step, size_t size, simFunc_t func, void *data) {
+    struct simThread_t *sim = malloc(sizeof(struct simThread_t));
+    initGameLoop(&sim->loop, step, step);
+    initTripleBuffer(&sim->snapshots, SNAPSHOT_OFFSET + size);
+    sim->func = func;
+    sim->data = data;
+    atomic_init(&sim->steps, 0);
+    atomic_init(&sim->quit, 0);
+    if (thrd_create(&sim->thread, simThread, sim) != thrd_success) {
+        freeTripleBuffer(&sim->snapshots);
+        free(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+/*
+ * the newest snapshot, NULL before the first step, it stays valid (and
+ * unchanged) until the next call. age is set to how many seconds ago it
+ * was published, eg for extrapolating
+ */
+const void* latestSnapshot(struct simThread_t *sim, double *age) {
+    char *snapshot = latestBuffer(&sim->snapshots);
+    if (!snapshot) return NULL;
+    if (age) {
+        struct loopClock_t *clock = sim->loop.clock;
+        *age = clock->now(clock) - ((struct snapshotHeader_t *)snapshot)->published;
+    }
+    return snapshot + SNAPSHOT_OFFSET;
+}
+
+long simSteps(struct simThread_t *sim) {
+    return atomic_load_explicit(&sim->steps, memory_order_relaxed);
+}
+
+// returns once the thread has finished, which can take up to a step
+void stopSimThread(struct simThread_t *sim) {
+    atomic_store(&sim->quit, 1);
+    thrd_join(sim->thread, NULL);
+    freeTripleBuffer(&sim->snapshots);
+    free(sim);
+}
@@ -1,6 +1,7 @@
 #include "support.h"
 
 #include "lodepng.h"
+#include <string.h>
 
 
 float rand_range(float start,float range) {
@@ -176,6 +177,15 @@ void print_log(GLuint object)
  * Compile the shader from file 'filename', with error handling
  */
 GLuint create_shader(const char *filename, GLenum type)
+{
+    return create_shader_defines(filename, type, NULL);
+}
+
+/**
+ * As create_shader but with extra source (usually #define lines) placed
+ * before the shader's own source, NULL for none
+ */
+GLuint create_shader_defines(const char *filename, GLenum type, const char *defines)
 {
     const GLchar *source = file_read(filename);
     if (source == NULL) {
@@ -208,9 +218,10 @@ GLuint create_shader(const char *filename, GLenum type)
         "#define lowp   \n" "#define mediump\n" "#define highp  \n"
 #endif
         ,
+        defines ? defines : "",
         source
     };
-    glShaderSource(res, 3, sources, NULL);
+    glShaderSource(res, 4, sources, NULL);
     free((void *)source);
 
     glCompileShader(res);
@@ -233,6 +244,7 @@ struct {  // blob of globals for the glPrint routine
     GLuint fonttex, texture_uniform, cx_uniform, cy_uniform;
     GLuint vert_attrib, uv_attrib;
     GLuint quadvbo, texvbo;
+    struct program_t *shader;
 } __glp;
 
 void initGlPrint(int w, int h)
@@ -240,31 +252,21 @@ void initGlPrint(int w, int h)
 
 	reProjectGlPrint(w,h);
     
-    GLuint vs, fs;
-    vs = create_shader("resources/shaders/glprint.vert", GL_VERTEX_SHADER);
-    fs = create_shader("resources/shaders/glprint.frag", GL_FRAGMENT_SHADER);
-
-    __glp.printProg = glCreateProgram();
-    glAttachShader(__glp.printProg, vs);
-    glAttachShader(__glp.printProg, fs);
-    glLinkProgram(__glp.printProg);
-    int link_ok;
-    glGetProgramiv(__glp.printProg, GL_LINK_STATUS, &link_ok);
-    if (!link_ok) {
-        printf("glLinkProgram:");
-        print_log(__glp.printProg);
-        printf("\n");
-    }
-
-    __glp.cx_uniform = getShaderLocation(shaderUniform, __glp.printProg, "cx");
-    __glp.cy_uniform = getShaderLocation(shaderUniform, __glp.printProg, "cy");
-    __glp.opm_uniform =
-        getShaderLocation(shaderUniform, __glp.printProg, "opm_uniform");
-    __glp.texture_uniform =
-        getShaderLocation(shaderUniform, __glp.printProg, "texture_uniform");
-
-    __glp.vert_attrib = getShaderLocation(shaderAttrib, __glp.printProg, "vert_attrib");
-    __glp.uv_attrib = getShaderLocation(shaderAttrib, __glp.printProg, "uv_attrib");
+    // if called again (say on resize) the same program is handed back
+    struct program_t *p = getProgram("resources/shaders/glprint.vert",
+                                     "resources/shaders/glprint.frag", NULL);
+    releaseProgram(__glp.shader);
+    __glp.shader = p;
+    if (!p) return;
+
+    __glp.printProg = p->id;
+    __glp.cx_uniform = programLocation(p, shaderUniform, "cx");
+    __glp.cy_uniform = programLocation(p, shaderUniform, "cy");
+    __glp.opm_uniform = programLocation(p, shaderUniform, "opm_uniform");
+    __glp.texture_uniform = programLocation(p, shaderUniform, "texture_uniform");
+
+    __glp.vert_attrib = programLocation(p, shaderAttrib, "vert_attrib");
+    __glp.uv_attrib = programLocation(p, shaderAttrib, "uv_attrib");
 
 }
 
@@ -369,6 +371,7 @@ struct {  // blob of globals for the sprite routine
     GLuint texture_uniform, cx_uniform, cy_uniform, u_size;
     GLuint vert_attrib, uv_attrib;
     GLuint quadvbo, texvbo;
+    struct program_t *shader;
 } __spr;
 
 
@@ -397,30 +400,19 @@ void initSprite(int w, int h)
 
 	reProjectSprites(w,h);
 
-    GLuint vs, fs;
-    vs = create_shader("resources/shaders/sprite.vert", GL_VERTEX_SHADER);
-    fs = create_shader("resources/shaders/sprite.frag", GL_FRAGMENT_SHADER);
-
-    __spr.spriteProg = glCreateProgram();
-    glAttachShader(__spr.spriteProg, vs);
-    glAttachShader(__spr.spriteProg, fs);
-    glLinkProgram(__spr.spriteProg);
-    int link_ok;
-    glGetProgramiv(__spr.spriteProg, GL_LINK_STATUS, &link_ok);
-    if (!link_ok) {
-        printf("glLinkProgram:");
-        print_log(__spr.spriteProg);
-        printf("\n");
-    }
+    struct program_t *p = getProgram("resources/shaders/sprite.vert",
+                                     "resources/shaders/sprite.frag", NULL);
+    releaseProgram(__spr.shader);
+    __spr.shader = p;
+    if (!p) return;
 
-    __spr.u_size = getShaderLocation(shaderUniform, __spr.spriteProg, "u_size");
-    __spr.opm_uniform =
-        getShaderLocation(shaderUniform, __spr.spriteProg, "opm_uniform");
-    __spr.texture_uniform =
-        getShaderLocation(shaderUniform, __spr.spriteProg, "texture_uniform");
+    __spr.spriteProg = p->id;
+    __spr.u_size = programLocation(p, shaderUniform, "u_size");
+    __spr.opm_uniform = programLocation(p, shaderUniform, "opm_uniform");
+    __spr.texture_uniform = programLocation(p, shaderUniform, "texture_uniform");
 
-    __spr.vert_attrib = getShaderLocation(shaderAttrib, __spr.spriteProg, "vert_attrib");
-    __spr.uv_attrib = getShaderLocation(shaderAttrib, __spr.spriteProg, "uv_attrib");
+    __spr.vert_attrib = programLocation(p, shaderAttrib, "vert_attrib");
+    __spr.uv_attrib = programLocation(p, shaderAttrib, "uv_attrib");
 
 
     glGenBuffers(1, &__spr.quadvbo);
@@ -484,9 +476,25 @@ void drawSprite(float x, float y, float w, float h, float a, int tex)
 struct __pointGlobs {
     int Partprogram,part_mvp_uniform,part_tex_attrib;
     int part_tex_uniform,part_vert_attrib;
-    int part_size_uniform;
+    int part_size_uniform,part_atten_uniform,part_range_uniform;
+    struct program_t *shader;
+    // the same shaders with BALLISTIC defined, for ballistic clouds
+    int ballProgram,ball_mvp_uniform,ball_tex_uniform,ball_size_uniform;
+    int ball_vert_attrib,ball_vel_attrib,ball_spawn_attrib;
+    int ball_time_uniform,ball_gravity_uniform,ball_drag_uniform;
+    int ball_atten_uniform,ball_range_uniform;
+    struct program_t *ballShader;
+    // and with POINT_ATTRIBS, for clouds with a size and colour per point
+    int attrProgram,attr_mvp_uniform,attr_tex_uniform;
+    int attr_vert_attrib,attr_size_attrib,attr_color_attrib;
+    int attr_atten_uniform,attr_range_uniform;
+    struct program_t *attrShader;
+    float pointSize;    // resizePointCloudSprites
 } __pg;
 
+// bigger than any point size a GPU will draw
+#define UNLIMITED_POINT_SIZE 1e6
+
 // My intel i5 (intel HD4000) seems to be missing this - who to report to
 // messa?, kernel driver team?
 // this value however does work!!!
@@ -494,31 +502,226 @@ struct __pointGlobs {
 #define GL_PROGRAM_POINT_SIZE 0x8642
 #endif
 
-void drawPointCloud(struct pointCloud_t* pntC, kmMat4* mat) {
+// position, velocity and spawn time of each point of a ballistic cloud
+#define BALLISTIC_STRIDE (sizeof(float)*7)
+
+/*
+ * a sorted cloud's points are copied in back to front order before they're
+ * uploaded, GLES2 indices are only 16 bit so an index buffer would limit
+ * clouds to 65536 points
+ */
+struct pointCloudSort_t {
+    unsigned int *key[2], *order[2];    // radix sort passes go back and forth
+    float *pos, *size;
+    unsigned char *color;
+};
+
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+// the size uniforms of whichever particle program is in use
+static void setPointSprite(int sizeU, int attenU, int rangeU, struct pointSprite_t* sprite) {
+    glUniform1f(sizeU, sprite->size > 0 ? sprite->size : __pg.pointSize);
+    glUniform1f(attenU, sprite->attenuation);
+    glUniform2f(rangeU, sprite->minSize,
+                sprite->maxSize > 0 ? sprite->maxSize : UNLIMITED_POINT_SIZE);
+}
+
+// replaces the first totalPoints of a buffer the way the cloud is set to
+static void uploadPoints(struct pointCloud_t* pntC, int buf, int perPoint, const void* data) {
+    glBindBuffer(GL_ARRAY_BUFFER, buf);
+    if (pntC->upload == pointCloudOrphan)
+        glBufferData(GL_ARRAY_BUFFER, perPoint * pntC->maxPoints, NULL, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, perPoint * pntC->totalPoints, data);
+}
 
-    glUseProgram(__pg.Partprogram);
-    glUniformMatrix4fv(__pg.part_mvp_uniform, 1, GL_FALSE, (GLfloat *) mat);
-    glUniform1i(__pg.part_tex_uniform, 0);
+static void drawPointCloudAttribs(struct pointCloud_t* pntC, kmMat4* mat,
+                                  float* pos, float* size, unsigned char* color) {
+
+    glUseProgram(__pg.attrProgram);
+    glUniformMatrix4fv(__pg.attr_mvp_uniform, 1, GL_FALSE, (GLfloat *) mat);
+    glUniform1i(__pg.attr_tex_uniform, 0);
+    setPointSprite(-1, __pg.attr_atten_uniform, __pg.attr_range_uniform, &pntC->sprite);
+
+    uploadPoints(pntC, pntC->vertBuf, sizeof(float)*3, pos);
+    glEnableVertexAttribArray(__pg.attr_vert_attrib);
+    glVertexAttribPointer(__pg.attr_vert_attrib,3,GL_FLOAT,GL_FALSE,0,0);
+    uploadPoints(pntC, pntC->sizeBuf, sizeof(float), size);
+    glEnableVertexAttribArray(__pg.attr_size_attrib);
+    glVertexAttribPointer(__pg.attr_size_attrib,1,GL_FLOAT,GL_FALSE,0,0);
+    uploadPoints(pntC, pntC->colorBuf, 4, color);
+    glEnableVertexAttribArray(__pg.attr_color_attrib);
+    glVertexAttribPointer(__pg.attr_color_attrib,4,GL_UNSIGNED_BYTE,GL_TRUE,0,0);
+    glDrawArrays(GL_POINTS,0,pntC->totalPoints);
+    glDisableVertexAttribArray(__pg.attr_vert_attrib);
+    glDisableVertexAttribArray(__pg.attr_size_attrib);
+    glDisableVertexAttribArray(__pg.attr_color_attrib);
+}
+
+// sets up drawing from a buffer of ballistic points, glDrawArrays ranges of it after
+static void beginBallistic(int vertBuf, kmMat4* mat, float tick, kmVec3* gravity, float drag,
+                           struct pointSprite_t* sprite) {
+
+    glUseProgram(__pg.ballProgram);
+    glUniformMatrix4fv(__pg.ball_mvp_uniform, 1, GL_FALSE, (GLfloat *) mat);
+    glUniform1i(__pg.ball_tex_uniform, 0);
+    setPointSprite(__pg.ball_size_uniform, __pg.ball_atten_uniform, __pg.ball_range_uniform, sprite);
+    glUniform1f(__pg.ball_time_uniform, tick);
+    glUniform3f(__pg.ball_gravity_uniform, gravity->x, gravity->y, gravity->z);
+    glUniform1f(__pg.ball_drag_uniform, drag);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertBuf);
+    glEnableVertexAttribArray(__pg.ball_vert_attrib);
+    glVertexAttribPointer(__pg.ball_vert_attrib,3,GL_FLOAT,GL_FALSE,BALLISTIC_STRIDE,0);
+    glEnableVertexAttribArray(__pg.ball_vel_attrib);
+    glVertexAttribPointer(__pg.ball_vel_attrib,3,GL_FLOAT,GL_FALSE,BALLISTIC_STRIDE,
+                          (void*)(sizeof(float)*3));
+    glEnableVertexAttribArray(__pg.ball_spawn_attrib);
+    glVertexAttribPointer(__pg.ball_spawn_attrib,1,GL_FLOAT,GL_FALSE,BALLISTIC_STRIDE,
+                          (void*)(sizeof(float)*6));
+}
+
+static void endBallistic() {
+    glDisableVertexAttribArray(__pg.ball_vert_attrib);
+    glDisableVertexAttribArray(__pg.ball_vel_attrib);
+    glDisableVertexAttribArray(__pg.ball_spawn_attrib);
+}
+
+static void drawBallisticPointCloud(struct pointCloud_t* pntC, kmMat4* mat) {
+
+    beginBallistic(pntC->vertBuf, mat, pntC->tick, &pntC->gravity, pntC->drag, &pntC->sprite);
+    glDrawArrays(GL_POINTS,pntC->first,pntC->totalPoints);
+    endBallistic();
+}
+
+/**
+ * Orders the points of a cloud furthest first as seen through m (the same
+ * matrix drawPointCloud is given), returns the index of each point in
+ * drawing order, or NULL if the cloud hasn't been setPointCloudSorted
+ * (which makes room to sort it).  The points are also copied in that order
+ * ready to upload
+ *
+ * This is a radix sort of each point's clip space z (further away is
+ * larger for both perspective and orthographic projections), three passes
+ * of 11 bits, a pass where every point has the same digit is skipped
+ */
+unsigned int* sortPointCloud(struct pointCloud_t* pntC, kmMat4* m) {
+
+    struct pointCloudSort_t* s = pntC->sort;
+    if (!s) return NULL;
+    const float* mat = m->mat;
+    const float* pos = pntC->pos;
+    int n = pntC->totalPoints;
+    unsigned int count[3][RADIX_SIZE];
+    memset(count, 0, sizeof(count));
+
+    for (int i = 0; i < n; i++) {
+        union { float f; unsigned int u; } z;
+        z.f = mat[2] * pos[i*3] + mat[6] * pos[i*3+1] + mat[10] * pos[i*3+2] + mat[14];
+        // flipped so the unsigned order is largest z first
+        unsigned int k = (z.u >> 31) ? z.u : ~(z.u | 0x80000000);
+        s->key[0][i] = k;
+        s->order[0][i] = i;
+        count[0][k & (RADIX_SIZE - 1)]++;
+        count[1][(k >> RADIX_BITS) & (RADIX_SIZE - 1)]++;
+        count[2][k >> (RADIX_BITS * 2)]++;
+    }
+
+    int from = 0;
+    for (int pass = 0; pass < 3 && n > 0; pass++) {
+        unsigned int* c = count[pass];
+        unsigned int shift = pass * RADIX_BITS, first = (s->key[from][0] >> shift) & (RADIX_SIZE - 1);
+        if (c[first] == (unsigned int)n) continue;
+
+        unsigned int total = 0;
+        for (int d = 0; d < RADIX_SIZE; d++) {
+            unsigned int t = c[d];
+            c[d] = total;
+            total += t;
+        }
+        unsigned int *key = s->key[from], *order = s->order[from];
+        unsigned int *toKey = s->key[!from], *toOrder = s->order[!from];
+        for (int i = 0; i < n; i++) {
+            unsigned int at = c[(key[i] >> shift) & (RADIX_SIZE - 1)]++;
+            toKey[at] = key[i];
+            toOrder[at] = order[i];
+        }
+        from = !from;
+    }
+
+    unsigned int* order = s->order[from];
+    for (int i = 0; i < n; i++) {
+        unsigned int j = order[i];
+        s->pos[i*3] = pos[j*3];
+        s->pos[i*3+1] = pos[j*3+1];
+        s->pos[i*3+2] = pos[j*3+2];
+    }
+    if (pntC->size) {
+        for (int i = 0; i < n; i++) {
+            s->size[i] = pntC->size[order[i]];
+            memcpy(&s->color[i*4], &pntC->color[order[i]*4], 4);
+        }
+    }
+    return order;
+}
+
+/**
+ * The sprite.attenuation for a projection drawn height pixels high, then a
+ * point sized 1 is 1 unit across in the world (once the size range allows)
+ */
+float pointCloudAttenuation(kmMat4* projection, int height) {
+    return projection->mat[5] * height / 2;
+}
+
+void drawPointCloud(struct pointCloud_t* pntC, kmMat4* mat) {
 
 // least sucky depth fudge!
-    glEnable(GL_POINTS);
     glEnable(GL_PROGRAM_POINT_SIZE);
 //    glDisable(GL_DEPTH_TEST);
     glDepthMask(GL_FALSE);
     glEnable(GL_BLEND);
-    glEnableVertexAttribArray(__pg.part_vert_attrib);
-    glBindBuffer(GL_ARRAY_BUFFER, pntC->vertBuf);
-    glBufferSubData(GL_ARRAY_BUFFER, 0,sizeof(float)*3*pntC->totalPoints, pntC->pos);
-    glVertexAttribPointer(__pg.part_vert_attrib,3,GL_FLOAT,GL_FALSE,0,0);
-    glDrawArrays(GL_POINTS,0,pntC->totalPoints);
-    glDisableVertexAttribArray(pntC->vertBuf);
-    glDisable(GL_POINTS);
+
+    if (!pntC->spawn && pntC->upload == pointCloudRoundRobin) {
+        // the next set, hopefully long finished with
+        pntC->current = (pntC->current + 1) % pntC->buffers;
+        pntC->vertBuf = pntC->ring[pntC->current][0];
+        pntC->sizeBuf = pntC->ring[pntC->current][1];
+        pntC->colorBuf = pntC->ring[pntC->current][2];
+    }
+
+    float* pos = pntC->pos;
+    float* size = pntC->size;
+    unsigned char* color = pntC->color;
+    if (pntC->sort && !pntC->spawn) {
+        sortPointCloud(pntC, mat);
+        pos = pntC->sort->pos;
+        size = pntC->sort->size;
+        color = pntC->sort->color;
+    }
+
+    if (pntC->spawn) {
+        // nothing to upload, the shader works out where the points are
+        drawBallisticPointCloud(pntC, mat);
+    } else if (pntC->size) {
+        drawPointCloudAttribs(pntC, mat, pos, size, color);
+    } else {
+        glUseProgram(__pg.Partprogram);
+        glUniformMatrix4fv(__pg.part_mvp_uniform, 1, GL_FALSE, (GLfloat *) mat);
+        glUniform1i(__pg.part_tex_uniform, 0);
+        setPointSprite(__pg.part_size_uniform, __pg.part_atten_uniform, __pg.part_range_uniform,
+                       &pntC->sprite);
+
+        glEnableVertexAttribArray(__pg.part_vert_attrib);
+        uploadPoints(pntC, pntC->vertBuf, sizeof(float)*3, pos);
+        glVertexAttribPointer(__pg.part_vert_attrib,3,GL_FLOAT,GL_FALSE,0,0);
+        glDrawArrays(GL_POINTS,0,pntC->totalPoints);
+        glDisableVertexAttribArray(__pg.part_vert_attrib);
+    }
+
     //glEnable(GL_DEPTH_TEST);
     glDisable(GL_BLEND);
     glDepthMask(GL_TRUE);
 
-
-
 }
 
 
@@ -528,6 +731,19 @@ struct pointCloud_t* createPointCloud(int size) {
     pntC->totalPoints=size;
     pntC->pos=malloc(size*sizeof(float)*3);
     pntC->vel=malloc(size*sizeof(float)*3);
+    pntC->spawn=NULL;
+    pntC->size=NULL;
+    pntC->color=NULL;
+    pntC->sizeBuf=pntC->colorBuf=0;
+    pntC->tick=0;
+    pntC->maxPoints=size;
+    pntC->upload=pointCloudSubData;
+    pntC->buffers=1;
+    pntC->current=0;
+    pntC->sort=NULL;
+    pntC->pool=NULL;
+    pntC->first=0;
+    memset(&pntC->sprite, 0, sizeof(pntC->sprite));
 
 
     glGenBuffers(1, &pntC->vertBuf);
@@ -538,45 +754,331 @@ struct pointCloud_t* createPointCloud(int size) {
     return pntC;
 }
 
+/**
+ * A point cloud moved by the vertex shader, fill in pos (where each point
+ * starts), vel and spawn (the tick it starts moving at, it isn't drawn
+ * before then) and gravity and drag if wanted, then call uploadPointCloud.
+ * Drawing it only sets tick as the time, nothing is uploaded per frame
+ */
+struct pointCloud_t* createBallisticPointCloud(int size) {
+
+    struct pointCloud_t* pntC=createPointCloud(size);
+    pntC->spawn=calloc(size, sizeof(float));
+    kmVec3Fill(&pntC->gravity, 0, 0, 0);
+    pntC->drag=0;
+    return pntC;
+}
+
+/**
+ * A point cloud where each point also has its own size (in pixels, the
+ * size given to initPointClouds isn't used) and rgba colour (the texture
+ * is multiplied by it), these are uploaded with the positions when drawn
+ */
+struct pointCloud_t* createPointCloudAttribs(int size) {
+
+    struct pointCloud_t* pntC=createPointCloud(size);
+    pntC->size=malloc(size*sizeof(float));
+    pntC->color=malloc(size*4);
+
+    glGenBuffers(1, (GLuint*)&pntC->sizeBuf);
+    glBindBuffer(GL_ARRAY_BUFFER, pntC->sizeBuf);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * size, NULL, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, (GLuint*)&pntC->colorBuf);
+    glBindBuffer(GL_ARRAY_BUFFER, pntC->colorBuf);
+    glBufferData(GL_ARRAY_BUFFER, 4 * size, NULL, GL_DYNAMIC_DRAW);
+    return pntC;
+}
+
+/**
+ * How drawPointCloud uploads the cloud (pointCloudSubData, the default,
+ * pointCloudOrphan or pointCloudRoundRobin through buffers sets of
+ * buffers, at most MAX_POINT_CLOUD_BUFFERS).  Ballistic clouds don't
+ * upload when drawn so it makes no difference to them
+ */
+void setPointCloudUpload(struct pointCloud_t* pntC, int upload, int buffers) {
+
+    if (upload != pointCloudRoundRobin) buffers = 1;
+    if (buffers < 1) buffers = 1;
+    if (buffers > MAX_POINT_CLOUD_BUFFERS) buffers = MAX_POINT_CLOUD_BUFFERS;
+
+    // the cloud's own buffers are the first set
+    if (pntC->buffers == 1) {
+        pntC->ring[0][0] = pntC->vertBuf;
+        pntC->ring[0][1] = pntC->sizeBuf;
+        pntC->ring[0][2] = pntC->colorBuf;
+    }
+    for (int i = pntC->buffers; i < buffers; i++) {
+        glGenBuffers(1, (GLuint*)&pntC->ring[i][0]);
+        glBindBuffer(GL_ARRAY_BUFFER, pntC->ring[i][0]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * pntC->maxPoints, NULL, GL_DYNAMIC_DRAW);
+        if (pntC->size) {
+            glGenBuffers(1, (GLuint*)&pntC->ring[i][1]);
+            glBindBuffer(GL_ARRAY_BUFFER, pntC->ring[i][1]);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(float) * pntC->maxPoints, NULL, GL_DYNAMIC_DRAW);
+            glGenBuffers(1, (GLuint*)&pntC->ring[i][2]);
+            glBindBuffer(GL_ARRAY_BUFFER, pntC->ring[i][2]);
+            glBufferData(GL_ARRAY_BUFFER, 4 * pntC->maxPoints, NULL, GL_DYNAMIC_DRAW);
+        }
+    }
+    if (buffers > pntC->buffers) pntC->buffers = buffers;
+    pntC->upload = upload;
+}
+
+/**
+ * A sorted cloud is drawn furthest point first (see sortPointCloud) so
+ * overlapping blended points come out right, it costs a sort and a copy
+ * of the points each frame.  Ballistic clouds are never sorted, their
+ * points are only moved by the vertex shader
+ */
+void setPointCloudSorted(struct pointCloud_t* pntC, int sorted) {
+
+    struct pointCloudSort_t* s = pntC->sort;
+    if (s) {
+        for (int i = 0; i < 2; i++) {
+            free(s->key[i]);
+            free(s->order[i]);
+        }
+        free(s->pos);
+        free(s->size);
+        free(s->color);
+        free(s);
+        pntC->sort = NULL;
+    }
+    if (!sorted) return;
+
+    int n = pntC->maxPoints;
+    s = malloc(sizeof(struct pointCloudSort_t));
+    for (int i = 0; i < 2; i++) {
+        s->key[i] = malloc(n * sizeof(unsigned int));
+        s->order[i] = malloc(n * sizeof(unsigned int));
+    }
+    s->pos = malloc(n * sizeof(float) * 3);
+    s->size = pntC->size ? malloc(n * sizeof(float)) : NULL;
+    s->color = pntC->size ? malloc(n * 4) : NULL;
+    pntC->sort = s;
+}
+
+/**
+ * Sends a ballistic cloud's starting positions, velocities and spawn times
+ * to its buffer, only needed again when they change (eg an explosion
+ * being reused)
+ */
+void uploadPointCloud(struct pointCloud_t* pntC) {
+
+    float* data=malloc(BALLISTIC_STRIDE * pntC->totalPoints);
+    for (int i=0; i<pntC->totalPoints; i++) {
+        float* d=data+i*7;
+        d[0]=pntC->pos[i*3];
+        d[1]=pntC->pos[i*3+1];
+        d[2]=pntC->pos[i*3+2];
+        d[3]=pntC->vel[i*3];
+        d[4]=pntC->vel[i*3+1];
+        d[5]=pntC->vel[i*3+2];
+        d[6]=pntC->spawn[i];
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, pntC->vertBuf);
+    if (pntC->pool) {
+        // its part of the pool's buffer
+        glBufferSubData(GL_ARRAY_BUFFER, BALLISTIC_STRIDE * pntC->first,
+                        BALLISTIC_STRIDE * pntC->totalPoints, data);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, BALLISTIC_STRIDE * pntC->totalPoints, data, GL_STATIC_DRAW);
+    }
+    free(data);
+}
+
+/**
+ * A pooled cloud goes back to its pool, otherwise the cloud's buffers,
+ * arrays and the cloud itself are freed
+ */
 void freePointCloud(struct pointCloud_t* pntC) {
+    struct pointCloudPool_t* pool = pntC->pool;
+    if (pool) {
+        int i = pntC - pool->cloud;
+        if (!pool->active[i]) return;     // already back, freed twice
+        pool->active[i] = false;
+        pool->nextFree[i] = pool->firstFree;
+        pool->firstFree = i;
+        return;
+    }
+
+    // every set of round robin buffers, or just the ones it was created with
+    if (pntC->buffers == 1) {
+        pntC->ring[0][0] = pntC->vertBuf;
+        pntC->ring[0][1] = pntC->sizeBuf;
+        pntC->ring[0][2] = pntC->colorBuf;
+    }
+    for (int i = 0; i < pntC->buffers; i++)
+        glDeleteBuffers(pntC->size ? 3 : 1, (GLuint*)pntC->ring[i]);
+    setPointCloudSorted(pntC, 0);
     free(pntC->pos);
     free(pntC->vel);
+    free(pntC->spawn);
+    free(pntC->size);
+    free(pntC->color);
     free(pntC);
 }
 
-void initPointClouds(const char* vertS, const char* fragS, float pntSize) {
+/**
+ * A pool of ballistic clouds (see createBallisticPointCloud), clouds of
+ * them with points points each, all in one buffer.  allocPointCloud takes
+ * one from the pool, fill in pos (in world space, clouds in a pool are all
+ * drawn with the same matrix), vel and spawn (pool->tick when it should
+ * start) then call uploadPointCloud.  freePointCloud gives it back
+ */
+struct pointCloudPool_t* createPointCloudPool(int clouds, int points) {
+
+    struct pointCloudPool_t* pool = malloc(sizeof(struct pointCloudPool_t));
+    int total = clouds * points;
+    pool->clouds = clouds;
+    pool->points = points;
+    pool->tick = 0;
+    kmVec3Fill(&pool->gravity, 0, 0, 0);
+    pool->drag = 0;
+    memset(&pool->sprite, 0, sizeof(pool->sprite));
+    pool->pos = calloc(total * 3, sizeof(float));
+    pool->vel = calloc(total * 3, sizeof(float));
+    pool->spawn = calloc(total, sizeof(float));
+    pool->cloud = calloc(clouds, sizeof(struct pointCloud_t));
+    pool->active = calloc(clouds, sizeof(bool));
+    pool->nextFree = malloc(clouds * sizeof(int));
+
+    glGenBuffers(1, (GLuint*)&pool->vertBuf);
+    glBindBuffer(GL_ARRAY_BUFFER, pool->vertBuf);
+    glBufferData(GL_ARRAY_BUFFER, BALLISTIC_STRIDE * total, NULL, GL_DYNAMIC_DRAW);
+
+    for (int i = 0; i < clouds; i++) {
+        struct pointCloud_t* pntC = &pool->cloud[i];
+        pntC->totalPoints = pntC->maxPoints = points;
+        pntC->first = i * points;
+        pntC->pos = pool->pos + pntC->first * 3;
+        pntC->vel = pool->vel + pntC->first * 3;
+        pntC->spawn = pool->spawn + pntC->first;
+        pntC->vertBuf = pool->vertBuf;
+        pntC->upload = pointCloudSubData;
+        pntC->buffers = 1;
+        pntC->pool = pool;
+        pool->nextFree[i] = i + 1 < clouds ? i + 1 : -1;
+    }
+    pool->firstFree = clouds ? 0 : -1;
+    return pool;
+}
+
+// NULL when every cloud in the pool is in use
+struct pointCloud_t* allocPointCloud(struct pointCloudPool_t* pool) {
+
+    int i = pool->firstFree;
+    if (i < 0) return NULL;
+    pool->firstFree = pool->nextFree[i];
+    pool->active[i] = true;
+
+    struct pointCloud_t* pntC = &pool->cloud[i];
+    pntC->totalPoints = pool->points;
+    pntC->tick = pool->tick;
+    pntC->gravity = pool->gravity;
+    pntC->drag = pool->drag;
+    pntC->sprite = pool->sprite;
+    return pntC;
+}
+
+/**
+ * Draws every cloud in use at pool->tick, clouds next to each other in
+ * the pool are drawn together so a full pool is one glDrawArrays
+ */
+void drawPointCloudPool(struct pointCloudPool_t* pool, kmMat4* mat) {
+
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
 
-    GLint link_ok = GL_FALSE;
+    beginBallistic(pool->vertBuf, mat, pool->tick, &pool->gravity, pool->drag, &pool->sprite);
+    for (int i = 0; i < pool->clouds;) {
+        if (!pool->active[i]) {
+            i++;
+            continue;
+        }
+        int first = i;
+        while (i < pool->clouds && pool->active[i]) i++;
+        glDrawArrays(GL_POINTS, first * pool->points, (i - first) * pool->points);
+    }
+    endBallistic();
+
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+}
+
+// the pool's clouds can't be used after this
+void freePointCloudPool(struct pointCloudPool_t* pool) {
+    glDeleteBuffers(1, (GLuint*)&pool->vertBuf);
+    free(pool->pos);
+    free(pool->vel);
+    free(pool->spawn);
+    free(pool->cloud);
+    free(pool->active);
+    free(pool->nextFree);
+    free(pool);
+}
 
-    GLuint vs, fs;
-    vs = create_shader(vertS, GL_VERTEX_SHADER);
-    fs = create_shader(fragS, GL_FRAGMENT_SHADER);
-    __pg.Partprogram = glCreateProgram();
+void initPointClouds(const char* vertS, const char* fragS, float pntSize) {
 
-    glAttachShader(__pg.Partprogram, vs);
-    glAttachShader(__pg.Partprogram, fs);
-    glLinkProgram(__pg.Partprogram);
-    glGetProgramiv(__pg.Partprogram, GL_LINK_STATUS, &link_ok);
-    if (!link_ok) {
+    struct program_t *p = getProgram(vertS, fragS, NULL);
+    releaseProgram(__pg.shader);
+    __pg.shader = p;
+    if (!p) {
         printf("particle glLinkProgram error \n");
-        print_log(__pg.Partprogram);
-        //    return 0;
+        return;
+    }
+
+    __pg.Partprogram = p->id;
+    __pg.part_vert_attrib = programLocation(p, shaderAttrib, "vertex_attrib");
+    __pg.part_mvp_uniform = programLocation(p, shaderUniform, "mvp_uniform");
+    __pg.part_tex_uniform = programLocation(p, shaderUniform, "u_texture");
+    __pg.part_size_uniform = programLocation(p, shaderUniform, "u_point_size");
+    __pg.part_atten_uniform = programLocation(p, shaderUniform, "u_attenuation");
+    __pg.part_range_uniform = programLocation(p, shaderUniform, "u_size_range");
+
+    p = getProgram(vertS, fragS, "#define BALLISTIC\n");
+    releaseProgram(__pg.ballShader);
+    __pg.ballShader = p;
+    if (!p) {
+        printf("ballistic particle glLinkProgram error \n");
+        return;
+    }
+
+    __pg.ballProgram = p->id;
+    __pg.ball_vert_attrib = programLocation(p, shaderAttrib, "vertex_attrib");
+    __pg.ball_vel_attrib = programLocation(p, shaderAttrib, "vel_attrib");
+    __pg.ball_spawn_attrib = programLocation(p, shaderAttrib, "spawn_attrib");
+    __pg.ball_mvp_uniform = programLocation(p, shaderUniform, "mvp_uniform");
+    __pg.ball_tex_uniform = programLocation(p, shaderUniform, "u_texture");
+    __pg.ball_size_uniform = programLocation(p, shaderUniform, "u_point_size");
+    __pg.ball_time_uniform = programLocation(p, shaderUniform, "u_time");
+    __pg.ball_gravity_uniform = programLocation(p, shaderUniform, "u_gravity");
+    __pg.ball_drag_uniform = programLocation(p, shaderUniform, "u_drag");
+    __pg.ball_atten_uniform = programLocation(p, shaderUniform, "u_attenuation");
+    __pg.ball_range_uniform = programLocation(p, shaderUniform, "u_size_range");
+
+    p = getProgram(vertS, fragS, "#define POINT_ATTRIBS\n");
+    releaseProgram(__pg.attrShader);
+    __pg.attrShader = p;
+    if (!p) {
+        printf("point attribs particle glLinkProgram error \n");
+        return;
     }
 
-    __pg.part_vert_attrib =
-        getShaderLocation(shaderAttrib, __pg.Partprogram, "vertex_attrib");
-    __pg.part_mvp_uniform =
-        getShaderLocation(shaderUniform, __pg.Partprogram, "mvp_uniform");
-    __pg.part_tex_uniform =
-        getShaderLocation(shaderUniform, __pg.Partprogram, "u_texture");
+    __pg.attrProgram = p->id;
+    __pg.attr_vert_attrib = programLocation(p, shaderAttrib, "vertex_attrib");
+    __pg.attr_size_attrib = programLocation(p, shaderAttrib, "size_attrib");
+    __pg.attr_color_attrib = programLocation(p, shaderAttrib, "color_attrib");
+    __pg.attr_mvp_uniform = programLocation(p, shaderUniform, "mvp_uniform");
+    __pg.attr_tex_uniform = programLocation(p, shaderUniform, "u_texture");
+    __pg.attr_atten_uniform = programLocation(p, shaderUniform, "u_attenuation");
+    __pg.attr_range_uniform = programLocation(p, shaderUniform, "u_size_range");
 
-	__pg.part_size_uniform =
-	getShaderLocation(shaderUniform, __pg.Partprogram, "u_point_size");
-	
 	resizePointCloudSprites(pntSize);
 }
 
+// the size in pixels of points in clouds without a sprite.size of their own
 void resizePointCloudSprites(float s) {
-    glUseProgram(__pg.Partprogram);
-    glUniform1f(__pg.part_size_uniform, s);
+    __pg.pointSize = s;
 }
@@ -0,0 +1,117 @@
+#include <kazmath.h>
+#include <stdlib.h>
+#include <string.h>
+#include "transform.h"
+
+/*
+ * out = a * b for the listed nodes, consecutive nodes are batched together
+ * so kazmath can keep a in registers
+ */
+static void multiplyList(kmMat4 *out, const kmMat4 *a, const kmMat4 *b,
+                         const int *list, int n)
+{
+    for (int k = 0; k < n;) {
+        int first = list[k], run = 1;
+        while (k + run < n && list[k + run] == first + run) run++;
+        kmMat4MultiplyBatch(&out[first], a, &b[first], run);
+        k += run;
+    }
+}
+
+static void growTransforms(struct transforms_t* t, int capacity)
+{
+    t->capacity = capacity;
+    t->parent = realloc(t->parent, sizeof(int) * capacity);
+    t->changed = realloc(t->changed, sizeof(int) * capacity);
+    t->dirty = realloc(t->dirty, capacity);
+    t->local = realloc(t->local, sizeof(kmMat4) * capacity);
+    t->world = realloc(t->world, sizeof(kmMat4) * capacity);
+    t->mv = realloc(t->mv, sizeof(kmMat4) * capacity);
+    t->mvp = realloc(t->mvp, sizeof(kmMat4) * capacity);
+}
+
+struct transforms_t* createTransforms(int capacity) {
+    struct transforms_t* t = calloc(1, sizeof(struct transforms_t));
+    growTransforms(t, capacity > 0 ? capacity : 16);
+    return t;
+}
+
+/*
+ * adds a node (with an identity local matrix) returning its index, the
+ * parent must already have been added or be -1, returns -1 on a bad parent
+ */
+int addTransform(struct transforms_t* t, int parent) {
+    if (parent < -1 || parent >= t->count) return -1;
+    if (t->count == t->capacity) growTransforms(t, t->capacity * 2);
+
+    int i = t->count++;
+    t->parent[i] = parent;
+    t->dirty[i] = 1;
+    kmMat4Identity(&t->local[i]);
+    return i;
+}
+
+/*
+ * position then rotation, the same as the examples building a model matrix
+ */
+void setTransform(struct transforms_t* t, int node, kmVec3 pos,
+                  kmScalar pitch, kmScalar yaw, kmScalar roll) {
+    kmMat4 rot;
+    kmMat4Translation(&t->local[node], pos.x, pos.y, pos.z);
+    kmMat4RotationYawPitchRoll(&rot, pitch, yaw, roll);
+    kmMat4Multiply(&t->local[node], &t->local[node], &rot);
+    t->dirty[node] = 1;
+}
+
+void setTransformLocal(struct transforms_t* t, int node, kmMat4* local) {
+    kmMat4Assign(&t->local[node], local);
+    t->dirty[node] = 1;
+}
+
+/*
+ * returns how many world matrices were recalculated
+ */
+int updateTransforms(struct transforms_t* t, kmMat4* view, kmMat4* projection) {
+    int n = 0;
+    int camera = memcmp(view, &t->view, sizeof(kmMat4)) != 0 ||
+                 memcmp(projection, &t->projection, sizeof(kmMat4)) != 0;
+
+    if (camera) {
+        kmMat4Assign(&t->view, view);
+        kmMat4Assign(&t->projection, projection);
+        kmMat4Multiply(&t->vp, projection, view);
+    }
+
+    // parents come first so a dirty parent has already marked its children
+    for (int i = 0; i < t->count; i++) {
+        int p = t->parent[i];
+        if (p != -1 && t->dirty[p]) t->dirty[i] = 1;
+        if (!t->dirty[i]) continue;
+
+        if (p == -1) t->world[i] = t->local[i];
+        else kmMat4Multiply(&t->world[i], &t->world[p], &t->local[i]);
+        t->changed[n++] = i;
+    }
+
+    if (camera) {
+        kmMat4MultiplyBatch(t->mv, &t->view, t->world, t->count);
+        kmMat4MultiplyBatch(t->mvp, &t->vp, t->world, t->count);
+    } else {
+        multiplyList(t->mv, &t->view, t->world, t->changed, n);
+        multiplyList(t->mvp, &t->vp, t->world, t->changed, n);
+    }
+
+    memset(t->dirty, 0, t->count);
+    return n;
+}
+
+void freeTransforms(struct transforms_t* t) {
+    free(t->parent);
+    free(t->changed);
+    free(t->dirty);
+    free(t->local);
+    free(t->world);
+    free(t->mv);
+    free(t->mvp);
+    free(t);
+}
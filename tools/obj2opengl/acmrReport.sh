@@ -0,0 +1,8 @@
+#!/bin/sh
+
+# rebuilds every model here and reports the vertex cache miss ratio
+# before and after gbovcache, eg ./acmrReport.sh 3 to include 3 lods
+
+for f in *.obj; do
+	./makeGBO.sh ${f%.obj} $1 | grep ACMR
+done
@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# times the perl pipeline against obj2gbo on a generated heightfield OBJ
+# ./benchObj.sh [size] makes a size x size grid, 200 is about 7MB
+
+N=${1:-200}
+B=/tmp/benchObj$$
+mkdir -p $B
+
+awk -v n=$N 'BEGIN {
+	for (z = 0; z <= n; z++) for (x = 0; x <= n; x++) {
+		y = sin(x * 0.1) * cos(z * 0.13) * 4
+		printf "v %f %f %f\n", x - n / 2, y, z - n / 2
+		printf "vt %f %f\n", x / n, z / n
+		printf "vn %f %f %f\n", -cos(x * 0.1) * 0.4, 1, sin(z * 0.13) * 0.52
+	}
+	for (z = 0; z < n; z++) for (x = 0; x < n; x++) {
+		a = z * (n + 1) + x + 1; b = a + 1; c = a + n + 1; d = c + 1
+		printf "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, b, b, b
+		printf "f %d/%d/%d %d/%d/%d %d/%d/%d\n", b, b, b, c, c, c, d, d, d
+	}
+}' > $B/grid.obj
+ls -l $B/grid.obj | awk '{ print "grid.obj " $5 " bytes" }'
+
+make -s obj2gbo
+
+echo "perl + builder"
+time sh -c "./obj2opengl.pl -noverbose -noScale -noMove -o $B/OBJ.h $B/grid.obj && \
+	gcc -I$B builder.c -o $B/builder && $B/builder $B/perl.gbo"
+
+echo "obj2gbo"
+time ./obj2gbo -o $B/native.gbo $B/grid.obj
+
+# a batch of copies, one thread then one per cpu
+for i in 1 2 3 4 5 6 7 8; do cp $B/grid.obj $B/grid$i.obj; done
+echo "obj2gbo 8 files, 1 thread"
+time ./obj2gbo -j 1 $B/grid?.obj > /dev/null
+echo "obj2gbo 8 files, `nproc` threads"
+time ./obj2gbo $B/grid?.obj > /dev/null
+
+rm -rf $B
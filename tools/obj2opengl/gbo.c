@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "gbo.h"
+
+static int readMesh(struct gboMesh *m, FILE *f, int indexed)
+{
+	m->verts = malloc(sizeof(float) * 3 * m->numVerts);
+	m->norms = malloc(sizeof(float) * 3 * m->numVerts);
+	m->tex = malloc(sizeof(float) * 2 * m->numVerts);
+	m->indices = 0;
+
+	if (fread(m->verts, sizeof(float) * 3, m->numVerts, f) != m->numVerts) return 0;
+	if (fread(m->norms, sizeof(float) * 3, m->numVerts, f) != m->numVerts) return 0;
+	if (fread(m->tex, sizeof(float) * 2, m->numVerts, f) != m->numVerts) return 0;
+
+	if (indexed && m->numIndices) {
+		m->indices = malloc(sizeof(unsigned short) * m->numIndices);
+		if (fread(m->indices, sizeof(unsigned short), m->numIndices, f) != m->numIndices)
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * reads either version of GBO, a version 'a' file ends up as a single
+ * un-indexed lod
+ */
+int gboRead(struct gboFile *gbo, const char *filename)
+{
+	FILE *f = fopen(filename, "rb");
+	unsigned int magic;
+
+	memset(gbo, 0, sizeof(struct gboFile));
+	if (!f) {
+		printf("Cant open %s\n", filename);
+		return 0;
+	}
+
+	fread(&magic, 1, sizeof(unsigned int), f);
+	if (magic == GBO_MAGIC_A) {
+		gbo->numLods = 1;
+		fread(&gbo->lod[0].numVerts, 1, sizeof(unsigned int), f);
+		if (!readMesh(&gbo->lod[0], f, 0)) goto truncated;
+		gboBounds(gbo);
+	} else if (magic == GBO_MAGIC_B) {
+		fread(&gbo->numLods, 1, sizeof(unsigned int), f);
+		fread(gbo->bounds, 4, sizeof(float), f);
+		if (gbo->numLods < 1 || gbo->numLods > GBO_MAX_LODS) {
+			printf("%s has a silly number of lods (%u)\n", filename, gbo->numLods);
+			fclose(f);
+			return 0;
+		}
+		for (unsigned int l = 0; l < gbo->numLods; l++) {
+			struct gboMesh *m = &gbo->lod[l];
+			fread(&m->numVerts, 1, sizeof(unsigned int), f);
+			fread(&m->numIndices, 1, sizeof(unsigned int), f);
+			fread(&m->error, 1, sizeof(float), f);
+			if (!readMesh(m, f, 1)) goto truncated;
+		}
+	} else {
+		printf("%s does not appear to be a GBO file\n", filename);
+		fclose(f);
+		return 0;
+	}
+
+	fclose(f);
+	return 1;
+
+truncated:
+	printf("%s is truncated\n", filename);
+	fclose(f);
+	gboFree(gbo);
+	return 0;
+}
+
+/*
+ * writes a version 'b' file, unless there is just one un-indexed lod
+ * (too many vertices for 16 bit indices) which is written as version 'a'
+ */
+int gboWrite(struct gboFile *gbo, const char *filename)
+{
+	FILE *f = fopen(filename, "wb");
+	unsigned int magic = GBO_MAGIC_B;
+
+	if (!f) {
+		printf("Cant create %s\n", filename);
+		return 0;
+	}
+
+	if (gbo->numLods == 1 && gbo->lod[0].numIndices == 0) {
+		struct gboMesh *m = &gbo->lod[0];
+		magic = GBO_MAGIC_A;
+		fwrite(&magic, 1, sizeof(unsigned int), f);
+		fwrite(&m->numVerts, 1, sizeof(unsigned int), f);
+		fwrite(m->verts, sizeof(float) * 3, m->numVerts, f);
+		fwrite(m->norms, sizeof(float) * 3, m->numVerts, f);
+		fwrite(m->tex, sizeof(float) * 2, m->numVerts, f);
+		fclose(f);
+		return 1;
+	}
+
+	fwrite(&magic, 1, sizeof(unsigned int), f);
+	fwrite(&gbo->numLods, 1, sizeof(unsigned int), f);
+	fwrite(gbo->bounds, 4, sizeof(float), f);
+	for (unsigned int l = 0; l < gbo->numLods; l++) {
+		struct gboMesh *m = &gbo->lod[l];
+		fwrite(&m->numVerts, 1, sizeof(unsigned int), f);
+		fwrite(&m->numIndices, 1, sizeof(unsigned int), f);
+		fwrite(&m->error, 1, sizeof(float), f);
+		fwrite(m->verts, sizeof(float) * 3, m->numVerts, f);
+		fwrite(m->norms, sizeof(float) * 3, m->numVerts, f);
+		fwrite(m->tex, sizeof(float) * 2, m->numVerts, f);
+		fwrite(m->indices, sizeof(unsigned short), m->numIndices, f);
+	}
+	fclose(f);
+	return 1;
+}
+
+void gboFreeMesh(struct gboMesh *m)
+{
+	free(m->verts);
+	free(m->norms);
+	free(m->tex);
+	free(m->indices);
+	memset(m, 0, sizeof(struct gboMesh));
+}
+
+void gboFree(struct gboFile *gbo)
+{
+	for (unsigned int l = 0; l < gbo->numLods; l++)
+		gboFreeMesh(&gbo->lod[l]);
+	gbo->numLods = 0;
+}
+
+/*
+ * bounding sphere around lod 0, centred on the middle of the bounding box
+ * which is a little loose but good enough for picking a lod
+ */
+void gboBounds(struct gboFile *gbo)
+{
+	struct gboMesh *m = &gbo->lod[0];
+	float mn[3], mx[3], r2 = 0;
+
+	if (!m->numVerts) {
+		memset(gbo->bounds, 0, sizeof(gbo->bounds));
+		return;
+	}
+
+	for (int c = 0; c < 3; c++) mn[c] = mx[c] = m->verts[c];
+	for (unsigned int i = 1; i < m->numVerts; i++) {
+		for (int c = 0; c < 3; c++) {
+			float v = m->verts[i * 3 + c];
+			if (v < mn[c]) mn[c] = v;
+			if (v > mx[c]) mx[c] = v;
+		}
+	}
+	for (int c = 0; c < 3; c++) gbo->bounds[c] = (mn[c] + mx[c]) * .5f;
+
+	for (unsigned int i = 0; i < m->numVerts; i++) {
+		float d = 0;
+		for (int c = 0; c < 3; c++) {
+			float e = m->verts[i * 3 + c] - gbo->bounds[c];
+			d += e * e;
+		}
+		if (d > r2) r2 = d;
+	}
+	gbo->bounds[3] = sqrtf(r2);
+}
+
+static unsigned int hashVert(const float *v)
+{
+	unsigned int h = 2166136261u;
+	const unsigned char *b = (const unsigned char *)v;
+	for (int i = 0; i < (int)(sizeof(float) * 8); i++) {
+		h ^= b[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/*
+ * turns a triangle soup into an indexed mesh by merging corners that
+ * have exactly the same position, normal and texture coordinate
+ *
+ * returns 0 if there are too many unique vertices for 16 bit indices
+ */
+int gboWeld(struct gboMesh *out, const struct gboMesh *soup)
+{
+	unsigned int n = soup->numVerts;
+	unsigned int tableSize = 1;
+	while (tableSize < n * 2) tableSize *= 2;
+
+	int *table = malloc(sizeof(int) * tableSize);
+	float *keys = malloc(sizeof(float) * 8 * (n ? n : 1));
+	memset(table, -1, sizeof(int) * tableSize);
+
+	memset(out, 0, sizeof(struct gboMesh));
+	out->numIndices = n;
+	out->indices = malloc(sizeof(unsigned short) * (n ? n : 1));
+	out->verts = malloc(sizeof(float) * 3 * (n ? n : 1));
+	out->norms = malloc(sizeof(float) * 3 * (n ? n : 1));
+	out->tex = malloc(sizeof(float) * 2 * (n ? n : 1));
+
+	for (unsigned int i = 0; i < n; i++) {
+		float key[8];
+		memcpy(key, soup->verts + i * 3, sizeof(float) * 3);
+		memcpy(key + 3, soup->norms + i * 3, sizeof(float) * 3);
+		memcpy(key + 6, soup->tex + i * 2, sizeof(float) * 2);
+
+		unsigned int slot = hashVert(key) & (tableSize - 1);
+		while (table[slot] != -1 &&
+		       memcmp(keys + table[slot] * 8, key, sizeof(key)) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == -1) {
+			if (out->numVerts == 65536) {
+				printf("too many unique vertices for 16 bit indices\n");
+				free(table);
+				free(keys);
+				gboFreeMesh(out);
+				return 0;
+			}
+			table[slot] = out->numVerts;
+			memcpy(keys + out->numVerts * 8, key, sizeof(key));
+			memcpy(out->verts + out->numVerts * 3, key, sizeof(float) * 3);
+			memcpy(out->norms + out->numVerts * 3, key + 3, sizeof(float) * 3);
+			memcpy(out->tex + out->numVerts * 2, key + 6, sizeof(float) * 2);
+			out->numVerts++;
+		}
+		out->indices[i] = table[slot];
+	}
+
+	free(table);
+	free(keys);
+	return 1;
+}
@@ -0,0 +1,56 @@
+/*
+ * shared GBO (Gles Binary Object) reading and writing for the model tools
+ *
+ * version 'a' is a plain triangle soup
+ *
+ *	magic, numVerts, verts[3*n], norms[3*n], texcoords[2*n]
+ *
+ * version 'b' is indexed and may hold several levels of detail, lod 0 being
+ * the full detail mesh
+ *
+ *	magic, numLods, bounding sphere (centre x,y,z, radius)
+ *	for each lod
+ *		numVerts, numIndices, error
+ *		verts[3*numVerts], norms[3*numVerts], texcoords[2*numVerts]
+ *		indices[numIndices] (unsigned short)
+ *
+ * error is the largest distance (in model units) the simplifier moved the
+ * surface while making that lod, its 0 for lod 0
+ *
+ * meshes with more than 65536 unique vertices can't be indexed and are
+ * kept as version 'a'
+ */
+
+#ifndef GBO_H
+#define GBO_H
+
+#define GBO_MAGIC_A 0x614F4247	// "GBOa" in little endian
+#define GBO_MAGIC_B 0x624F4247	// "GBOb"
+
+#define GBO_MAX_LODS 4
+
+struct gboMesh {
+	unsigned int numVerts;
+	unsigned int numIndices;	// 0 when the mesh is a triangle soup
+	float error;
+	float *verts;
+	float *norms;
+	float *tex;
+	unsigned short *indices;
+};
+
+struct gboFile {
+	unsigned int numLods;
+	float bounds[4];
+	struct gboMesh lod[GBO_MAX_LODS];
+};
+
+int gboRead(struct gboFile *gbo, const char *filename);
+int gboWrite(struct gboFile *gbo, const char *filename);
+void gboFree(struct gboFile *gbo);
+void gboFreeMesh(struct gboMesh *m);
+
+int gboWeld(struct gboMesh *out, const struct gboMesh *soup);
+void gboBounds(struct gboFile *gbo);
+
+#endif
@@ -0,0 +1,431 @@
+/*
+ * gbolod - builds levels of detail for a GBO
+ *
+ * reads a GBO (either version), welds it into an indexed mesh and then
+ * repeatedly simplifies it with quadric error metrics (Garland & Heckbert)
+ * writing a version 'b' GBO holding all the lods
+ *
+ * gbolod [-l levels] [-r ratio] in.gbo out.gbo
+ *
+ * each lod aims for ratio (default 0.5) of the triangles of the one before
+ * a lod that can't be made at least 10% smaller than the last is dropped
+ *
+ * collapses are "half edge" - a vertex is moved onto one of its neighbours
+ * so no new positions or texture coordinates are ever invented, vertices
+ * on texture / normal seams and open borders are never moved
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "gbo.h"
+
+struct collapse {
+	unsigned int from, to;
+	double cost;
+};
+
+static void planeQuadric(double *q, const float *p0, const float *p1, const float *p2)
+{
+	double e1[3], e2[3], n[3], len, d;
+	for (int c = 0; c < 3; c++) {
+		e1[c] = p1[c] - p0[c];
+		e2[c] = p2[c] - p0[c];
+	}
+	n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	if (len == 0) return;
+	n[0] /= len;
+	n[1] /= len;
+	n[2] /= len;
+	d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+
+	// symmetric 4x4 stored as upper triangle aa ab ac ad bb bc bd cc cd dd
+	q[0] += n[0] * n[0];
+	q[1] += n[0] * n[1];
+	q[2] += n[0] * n[2];
+	q[3] += n[0] * d;
+	q[4] += n[1] * n[1];
+	q[5] += n[1] * n[2];
+	q[6] += n[1] * d;
+	q[7] += n[2] * n[2];
+	q[8] += n[2] * d;
+	q[9] += d * d;
+}
+
+static double quadricError(const double *q, const float *p)
+{
+	double x = p[0], y = p[1], z = p[2];
+	double e = q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+	           + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+	           + q[7] * z * z + 2 * q[8] * z
+	           + q[9];
+	return e < 0 ? 0 : e;
+}
+
+static void triNormal(double *n, const float *p0, const float *p1, const float *p2)
+{
+	double e1[3], e2[3];
+	for (int c = 0; c < 3; c++) {
+		e1[c] = p1[c] - p0[c];
+		e2[c] = p2[c] - p0[c];
+	}
+	n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+static int cmpCollapse(const void *a, const void *b)
+{
+	double ca = ((const struct collapse *)a)->cost;
+	double cb = ((const struct collapse *)b)->cost;
+	return (ca > cb) - (ca < cb);
+}
+
+/*
+ * mesh wide state for one simplification run, vertices are the
+ * welded render vertices, "pos" maps each to the first render vertex
+ * sharing its position
+ */
+struct simplifier {
+	const float *verts;
+	unsigned int numVerts;
+	unsigned int *pos;
+	unsigned char *locked;
+	double *quadrics;	// 10 per position
+};
+
+static void initSimplifier(struct simplifier *s, const struct gboMesh *m)
+{
+	unsigned int nv = m->numVerts, nt = m->numIndices / 3;
+
+	s->verts = m->verts;
+	s->numVerts = nv;
+	s->pos = malloc(sizeof(unsigned int) * nv);
+	s->locked = calloc(nv, 1);
+	s->quadrics = calloc(nv * 10, sizeof(double));
+
+	// group render vertices by position, any group of more than one
+	// is sitting on a seam
+	for (unsigned int i = 0; i < nv; i++) {
+		s->pos[i] = i;
+		for (unsigned int j = 0; j < i; j++) {
+			if (memcmp(m->verts + i * 3, m->verts + j * 3, sizeof(float) * 3) == 0) {
+				s->pos[i] = s->pos[j];
+				s->locked[i] = s->locked[j] = 1;
+				break;
+			}
+		}
+	}
+
+	for (unsigned int t = 0; t < nt; t++) {
+		const unsigned short *tri = m->indices + t * 3;
+		const float *p0 = m->verts + tri[0] * 3;
+		const float *p1 = m->verts + tri[1] * 3;
+		const float *p2 = m->verts + tri[2] * 3;
+		for (int k = 0; k < 3; k++)
+			planeQuadric(s->quadrics + s->pos[tri[k]] * 10, p0, p1, p2);
+	}
+
+	// lock open borders, an edge (by position) used by only one triangle
+	// counting is quadratic but the meshes these tools see are small
+	for (unsigned int t = 0; t < nt; t++) {
+		for (int k = 0; k < 3; k++) {
+			unsigned int a = s->pos[m->indices[t * 3 + k]];
+			unsigned int b = s->pos[m->indices[t * 3 + (k + 1) % 3]];
+			int uses = 0;
+			for (unsigned int u = 0; u < nt && uses < 2; u++) {
+				for (int j = 0; j < 3; j++) {
+					unsigned int c = s->pos[m->indices[u * 3 + j]];
+					unsigned int d = s->pos[m->indices[u * 3 + (j + 1) % 3]];
+					if ((c == a && d == b) || (c == b && d == a)) uses++;
+				}
+			}
+			if (uses < 2) {
+				s->locked[m->indices[t * 3 + k]] = 1;
+				s->locked[m->indices[t * 3 + (k + 1) % 3]] = 1;
+			}
+		}
+	}
+	for (unsigned int i = 0; i < nv; i++)
+		if (s->locked[i]) s->locked[s->pos[i]] = 1;
+}
+
+static void freeSimplifier(struct simplifier *s)
+{
+	free(s->pos);
+	free(s->locked);
+	free(s->quadrics);
+}
+
+/*
+ * would moving "from" onto "to" flip or flatten any triangle round "from"
+ */
+static int flips(struct simplifier *s, unsigned short *idx, unsigned int nt,
+                 unsigned int from, unsigned int to)
+{
+	for (unsigned int t = 0; t < nt; t++) {
+		unsigned short *tri = idx + t * 3;
+		int k;
+		for (k = 0; k < 3; k++) if (tri[k] == from) break;
+		if (k == 3) continue;
+		if (s->pos[tri[(k + 1) % 3]] == s->pos[to] ||
+		    s->pos[tri[(k + 2) % 3]] == s->pos[to]) continue;	// goes away
+
+		const float *p[3], *q[3];
+		for (int j = 0; j < 3; j++) p[j] = q[j] = s->verts + tri[j] * 3;
+		q[k] = s->verts + to * 3;
+
+		double n0[3], n1[3];
+		triNormal(n0, p[0], p[1], p[2]);
+		triNormal(n1, q[0], q[1], q[2]);
+		double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+		double l1 = n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2];
+		if (dot <= 0 || l1 == 0) return 1;
+	}
+	return 0;
+}
+
+/*
+ * simplify idx (nt triangles) in place towards target triangles,
+ * returns the new triangle count
+ */
+static unsigned int simplify(struct simplifier *s, unsigned short *idx,
+                             unsigned int nt, unsigned int target)
+{
+	unsigned int *remap = malloc(sizeof(unsigned int) * s->numVerts);
+	unsigned char *touched = malloc(s->numVerts);
+	struct collapse *edges = malloc(sizeof(struct collapse) * nt * 6);
+
+	while (nt > target) {
+		unsigned int ne = 0, done = 0;
+
+		for (unsigned int t = 0; t < nt; t++) {
+			for (int k = 0; k < 3; k++) {
+				unsigned int a = idx[t * 3 + k], b = idx[t * 3 + (k + 1) % 3];
+				for (int dir = 0; dir < 2; dir++) {
+					unsigned int from = dir ? b : a, to = dir ? a : b;
+					if (s->locked[from]) continue;
+					double q[10];
+					for (int j = 0; j < 10; j++)
+						q[j] = s->quadrics[s->pos[from] * 10 + j] +
+						       s->quadrics[s->pos[to] * 10 + j];
+					edges[ne].from = from;
+					edges[ne].to = to;
+					edges[ne].cost = quadricError(q, s->verts + to * 3);
+					ne++;
+				}
+			}
+		}
+		qsort(edges, ne, sizeof(struct collapse), cmpCollapse);
+
+		for (unsigned int i = 0; i < s->numVerts; i++) remap[i] = i;
+		memset(touched, 0, s->numVerts);
+
+		unsigned int remaining = nt;
+		for (unsigned int e = 0; e < ne && remaining > target; e++) {
+			unsigned int from = edges[e].from, to = edges[e].to;
+			if (touched[s->pos[from]] || touched[s->pos[to]]) continue;
+			if (flips(s, idx, nt, from, to)) continue;
+
+			// everything round "from" is now stale for this pass
+			for (unsigned int t = 0; t < nt; t++) {
+				unsigned short *tri = idx + t * 3;
+				if (tri[0] != from && tri[1] != from && tri[2] != from) continue;
+				for (int k = 0; k < 3; k++) touched[s->pos[tri[k]]] = 1;
+				if (s->pos[tri[0]] == s->pos[to] || s->pos[tri[1]] == s->pos[to] ||
+				    s->pos[tri[2]] == s->pos[to])
+					remaining--;
+			}
+			remap[from] = to;
+			for (int j = 0; j < 10; j++)
+				s->quadrics[s->pos[to] * 10 + j] += s->quadrics[s->pos[from] * 10 + j];
+			done++;
+		}
+		if (!done) break;
+
+		// apply the pass, dropping triangles that became degenerate
+		unsigned int out = 0;
+		for (unsigned int t = 0; t < nt; t++) {
+			unsigned int a = remap[idx[t * 3]];
+			unsigned int b = remap[idx[t * 3 + 1]];
+			unsigned int c = remap[idx[t * 3 + 2]];
+			if (s->pos[a] == s->pos[b] || s->pos[b] == s->pos[c] ||
+			    s->pos[a] == s->pos[c]) continue;
+			idx[out * 3] = a;
+			idx[out * 3 + 1] = b;
+			idx[out * 3 + 2] = c;
+			out++;
+		}
+		nt = out;
+	}
+
+	free(edges);
+	free(touched);
+	free(remap);
+	return nt;
+}
+
+static double pointTriDistSq(const float *p, const float *a, const float *b, const float *c)
+{
+	// closest point on triangle, from Ericson's Real-Time Collision Detection
+	double ab[3], ac[3], ap[3], bp[3], cp[3], r[3];
+	for (int k = 0; k < 3; k++) {
+		ab[k] = b[k] - a[k];
+		ac[k] = c[k] - a[k];
+		ap[k] = p[k] - a[k];
+		bp[k] = p[k] - b[k];
+		cp[k] = p[k] - c[k];
+	}
+#define DOT(u, v) (u[0] * v[0] + u[1] * v[1] + u[2] * v[2])
+	double d1 = DOT(ab, ap), d2 = DOT(ac, ap);
+	double d3 = DOT(ab, bp), d4 = DOT(ac, bp);
+	double d5 = DOT(ab, cp), d6 = DOT(ac, cp);
+#undef DOT
+	double va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+	double v, w;
+
+	if (d1 <= 0 && d2 <= 0) { v = 0; w = 0; }
+	else if (d3 >= 0 && d4 <= d3) { v = 1; w = 0; }
+	else if (d6 >= 0 && d5 <= d6) { v = 0; w = 1; }
+	else if (vc <= 0 && d1 >= 0 && d3 <= 0) { v = d1 / (d1 - d3); w = 0; }
+	else if (vb <= 0 && d2 >= 0 && d6 <= 0) { v = 0; w = d2 / (d2 - d6); }
+	else if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+		w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		v = 1 - w;
+	} else {
+		double denom = 1 / (va + vb + vc);
+		v = vb * denom;
+		w = vc * denom;
+	}
+
+	double dist = 0;
+	for (int k = 0; k < 3; k++) {
+		r[k] = a[k] + ab[k] * v + ac[k] * w - p[k];
+		dist += r[k] * r[k];
+	}
+	return dist;
+}
+
+/*
+ * the quadric cost over-estimates once quadrics have been merged a few
+ * times so the error stored in the file is measured - the furthest any
+ * full detail vertex is from the simplified surface
+ */
+static float measureError(const struct gboMesh *base, const unsigned short *idx,
+                          unsigned int nt)
+{
+	double worst = 0;
+	for (unsigned int i = 0; i < base->numVerts; i++) {
+		const float *p = base->verts + i * 3;
+		double best = 1e30;
+		for (unsigned int t = 0; t < nt && best > 0; t++) {
+			double d = pointTriDistSq(p, base->verts + idx[t * 3] * 3,
+			                          base->verts + idx[t * 3 + 1] * 3,
+			                          base->verts + idx[t * 3 + 2] * 3);
+			if (d < best) best = d;
+		}
+		if (best > worst) worst = best;
+	}
+	return sqrt(worst);
+}
+
+/*
+ * copies only the vertices idx references into a new lod
+ */
+static void compact(struct gboMesh *out, const struct gboMesh *src,
+                    const unsigned short *idx, unsigned int nt, float error)
+{
+	int *map = malloc(sizeof(int) * src->numVerts);
+	memset(map, -1, sizeof(int) * src->numVerts);
+
+	memset(out, 0, sizeof(struct gboMesh));
+	out->numIndices = nt * 3;
+	out->error = error;
+	out->indices = malloc(sizeof(unsigned short) * nt * 3);
+	out->verts = malloc(sizeof(float) * 3 * src->numVerts);
+	out->norms = malloc(sizeof(float) * 3 * src->numVerts);
+	out->tex = malloc(sizeof(float) * 2 * src->numVerts);
+
+	for (unsigned int i = 0; i < nt * 3; i++) {
+		unsigned int v = idx[i];
+		if (map[v] == -1) {
+			map[v] = out->numVerts;
+			memcpy(out->verts + out->numVerts * 3, src->verts + v * 3, sizeof(float) * 3);
+			memcpy(out->norms + out->numVerts * 3, src->norms + v * 3, sizeof(float) * 3);
+			memcpy(out->tex + out->numVerts * 2, src->tex + v * 2, sizeof(float) * 2);
+			out->numVerts++;
+		}
+		out->indices[i] = map[v];
+	}
+	free(map);
+}
+
+int main(int argc, char *argv[])
+{
+	int levels = 3;
+	float ratio = 0.5;
+	const char *in = 0, *out = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-l") && i + 1 < argc) levels = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r") && i + 1 < argc) ratio = atof(argv[++i]);
+		else if (!in) in = argv[i];
+		else if (!out) out = argv[i];
+	}
+	if (!in || !out || ratio <= 0 || ratio >= 1) {
+		printf("usage: gbolod [-l levels] [-r ratio] in.gbo out.gbo\n");
+		return -1;
+	}
+	if (levels > GBO_MAX_LODS - 1) levels = GBO_MAX_LODS - 1;
+
+	struct gboFile src, dst;
+	if (!gboRead(&src, in)) return -2;
+
+	memset(&dst, 0, sizeof(dst));
+	memcpy(dst.bounds, src.bounds, sizeof(dst.bounds));
+
+	// lod 0 is the full mesh, welded if it came from a version 'a' file
+	if (src.lod[0].numIndices == 0) {
+		if (!gboWeld(&dst.lod[0], &src.lod[0])) return -3;
+	} else {
+		dst.lod[0] = src.lod[0];
+		memset(&src.lod[0], 0, sizeof(struct gboMesh));
+	}
+	dst.numLods = 1;
+
+	struct gboMesh *base = &dst.lod[0];
+	unsigned int nt = base->numIndices / 3;
+	unsigned short *idx = malloc(sizeof(unsigned short) * base->numIndices);
+	memcpy(idx, base->indices, sizeof(unsigned short) * base->numIndices);
+
+	struct simplifier s;
+	initSimplifier(&s, base);
+
+	printf("%s lod 0: %u verts %u tris\n", in, base->numVerts, nt);
+	for (int l = 1; l <= levels; l++) {
+		unsigned int target = nt * ratio;
+		unsigned int got = simplify(&s, idx, nt, target);
+		if (got > nt * 0.9f) {
+			printf("lod %i: can't get below %u tris, stopping\n", l, got);
+			break;
+		}
+		nt = got;
+		compact(&dst.lod[l], base, idx, nt, measureError(base, idx, nt));
+		dst.numLods++;
+		printf("lod %i: %u verts %u tris error %f\n", l, dst.lod[l].numVerts, nt,
+		       dst.lod[l].error);
+	}
+
+	freeSimplifier(&s);
+	free(idx);
+
+	int ok = gboWrite(&dst, out);
+	gboFree(&dst);
+	gboFree(&src);
+	return ok ? 0 : -4;
+}
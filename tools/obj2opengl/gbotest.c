@@ -1,49 +1,49 @@
 /*
-gcc -std=gnu99 gbotest.c -o gbotest
+gcc -std=gnu99 gbotest.c gbo.c -o gbotest -lm
 */
 
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "gbo.h"
+
 int main (int argc, char *argv[])
 {
 	if (argc!=2) {
 		printf("please specify a GBO file\n");
 		return -1;
 	}
-	FILE *pFile;
-	pFile = fopen( argv[1], "rb" );
-
-	unsigned int magic;
-	int NumVerts;
-	fread (&magic,1, sizeof(unsigned int), pFile );
-	if (magic!=0x614f4247) {
-		printf("Does not appear to be a version 'a' GBO file\n");
+
+	struct gboFile gbo;
+	if (!gboRead(&gbo, argv[1]))
 		return -2;
+
+	printf("Obj has %u lod(s) bounding sphere %f %f %f radius %f\n", gbo.numLods,
+	       gbo.bounds[0], gbo.bounds[1], gbo.bounds[2], gbo.bounds[3]);
+
+	for (unsigned int l = 0; l < gbo.numLods; l++) {
+		struct gboMesh *m = &gbo.lod[l];
+		printf("\nlod %u contains %u verts %u indices error %f\n", l,
+		       m->numVerts, m->numIndices, m->error);
+
+		for (unsigned int i=0; i< m->numVerts*3; i=i+3)
+			printf("%f\t%f\t%f\n",m->verts[i],m->verts[i+1],m->verts[i+2]);
+
+		printf("\nNormals\n");
+		for (unsigned int i=0; i< m->numVerts*3; i=i+3)
+			printf("%f\t%f\t%f\n",m->norms[i],m->norms[i+1],m->norms[i+2]);
+
+		printf("\nTexture coordinates\n");
+		for (unsigned int i=0; i< m->numVerts*2; i=i+2)
+			printf("%f\t%f\n",m->tex[i],m->tex[i+1]);
+
+		if (m->numIndices) {
+			printf("\nIndices\n");
+			for (unsigned int i=0; i< m->numIndices; i=i+3)
+				printf("%u\t%u\t%u\n",m->indices[i],m->indices[i+1],m->indices[i+2]);
+		}
 	}
-	fread(&NumVerts,1,sizeof(unsigned int), pFile );
-	printf("Obj contains %i verts\n",NumVerts);
-	
-	float* Verts = malloc(sizeof(float) * 3 * NumVerts);
-	fread(Verts,1,sizeof(float) * 3 * NumVerts, pFile );
-	for (int i=0; i< NumVerts*3; i=i+3) 
-		printf("%f\t%f\t%f\n",Verts[i],Verts[i+1],Verts[i+2]);
-	free(Verts);
-	
-	printf("\nNormals\n");
-	float* Norms = malloc(sizeof(float) * 3 * NumVerts);
-	fread(Norms,1,sizeof(float) * 3 * NumVerts, pFile );
-	for (int i=0; i< NumVerts*3; i=i+3) 
-		printf("%f\t%f\t%f\n",Norms[i],Norms[i+1],Norms[i+2]);
-	free(Norms);
-	
-	printf("\nTexture coordinates\n");
-	float* TexCoords = malloc(sizeof(float) * 2 * NumVerts);
-	fread(TexCoords,1,sizeof(float) * 2 * NumVerts, pFile );
-	for (int i=0; i< NumVerts*2; i=i+2) 
-		printf("%f\t%f\n",TexCoords[i],TexCoords[i+1]);
-	free(TexCoords);
-	
-	
+
+	gboFree(&gbo);
 	return 0;
 }
@@ -0,0 +1,210 @@
+/*
+ * gbovcache - reorders a GBO for the GPU's post transform vertex cache
+ *
+ * triangles are reordered with Tipsify (Sander, Nehab & Barczak 2007)
+ * then vertices are renumbered in the order the triangles first use them
+ * so the vertex fetches walk through memory, each lod is done on its own
+ *
+ * gbovcache [-c cachesize] [-n] in.gbo out.gbo
+ *
+ * ACMR (average cache miss ratio - vertices transformed per triangle,
+ * 0.5 is ideal 3 is the worst) is reported before and after using a
+ * FIFO cache of cachesize (default 16) entries, -n only reports
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gbo.h"
+
+static float acmr(const unsigned short *idx, unsigned int ni, unsigned int nv, int cacheSize)
+{
+	// FIFO cache, a vertex is in the cache if it was pushed in the
+	// last cacheSize misses
+	unsigned int *stamp = calloc(nv, sizeof(unsigned int));
+	unsigned int misses = 0;
+
+	for (unsigned int i = 0; i < ni; i++) {
+		unsigned int v = idx[i];
+		if (stamp[v] == 0 || misses - stamp[v] >= (unsigned int)cacheSize) {
+			misses++;
+			stamp[v] = misses;
+		}
+	}
+	free(stamp);
+	return ni ? (float)misses / (ni / 3) : 0;
+}
+
+/*
+ * Tipsify, fans round the most recently used vertex that will still
+ * be in the cache after its remaining triangles are emitted
+ */
+static void tipsify(unsigned short *out, const unsigned short *idx,
+                    unsigned int ni, unsigned int nv, int k)
+{
+	unsigned int nt = ni / 3;
+	unsigned int *offset = calloc(nv + 1, sizeof(unsigned int));
+	unsigned int *adj = malloc(sizeof(unsigned int) * ni);
+	int *live = calloc(nv, sizeof(int));
+	int *cacheTime = calloc(nv, sizeof(int));
+	unsigned int *deadEnd = malloc(sizeof(unsigned int) * ni);
+	unsigned char *emitted = calloc(nt, 1);
+	unsigned int candidates[64 * 3];
+	unsigned int nd = 0, no = 0, cursor = 0;
+	int time = k + 1;
+	int fan = 0;
+
+	// vertex -> triangle adjacency
+	for (unsigned int i = 0; i < ni; i++) live[idx[i]]++;
+	for (unsigned int v = 0; v < nv; v++) offset[v + 1] = offset[v] + live[v];
+	for (unsigned int t = 0; t < nt; t++)
+		for (int j = 0; j < 3; j++) {
+			unsigned int v = idx[t * 3 + j];
+			adj[offset[v + 1] - live[v]] = t;
+			live[v]--;
+		}
+	for (unsigned int i = 0; i < ni; i++) live[idx[i]]++;
+
+	if (!nv) fan = -1;
+	while (fan >= 0) {
+		unsigned int nc = 0;
+
+		for (unsigned int a = offset[fan]; a < offset[fan + 1]; a++) {
+			unsigned int t = adj[a];
+			if (emitted[t]) continue;
+			for (int j = 0; j < 3; j++) {
+				unsigned int v = idx[t * 3 + j];
+				out[no++] = v;
+				deadEnd[nd++] = v;
+				if (nc < sizeof(candidates) / sizeof(candidates[0]))
+					candidates[nc++] = v;
+				live[v]--;
+				if (time - cacheTime[v] > k) cacheTime[v] = time++;
+			}
+			emitted[t] = 1;
+		}
+
+		// best candidate is the one that stays in cache longest
+		int best = -1, bestScore = -1;
+		for (unsigned int c = 0; c < nc; c++) {
+			unsigned int v = candidates[c];
+			if (live[v] <= 0) continue;
+			int score = 0;
+			if (time - cacheTime[v] + 2 * live[v] <= k) score = time - cacheTime[v];
+			if (score > bestScore) {
+				bestScore = score;
+				best = v;
+			}
+		}
+
+		// dead end, back track through recent vertices then just scan
+		while (best == -1 && nd) {
+			unsigned int v = deadEnd[--nd];
+			if (live[v] > 0) best = v;
+		}
+		while (best == -1 && cursor < nv) {
+			if (live[cursor] > 0) best = cursor;
+			cursor++;
+		}
+		fan = best;
+	}
+
+	free(emitted);
+	free(deadEnd);
+	free(cacheTime);
+	free(live);
+	free(adj);
+	free(offset);
+}
+
+/*
+ * renumbers vertices in order of first use and shuffles their data to match
+ */
+static void fetchOrder(struct gboMesh *m)
+{
+	int *map = malloc(sizeof(int) * m->numVerts);
+	float *verts = malloc(sizeof(float) * 3 * m->numVerts);
+	float *norms = malloc(sizeof(float) * 3 * m->numVerts);
+	float *tex = malloc(sizeof(float) * 2 * m->numVerts);
+	unsigned int next = 0;
+
+	memset(map, -1, sizeof(int) * m->numVerts);
+	for (unsigned int i = 0; i < m->numIndices; i++) {
+		unsigned int v = m->indices[i];
+		if (map[v] == -1) {
+			map[v] = next;
+			memcpy(verts + next * 3, m->verts + v * 3, sizeof(float) * 3);
+			memcpy(norms + next * 3, m->norms + v * 3, sizeof(float) * 3);
+			memcpy(tex + next * 2, m->tex + v * 2, sizeof(float) * 2);
+			next++;
+		}
+		m->indices[i] = map[v];
+	}
+
+	// anything never referenced is dropped
+	free(m->verts);
+	free(m->norms);
+	free(m->tex);
+	m->verts = verts;
+	m->norms = norms;
+	m->tex = tex;
+	m->numVerts = next;
+	free(map);
+}
+
+int main(int argc, char *argv[])
+{
+	int cacheSize = 16, reportOnly = 0;
+	const char *in = 0, *out = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-c") && i + 1 < argc) cacheSize = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-n")) reportOnly = 1;
+		else if (!in) in = argv[i];
+		else if (!out) out = argv[i];
+	}
+	if (!in || (!out && !reportOnly) || cacheSize < 3) {
+		printf("usage: gbovcache [-c cachesize] [-n] in.gbo out.gbo\n");
+		return -1;
+	}
+
+	struct gboFile gbo;
+	if (!gboRead(&gbo, in)) return -2;
+
+	// a version 'a' file is welded first, drawn un-indexed it was
+	// transforming every corner (ACMR 3)
+	if (gbo.lod[0].numIndices == 0) {
+		struct gboMesh welded;
+		printf("%s lod 0: un-indexed, ACMR 3.000 before welding\n", in);
+		if (!gboWeld(&welded, &gbo.lod[0])) {
+			// obj2gbo leaves big models as version 'a' on purpose,
+			// there's nothing to reorder so pass it through as it is
+			printf("%s lod 0: left un-indexed, ACMR 3.000\n", in);
+			int ok = reportOnly || !strcmp(in, out) || gboWrite(&gbo, out);
+			gboFree(&gbo);
+			return ok ? 0 : -4;
+		}
+		gboFreeMesh(&gbo.lod[0]);
+		gbo.lod[0] = welded;
+	}
+
+	for (unsigned int l = 0; l < gbo.numLods; l++) {
+		struct gboMesh *m = &gbo.lod[l];
+		float before = acmr(m->indices, m->numIndices, m->numVerts, cacheSize);
+
+		unsigned short *sorted = malloc(sizeof(unsigned short) * m->numIndices);
+		tipsify(sorted, m->indices, m->numIndices, m->numVerts, cacheSize);
+		free(m->indices);
+		m->indices = sorted;
+		fetchOrder(m);
+
+		float after = acmr(m->indices, m->numIndices, m->numVerts, cacheSize);
+		printf("%s lod %u: %u tris ACMR %.3f -> %.3f (cache %i)\n", in, l,
+		       m->numIndices / 3, before, after, cacheSize);
+	}
+
+	int ok = reportOnly || gboWrite(&gbo, out);
+	gboFree(&gbo);
+	return ok ? 0 : -4;
+}
@@ -1,6 +1,17 @@
 #!/bin/sh
 
-./obj2opengl.pl -noverbose -noScale -noMove -o OBJ.h $1.obj
-gcc builder.c -o builder
-./builder $1.gbo
+# stop at the first tool that fails
+set -e
 
+make -s obj2gbo
+./obj2gbo $1.obj
+
+# optionally add levels of detail, eg ./makeGBO.sh alien 3
+if [ -n "$2" ]; then
+	make -s gbolod
+	./gbolod -l $2 $1.gbo $1.gbo
+fi
+
+# reorder every lod for the vertex cache, this also indexes a plain GBO
+make -s gbovcache
+./gbovcache $1.gbo $1.gbo
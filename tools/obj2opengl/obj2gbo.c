@@ -0,0 +1,358 @@
+/*
+ * obj2gbo - compiles wavefront OBJ files straight to GBO
+ *
+ * obj2gbo [-j threads] [-o out.gbo] file.obj [file.obj ...]
+ *
+ * each file.obj is written to file.gbo (or -o when there is only one file)
+ * files are shared between threads (default one per cpu) so a batch of
+ * models compiles in parallel, each file is read in a single streaming
+ * pass a line at a time
+ *
+ * faces may be triangles, quads or any convex polygon (fanned into
+ * triangles) and indices may be negative (relative to the end of the list
+ * so far), missing texture coordinates are 0,0 and missing normals are
+ * the face normal
+ *
+ * like obj2opengl.pl -noScale -noMove texture v is flipped (1-v) and
+ * normals are normalised, the corners are welded into an indexed version
+ * 'b' GBO - unless there are more than 65536 unique vertices in which case
+ * its written as a version 'a' triangle soup
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <tinycthread.h>
+
+#include "gbo.h"
+
+struct floats {
+	float *data;
+	unsigned int count, size;	// count is in elements of size floats
+	unsigned int cap;
+};
+
+struct corner {
+	int v, t, n;
+};
+
+struct objData {
+	struct floats pos, tex, norm;
+	struct floats faceNorm;		// for faces without normals
+	struct corner *corners;		// 3 per triangle
+	unsigned int numCorners, capCorners;
+};
+
+static float *pushFloats(struct floats *a)
+{
+	if (a->count == a->cap) {
+		a->cap = a->cap ? a->cap * 2 : 1024;
+		a->data = realloc(a->data, sizeof(float) * a->size * a->cap);
+	}
+	return a->data + a->size * a->count++;
+}
+
+static void pushCorner(struct objData *o, struct corner c)
+{
+	if (o->numCorners == o->capCorners) {
+		o->capCorners = o->capCorners ? o->capCorners * 2 : 3072;
+		o->corners = realloc(o->corners, sizeof(struct corner) * o->capCorners);
+	}
+	o->corners[o->numCorners++] = c;
+}
+
+static void freeObjData(struct objData *o)
+{
+	free(o->pos.data);
+	free(o->tex.data);
+	free(o->norm.data);
+	free(o->faceNorm.data);
+	free(o->corners);
+}
+
+// 1 based or negative (relative) index to 0 based, -1 if missing or bad
+static int resolve(const char *s, char **end, unsigned int count)
+{
+	long i = strtol(s, end, 10);
+	if (*end == s) return -1;
+	if (i < 0) i += count;
+	else i--;
+	if (i < 0 || i >= (long)count) return -2;
+	return i;
+}
+
+// parses "v", "v/t", "v//n" or "v/t/n"
+static int parseCorner(struct objData *o, char **s, struct corner *c)
+{
+	char *p = *s, *end;
+
+	c->t = c->n = -1;
+	c->v = resolve(p, &end, o->pos.count);
+	if (c->v < 0) return 0;
+	p = end;
+	if (*p == '/') {
+		p++;
+		if (*p != '/') {
+			c->t = resolve(p, &end, o->tex.count);
+			if (c->t == -2) return 0;
+			p = end;
+		}
+		if (*p == '/') {
+			p++;
+			c->n = resolve(p, &end, o->norm.count);
+			if (c->n == -2) return 0;
+			p = end;
+		}
+	}
+	*s = p;
+	return 1;
+}
+
+static void faceNormal(struct objData *o, struct corner *a, struct corner *b, struct corner *c)
+{
+	const float *p0 = o->pos.data + a->v * 3;
+	const float *p1 = o->pos.data + b->v * 3;
+	const float *p2 = o->pos.data + c->v * 3;
+	double e1[3], e2[3], n[3], d;
+
+	for (int i = 0; i < 3; i++) {
+		e1[i] = p1[i] - p0[i];
+		e2[i] = p2[i] - p0[i];
+	}
+	n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	d = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+	float *f = pushFloats(&o->faceNorm);
+	if (d == 0) {
+		f[0] = 1;
+		f[1] = f[2] = 0;
+	} else {
+		for (int i = 0; i < 3; i++) f[i] = n[i] / d;
+	}
+}
+
+static int parseFace(struct objData *o, char *p)
+{
+	struct corner first, prev, c;
+	int num = 0, faceN = 0;
+
+	for (;;) {
+		while (*p == ' ' || *p == '\t') p++;
+		if (*p == 0 || *p == '\n' || *p == '\r' || *p == '#') break;
+		if (!parseCorner(o, &p, &c)) return 0;
+		if (num == 0) first = c;
+		else if (num >= 2) {
+			struct corner tri[3] = { first, prev, c };
+			// missing normals get the face normal, a negative index
+			// into faceNorm so they don't weld with other faces
+			if (first.n < 0 || prev.n < 0 || c.n < 0) {
+				if (!faceN) {
+					faceNormal(o, &tri[0], &tri[1], &tri[2]);
+					faceN = -2 - (int)(o->faceNorm.count - 1);
+				}
+				for (int i = 0; i < 3; i++)
+					if (tri[i].n < 0) tri[i].n = faceN;
+			}
+			for (int i = 0; i < 3; i++) pushCorner(o, tri[i]);
+		}
+		prev = c;
+		num++;
+	}
+	return num >= 3;
+}
+
+/*
+ * one pass through the file, only positions, texture coordinates, normals
+ * and faces are used - groups, materials and so on are ignored
+ */
+static int parseObj(struct objData *o, const char *filename)
+{
+	FILE *f = fopen(filename, "r");
+	char *line = 0;
+	size_t lineSize = 0;
+	unsigned int lineNum = 0;
+
+	memset(o, 0, sizeof(struct objData));
+	o->pos.size = o->norm.size = o->faceNorm.size = 3;
+	o->tex.size = 2;
+	if (!f) {
+		printf("Cant open %s\n", filename);
+		return 0;
+	}
+
+	while (getline(&line, &lineSize, f) != -1) {
+		char *p = line, *end;
+		lineNum++;
+		while (*p == ' ' || *p == '\t') p++;
+
+		if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+			float *v = pushFloats(&o->pos);
+			p++;
+			for (int i = 0; i < 3; i++) {
+				v[i] = strtof(p, &end);
+				p = end;
+			}
+		} else if (p[0] == 'v' && p[1] == 't') {
+			float *t = pushFloats(&o->tex);
+			p += 2;
+			t[0] = strtof(p, &end);
+			t[1] = 1.0 - strtod(end, &end);
+		} else if (p[0] == 'v' && p[1] == 'n') {
+			float *n = pushFloats(&o->norm);
+			double d[3], l;
+			p += 2;
+			for (int i = 0; i < 3; i++) {
+				d[i] = strtod(p, &end);
+				p = end;
+			}
+			l = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+			if (l == 0) {
+				n[0] = 1;
+				n[1] = n[2] = 0;
+			} else {
+				for (int i = 0; i < 3; i++) n[i] = d[i] / l;
+			}
+		} else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+			if (!parseFace(o, p + 1)) {
+				printf("%s:%u bad face\n", filename, lineNum);
+				free(line);
+				fclose(f);
+				freeObjData(o);
+				return 0;
+			}
+		}
+	}
+
+	free(line);
+	fclose(f);
+	return 1;
+}
+
+static void cornerData(struct objData *o, const struct corner *c, float *v, float *n, float *t)
+{
+	memcpy(v, o->pos.data + c->v * 3, sizeof(float) * 3);
+	if (c->n >= 0) memcpy(n, o->norm.data + c->n * 3, sizeof(float) * 3);
+	else memcpy(n, o->faceNorm.data + (-2 - c->n) * 3, sizeof(float) * 3);
+	if (c->t >= 0) memcpy(t, o->tex.data + c->t * 2, sizeof(float) * 2);
+	else t[0] = t[1] = 0;
+}
+
+/*
+ * welds corners with the same position, normal and texture coordinate (the
+ * values, as gboWeld does for the perl output, OBJ files often give every
+ * corner its own normal index), if there are too many for 16 bit indices
+ * the mesh is left as a soup
+ */
+static void buildMesh(struct gboMesh *m, struct objData *o)
+{
+	unsigned int n = o->numCorners;
+	struct gboMesh soup;
+
+	memset(&soup, 0, sizeof(struct gboMesh));
+	soup.numVerts = n;
+	soup.verts = malloc(sizeof(float) * 3 * (n ? n : 1));
+	soup.norms = malloc(sizeof(float) * 3 * (n ? n : 1));
+	soup.tex = malloc(sizeof(float) * 2 * (n ? n : 1));
+	for (unsigned int i = 0; i < n; i++)
+		cornerData(o, &o->corners[i], soup.verts + i * 3, soup.norms + i * 3, soup.tex + i * 2);
+
+	if (gboWeld(m, &soup)) gboFreeMesh(&soup);
+	else *m = soup;
+}
+
+static int compile(const char *in, const char *out)
+{
+	struct objData o;
+	struct gboFile gbo;
+
+	if (!parseObj(&o, in)) return 0;
+
+	memset(&gbo, 0, sizeof(gbo));
+	gbo.numLods = 1;
+	buildMesh(&gbo.lod[0], &o);
+	freeObjData(&o);
+	gboBounds(&gbo);
+
+	int ok = gboWrite(&gbo, out);
+	if (ok) printf("%s -> %s %u tris %u verts%s\n", in, out,
+		               (gbo.lod[0].numIndices ? gbo.lod[0].numIndices : gbo.lod[0].numVerts) / 3,
+		               gbo.lod[0].numVerts, gbo.lod[0].numIndices ? "" : " (not indexed)");
+	gboFree(&gbo);
+	return ok;
+}
+
+// batch of files shared between the worker threads
+struct {
+	mtx_t lock;
+	char **files;
+	int numFiles, next, failed;
+	const char *out;
+} __batch;
+
+static int worker(void *arg)
+{
+	char out[4096];
+
+	for (;;) {
+		mtx_lock(&__batch.lock);
+		int i = __batch.next++;
+		mtx_unlock(&__batch.lock);
+		if (i >= __batch.numFiles) break;
+
+		const char *in = __batch.files[i];
+		if (__batch.out) {
+			snprintf(out, sizeof(out), "%s", __batch.out);
+		} else {
+			const char *dot = strrchr(in, '.');
+			int len = (dot && !strchr(dot, '/')) ? dot - in : (int)strlen(in);
+			snprintf(out, sizeof(out), "%.*s.gbo", len, in);
+		}
+
+		if (!compile(in, out)) {
+			mtx_lock(&__batch.lock);
+			__batch.failed++;
+			mtx_unlock(&__batch.lock);
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int first = argc;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc) threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc) __batch.out = argv[++i];
+		else {
+			first = i;
+			break;
+		}
+	}
+	__batch.files = argv + first;
+	__batch.numFiles = argc - first;
+	if (!__batch.numFiles || (__batch.out && __batch.numFiles != 1)) {
+		printf("usage: obj2gbo [-j threads] [-o out.gbo] file.obj [file.obj ...]\n");
+		return -1;
+	}
+	if (threads < 1) threads = 1;
+	if (threads > __batch.numFiles) threads = __batch.numFiles;
+
+	mtx_init(&__batch.lock, mtx_plain);
+
+	// the main thread is one of the workers
+	thrd_t *t = malloc(sizeof(thrd_t) * threads);
+	for (int i = 1; i < threads; i++) thrd_create(&t[i], worker, NULL);
+	worker(NULL);
+	for (int i = 1; i < threads; i++) thrd_join(t[i], NULL);
+	free(t);
+
+	mtx_destroy(&__batch.lock);
+	return __batch.failed ? -2 : 0;
+}